@@ -13,13 +13,11 @@
  *  LCD SPI Channel: MAY CHANGE
  */
 
+#include <string.h>
 #include "userconf.h"
 #include "timeb.h"
 #include "lcd_5110.h"
-
-//file scope variables
-static uint8_t LCD_x;
-static uint8_t LCD_y;
+#include "lcd_5110_font.h"
 
 #ifndef LCD_SPI_Handler
 assert("LCD_SPI_Handler is not declared. Declare it in userconf.h")
@@ -56,221 +54,648 @@ assert("LCD_SPI_Handler is not declared. Declare it in userconf.h")
 #define LCD_X_MAX_CHUNK                         83  //0-83
 #define LCD_Y_MAX_CHUNK                         5   //0-5
 
-#define LCD_WIDTH_IN_CHUNK                      84
-#define LCD_HEIGHT_IN_CHUNK                     6
+//default LCD instance
+LCD_HandleTypeDef hlcd1 = LCD_HANDLE_INIT(&LCD_SPI_Handler, LCD_DC_GPIO_Port, LCD_DC_Pin,
+                                          LCD_RESET_GPIO_Port, LCD_RESET_Pin, 0, 0);
 
+#ifdef LCD_USE_DMA
+//handles which may have a DMA chain in flight, looked up by LCD_SPI_TxCpltCallback
+static LCD_HandleTypeDef *dma_handles[LCD_MAX_INSTANCES];
+#endif
 
-#define LCD_BUFFER_SIZE                        504 // == 84*48/8
+#ifdef LCD_USE_PROFILING
+LCD_Profile lcd_profile;
+#endif
 
+//panel takes no commands during reset steps of LCDx_Init_async, updates wait and leave buffer dirty
+#define LCD_PANEL_IN_RESET(hlcd)                ((hlcd)->init_state > LCD_INIT_FIRST_FRAME)
 
-//Buffer & LCD Curser
-//changed area of buffer in pixel
-static uint8_t changed_buffer_x_low  = 0;
-static uint8_t changed_buffer_y_low  = 0;
-static uint8_t changed_buffer_x_high = 0;
-static uint8_t changed_buffer_y_high = 0;
+//a new address jump costs LCD_SET_X_ADDRESS + LCD_SET_Y_ADDRESS command bytes, unchanged gaps up to this size are resent instead
+#define LCD_ADDRESS_JUMP_COST                   2
 
-// this amount is for initial clearing of lcd
-static uint16_t start_in_line_update  = 0;
-static uint16_t end_in_line_update    = 0;
-static uint16_t cursor_in_line_update = 0;
+#ifdef LCD_USE_DMA
+#ifdef LCD_USE_SHADOW_BUFFER
+//shadow buffer already holds exactly what is being sent, so it serves as the snapshot
+#define dma_snapshot shadow_buffer
+#endif
+#endif
 
-//courser current position in LCD in Chunks(not pixels)
-static uint8_t cursor_x = 0;
-static uint8_t cursor_y = 0;
+//reader of a compressed image, yields decompressed chunks in image order (row by row)
+typedef struct {
+    uint8_t  *image;
+    uint32_t length;          //size of compressed image in bytes, reading stops there
+    uint32_t index;           //next byte of compressed image
+    uint16_t width;
+    uint16_t height;
+    uint8_t  blank_chunk_color;
+    uint16_t non_blank_left;  //non-blank chunks left in current fragment
+    uint16_t blank_left;      //blank chunks left in current fragment
+    uint32_t chunks_left;     //chunks left in whole image
+    uint8_t  blank_count_next;//blank count follows non-blank chunks of a fragment
+    uint8_t  fragment_empty;  //current fragment had no non-blank chunks
+    uint8_t  ended;           //no more data - rest of image is read as blank
+    uint8_t  error;           //image is truncated or malformed
+} _ImageStream;
 
-static struct _Flag {
-    uint8_t in_line_changed : 1;
-    uint8_t area_changed : 1;
-    
-} buffer_flag                     = {0, 0};//flags are used to update lcd and in its special format show in which format
+//bounding box of a region in chunks
+typedef struct {
+    uint8_t x_low;
+    uint8_t x_high;//one past last column
+    uint8_t bank_low;
+    uint8_t bank_high;
+} _Box;
+
+#define LCD_GLYPH_BYTES(c0, c1, c2, c3, c4) {c0, c1, c2, c3, c4},
 
-//Display Buffer
-static uint8_t buffer[LCD_BUFFER_SIZE];
 //Fonts 5x7
-const uint8_t  font_en_8x5[95][5] = {
-        {0x00, 0x00, 0x00, 0x00, 0x00},
-        {0x00, 0x00, 0x2f, 0x00, 0x00},
-        {0x00, 0x07, 0x00, 0x07, 0x00},
-        {0x14, 0x7f, 0x14, 0x7f, 0x14},
-        {0x24, 0x2a, 0x7f, 0x2a, 0x12},
-        {0x32, 0x34, 0x08, 0x16, 0x26},
-        {0x36, 0x49, 0x55, 0x22, 0x50},
-        {0x00, 0x05, 0x03, 0x00, 0x00},
-        {0x00, 0x1c, 0x22, 0x41, 0x00},
-        {0x00, 0x41, 0x22, 0x1c, 0x00},
-        {0x14, 0x08, 0x3E, 0x08, 0x14},
-        {0x08, 0x08, 0x3E, 0x08, 0x08},
-        {0x00, 0x00, 0x50, 0x30, 0x00},
-        {0x10, 0x10, 0x10, 0x10, 0x10},
-        {0x00, 0x60, 0x60, 0x00, 0x00},
-        {0x20, 0x10, 0x08, 0x04, 0x02},
-        {0x3E, 0x51, 0x49, 0x45, 0x3E},
-        {0x00, 0x42, 0x7F, 0x40, 0x00},
-        {0x42, 0x61, 0x51, 0x49, 0x46},
-        {0x21, 0x41, 0x45, 0x4B, 0x31},
-        {0x18, 0x14, 0x12, 0x7F, 0x10},
-        {0x27, 0x45, 0x45, 0x45, 0x39},
-        {0x3C, 0x4A, 0x49, 0x49, 0x30},
-        {0x01, 0x71, 0x09, 0x05, 0x03},
-        {0x36, 0x49, 0x49, 0x49, 0x36},
-        {0x06, 0x49, 0x49, 0x29, 0x1E},
-        {0x00, 0x36, 0x36, 0x00, 0x00},
-        {0x00, 0x56, 0x36, 0x00, 0x00},
-        {0x08, 0x14, 0x22, 0x41, 0x00},
-        {0x14, 0x14, 0x14, 0x14, 0x14},
-        {0x00, 0x41, 0x22, 0x14, 0x08},
-        {0x02, 0x01, 0x51, 0x09, 0x06},
-        {0x32, 0x49, 0x59, 0x51, 0x3E},
-        {0x7E, 0x11, 0x11, 0x11, 0x7E},
-        {0x7F, 0x49, 0x49, 0x49, 0x36},
-        {0x3E, 0x41, 0x41, 0x41, 0x22},
-        {0x7F, 0x41, 0x41, 0x22, 0x1C},
-        {0x7F, 0x49, 0x49, 0x49, 0x41},
-        {0x7F, 0x09, 0x09, 0x09, 0x01},
-        {0x3E, 0x41, 0x49, 0x49, 0x7A},
-        {0x7F, 0x08, 0x08, 0x08, 0x7F},
-        {0x00, 0x41, 0x7F, 0x41, 0x00},
-        {0x20, 0x40, 0x41, 0x3F, 0x01},
-        {0x7F, 0x08, 0x14, 0x22, 0x41},
-        {0x7F, 0x40, 0x40, 0x40, 0x40},
-        {0x7F, 0x02, 0x0C, 0x02, 0x7F},
-        {0x7F, 0x04, 0x08, 0x10, 0x7F},
-        {0x3E, 0x41, 0x41, 0x41, 0x3E},
-        {0x7F, 0x09, 0x09, 0x09, 0x06},
-        {0x3E, 0x41, 0x51, 0x21, 0x5E},
-        {0x7F, 0x09, 0x19, 0x29, 0x46},
-        {0x46, 0x49, 0x49, 0x49, 0x31},
-        {0x01, 0x01, 0x7F, 0x01, 0x01},
-        {0x3F, 0x40, 0x40, 0x40, 0x3F},
-        {0x1F, 0x20, 0x40, 0x20, 0x1F},
-        {0x3F, 0x40, 0x38, 0x40, 0x3F},
-        {0x63, 0x14, 0x08, 0x14, 0x63},
-        {0x07, 0x08, 0x70, 0x08, 0x07},
-        {0x61, 0x51, 0x49, 0x45, 0x43},
-        {0x00, 0x7F, 0x41, 0x41, 0x00},
-        {0x55, 0x2A, 0x55, 0x2A, 0x55},
-        {0x00, 0x41, 0x41, 0x7F, 0x00},
-        {0x04, 0x02, 0x01, 0x02, 0x04},
-        {0x40, 0x40, 0x40, 0x40, 0x40},
-        {0x00, 0x01, 0x02, 0x04, 0x00},
-        {0x20, 0x54, 0x54, 0x54, 0x78},
-        {0x7F, 0x48, 0x44, 0x44, 0x38},
-        {0x38, 0x44, 0x44, 0x44, 0x20},
-        {0x38, 0x44, 0x44, 0x48, 0x7F},
-        {0x38, 0x54, 0x54, 0x54, 0x18},
-        {0x08, 0x7E, 0x09, 0x01, 0x02},
-        {0x0C, 0x52, 0x52, 0x52, 0x3E},
-        {0x7F, 0x08, 0x04, 0x04, 0x78},
-        {0x00, 0x44, 0x7D, 0x40, 0x00},
-        {0x20, 0x40, 0x44, 0x3D, 0x00},
-        {0x7F, 0x10, 0x28, 0x44, 0x00},
-        {0x00, 0x41, 0x7F, 0x40, 0x00},
-        {0x7C, 0x04, 0x18, 0x04, 0x78},
-        {0x7C, 0x08, 0x04, 0x04, 0x78},
-        {0x38, 0x44, 0x44, 0x44, 0x38},
-        {0x7C, 0x14, 0x14, 0x14, 0x08},
-        {0x08, 0x14, 0x14, 0x18, 0x7C},
-        {0x7C, 0x08, 0x04, 0x04, 0x08},
-        {0x48, 0x54, 0x54, 0x54, 0x20},
-        {0x04, 0x3F, 0x44, 0x40, 0x20},
-        {0x3C, 0x40, 0x40, 0x20, 0x7C},
-        {0x1C, 0x20, 0x40, 0x20, 0x1C},
-        {0x3C, 0x40, 0x30, 0x40, 0x3C},
-        {0x44, 0x28, 0x10, 0x28, 0x44},
-        {0x0C, 0x50, 0x50, 0x50, 0x3C},
-        {0x44, 0x64, 0x54, 0x4C, 0x44},
-        {0x00, 0x08, 0x36, 0x41, 0x00},
-        {0x00, 0x00, 0x7F, 0x00, 0x00},
-        {0x00, 0x41, 0x36, 0x08, 0x00},
-        {0x10, 0x08, 0x08, 0x10, 0x08}
+const uint8_t  font_en_8x5[LCD_FONT_GLYPH_COUNT][5] = {
+        LCD_FONT_EN_8X5(LCD_GLYPH_BYTES)
 };
 
 //private in-lib functions
 
 /**
-  * @brief Send single data byte
+ * @brief the only path to SPI - sets DC pin and transmits bytes in one blocking transaction
+ * @param hlcd LCD handle
+ * @param is_data 1 for data bytes, 0 for command bytes
+ * @param data bytes to be sent
+ * @param length count of bytes
+ */
+void _spi_transmit(LCD_HandleTypeDef *hlcd, uint8_t is_data, uint8_t *data, uint16_t length);
+
+/**
+ * @brief wait until SPI of an LCD is free - no transfer running and, with DMA, no chain of any LCD on that bus
+ * @param hlcd LCD handle
+ * @note never call it from an interrupt above DMA priority while a chain may be running, it would wait forever
+ */
+void _wait_for_bus(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief after a failed transfer panel state is unknown - bring panel back to a known mode and resend whole frame
+ * @param hlcd LCD handle
+ */
+void _recover_bus_error(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief append a command byte to command queue - queue is flushed before next data or when it is full
+ * @param hlcd LCD handle
+ * @param command command byte to be queued
+ */
+void _queue_command(LCD_HandleTypeDef *hlcd, uint8_t command);
+
+/**
+ * @brief send all queued command bytes in one DC-low transaction
+ * @param hlcd LCD handle
+ */
+void _flush_commands(LCD_HandleTypeDef *hlcd);
+
+/**
+  * @brief Send single command byte (along with queued ones)
+  * @param hlcd LCD handle
   * @param command command byte to be send
   */
-void _send_single_command(uint8_t command);
+void _send_single_command(LCD_HandleTypeDef *hlcd, uint8_t command);
 
 /**
  * @brief Send single data byte
+ * @param hlcd LCD handle
  * @param data data byte to be sent
  */
-void _send_single_data(uint8_t data);
+void _send_single_data(LCD_HandleTypeDef *hlcd, uint8_t data);
 
 
 /**
  * @brief Send multi-byte in serie from an array
+ * @param hlcd LCD handle
  * @param data data sub-array to be sent
  * @param start_index first index of data chunk selected from array (starting byte)
  * @param end_index last index of data chunk selected from array
  */
-void _send_multi_data(uint8_t data[], size_t start_index, size_t end_index);
+void _send_multi_data(LCD_HandleTypeDef *hlcd, uint8_t data[], size_t start_index, size_t end_index);
+
+/**
+ * @brief mark a rectangle of buffer as changed
+ * @param hlcd LCD handle
+ * @param x_low first changed column (chunk)
+ * @param x_high one past last changed column (chunk)
+ * @param bank_low first changed bank
+ * @param bank_high last changed bank
+ */
+void _mark_dirty_area(LCD_HandleTypeDef *hlcd, uint8_t x_low, uint8_t x_high, uint8_t bank_low, uint8_t bank_high);
+
+/**
+ * @brief mark a run of buffer in in-line format as changed - run may cross several banks
+ * @param hlcd LCD handle
+ * @param start_index first changed byte of buffer
+ * @param end_index one past last changed byte of buffer
+ */
+void _mark_dirty_in_line(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index);
+
+#ifndef LCD_USE_PAGED_MODE
+/**
+ * @brief send a run of buffer in in-line format to the same place of LCD RAM
+ * @param hlcd LCD handle
+ * @param start_index first byte of buffer to be sent
+ * @param end_index one past last byte of buffer to be sent
+ * @note LCD auto-increments its address in horizontal mode, so a run may cross several banks
+ */
+void _send_run(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index);
+
+/**
+ * @brief send a run in horizontal mode, or just price it and grow bounding box of runs
+ * @param hlcd LCD handle
+ * @param start_index first byte of buffer in run
+ * @param end_index one past last byte of buffer in run
+ * @param send 1 to send run, 0 to measure only
+ * @param box bounding box to be grown when measuring
+ * @param cost accumulated cost in bytes
+ */
+void _take_run(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index, uint8_t send, _Box *box,
+               uint16_t *cost);
+
+/**
+ * @brief walk runs of changed buffer in horizontal mode - runs come from dirty spans or from shadow diff
+ * @param hlcd LCD handle
+ * @param send 1 to send runs, 0 to measure only
+ * @param box receives bounding box of runs when measuring
+ * @return cost of runs in bytes (address commands + data)
+ */
+uint16_t _walk_runs(LCD_HandleTypeDef *hlcd, uint8_t send, _Box *box);
+
+/**
+ * @brief send a bounding box in vertical addressing mode - one address pair plus one contiguous burst
+ * @param hlcd LCD handle
+ * @param box region to be sent
+ */
+void _send_vertical(LCD_HandleTypeDef *hlcd, _Box *box);
+
+/**
+ * @brief price changed region in both addressing modes and send it in vertical mode if it pays off
+ * @param hlcd LCD handle
+ * @return 1 if region is sent, 0 if it must be sent in horizontal mode
+ */
+uint8_t _try_vertical_update(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief send all dirty parts of buffer and mark buffer as clean
+ * @param hlcd LCD handle
+ */
+void _flush_dirty(LCD_HandleTypeDef *hlcd);
+#else
+/**
+ * @brief render every bank by draw callback into page buffer and send it
+ * @param hlcd LCD handle
+ */
+void _render_pages(LCD_HandleTypeDef *hlcd);
+#endif
+
+/**
+ * @brief read a byte of compressed image - past the end, stream goes to error state and 0 is returned
+ * @param stream image stream
+ * @return byte
+ */
+uint8_t _read_byte(_ImageStream *stream);
+
+/**
+ * @brief read a count field of compressed image - values above 127 take one more byte
+ * @param stream image stream
+ * @return count
+ * @note two-byte form is (first & 127) + second, so a count tops out at 127 + 255 = 382 - a run of all 504 chunks
+ *       of a full screen does not fit, an encoder writes it as two records (382 chunks, an empty count, the rest)
+ */
+uint16_t _read_count(_ImageStream *stream);
+
+/**
+ * @brief parse header of a compressed image and prepare stream to read its chunks
+ * @param stream image stream
+ * @param compressed_image compressed image
+ * @param length size of compressed image in bytes
+ */
+void _image_stream_open(_ImageStream *stream, uint8_t *compressed_image, uint32_t length);
+
+/**
+ * @brief decompress next chunks of image - runs are copied and filled as blocks
+ * @param stream image stream
+ * @param out destination of chunks, 0 to skip chunks
+ * @param count count of chunks wanted
+ * @return count of chunks produced - less than count only at end of image
+ */
+uint16_t _image_stream_read(_ImageStream *stream, uint8_t *out, uint16_t count);
+
+/**
+ * @brief place an image on the 84x6 chunk grid - image is moved inside LCD border, parts bigger than LCD are clipped
+ * @param stream opened image stream
+ * @param x_start x of image in chunks, corrected in place
+ * @param y_start y of image in banks, corrected in place
+ * @param box receives visible rectangle of image
+ */
+void _place_image(_ImageStream *stream, uint16_t *x_start, uint16_t *y_start, _Box *box);
+
+/**
+ * @brief decompress an image into an LCD-shaped buffer
+ * @param compressed_image compressed image
+ * @param length size of compressed image in bytes
+ * @param LCD_buffer destination holding banks first_bank..first_bank + bank_count - 1
+ * @param first_bank first bank held in LCD_buffer
+ * @param bank_count count of banks held in LCD_buffer - rows of image out of them are skipped
+ * @param x_start x of image in chunks
+ * @param y_start y of image in banks
+ * @param box receives rectangle of image on LCD
+ * @return HAL_ERROR if image is truncated or malformed, otherwise HAL_OK
+ */
+HAL_StatusTypeDef _decompress_image(uint8_t *compressed_image, uint32_t length, uint8_t *LCD_buffer, uint8_t first_bank,
+                                    uint8_t bank_count, uint16_t x_start, uint16_t y_start, _Box *box);
+
+#ifdef LCD_USE_BUS_STATS
+/**
+ * @brief close per-frame counters of bus statistics
+ * @param hlcd LCD handle
+ */
+void _end_frame_stats(LCD_HandleTypeDef *hlcd);
+#endif
+
+#ifdef LCD_USE_PROFILING
+/**
+ * @brief size of dirty region
+ * @param hlcd LCD handle
+ * @return bytes of buffer in dirty spans
+ */
+uint16_t _dirty_bytes(LCD_HandleTypeDef *hlcd);
+#endif
+
+#ifdef LCD_USE_DMA
+/**
+ * @brief checks whether a DMA chain of an LCD on the same bus is running - its CE stays low until it ends
+ * @param hlcd LCD handle
+ * @return 1 if bus is taken by a chain, own one included
+ */
+uint8_t _bus_taken(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief snapshot a run and append its address and data segments to DMA chain
+ * @param hlcd LCD handle
+ * @param start_index first byte of buffer to be sent
+ * @param end_index one past last byte of buffer to be sent
+ */
+void _queue_dma_run(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index);
+
+/**
+ * @brief set DC pin and start DMA transfer of current segment of chain - a segment which cannot start ends chain
+ * @param hlcd LCD handle
+ * @return status of HAL_SPI_Transmit_DMA
+ */
+HAL_StatusTypeDef _start_dma_segment(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief checks whether LCD_SPI_TxCpltCallback knows a handle
+ * @param hlcd LCD handle
+ * @return 1 if handle is registered by LCDx_Init_async
+ */
+uint8_t _dma_registered(LCD_HandleTypeDef *hlcd);
+#endif
+
+/**
+ * @brief moves start-up sequence to its next step, timed from now
+ * @param hlcd LCD handle
+ * @param state next LCD_InitState
+ */
+void _next_init_state(LCD_HandleTypeDef *hlcd, uint8_t state);
+
+/**
+ * @brief queues command sequence which sets LCD up after reset
+ * @param hlcd LCD handle
+ */
+void _queue_init_commands(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief queues display control and power commands that effects and idle policy need by now
+ * @param hlcd LCD handle
+ * @param frame_follows 1 if a frame goes out right after, whatever is dirty
+ */
+void _step_effects(LCD_HandleTypeDef *hlcd, uint8_t frame_follows);
+
+/**
+ * @brief sends queued commands as an update of their own, counted like any other
+ * @param hlcd LCD handle
+ */
+void _send_command_frame(LCD_HandleTypeDef *hlcd);
+
+HAL_StatusTypeDef LCDx_Init(LCD_HandleTypeDef *hlcd, uint8_t contrast) {
+    if (LCDx_Init_async(hlcd, contrast) != HAL_OK)
+        return HAL_ERROR;
+    while (LCDx_Init_step(hlcd) != HAL_OK);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef LCDx_Init_async(LCD_HandleTypeDef *hlcd, uint8_t contrast) {
+#ifdef LCD_USE_DMA
+    //completion of a chain finds its LCD here - an LCD left out would hang on its first chain, so it is refused
+    uint8_t slot = 0;
+    while (slot < LCD_MAX_INSTANCES && dma_handles[slot] && dma_handles[slot] != hlcd)
+        slot++;
+    if (slot == LCD_MAX_INSTANCES)
+        return HAL_ERROR;
+    dma_handles[slot] = hlcd;
+#endif
+    
+    //panel is held in reset while the rest of the board starts up
+    HAL_GPIO_WritePin(hlcd->reset_port, hlcd->reset_pin, 0);
+    hlcd->init_contrast = contrast;
+    _next_init_state(hlcd, LCD_INIT_RESET_LOW);
+    
+    if (hlcd->ce_port)
+        HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 1);
+    
+    hlcd->command_queue_length = 0;
+    hlcd->bus_error            = 0;
+    //LCD starts in horizontal mode after reset
+    hlcd->vertical_addressing = 0;
+    hlcd->powered_down        = 0;
+    hlcd->last_activity       = HAL_GetTick();
 
-void LCD_Init(uint8_t contrast) {
-    HAL_GPIO_WritePin(LCD_RESET_GPIO_Port, LCD_RESET_Pin, 0);
-    //wait
-    delayUS_DWT(100);
+#ifdef LCD_USE_SHADOW_BUFFER
+    //LCD RAM is undefined after reset
+    hlcd->shadow_valid = 0;
+#endif
     
-    //Reset bit initialize
-    HAL_GPIO_WritePin(LCD_RESET_GPIO_Port, LCD_RESET_Pin, 1);
-    //wait
-    delayUS_DWT(100);
+    //draw into own buffer until an external frame is attached
+    hlcd->frame     = hlcd->buffer;
+    hlcd->composing = 0;
     
-    //Reset
-    HAL_GPIO_WritePin(LCD_RESET_GPIO_Port, LCD_RESET_Pin, 0);
-    delayUS_DWT(1000);
-    HAL_GPIO_WritePin(LCD_RESET_GPIO_Port, LCD_RESET_Pin, 1);
+    //Clear buffer - it is sent whole as first frame, along with whatever is drawn meanwhile
+    LCDx_clear(hlcd);
+    return HAL_OK;
+}
+
+void _next_init_state(LCD_HandleTypeDef *hlcd, uint8_t state) {
+    hlcd->init_mark  = DWT->CYCCNT;
+    hlcd->init_state = state;
+}
+
+HAL_StatusTypeDef LCDx_Init_step(LCD_HandleTypeDef *hlcd) {
+    //each step falls through to the next one as soon as its time is up
+    switch (hlcd->init_state) {
+        case LCD_INIT_RESET_LOW:
+            if (!elapsedUS_DWT(hlcd->init_mark, 100))
+                return HAL_BUSY;
+            //Reset bit initialize
+            HAL_GPIO_WritePin(hlcd->reset_port, hlcd->reset_pin, 1);
+            _next_init_state(hlcd, LCD_INIT_RESET_HIGH);
+            /* fall through */
+        case LCD_INIT_RESET_HIGH:
+            if (!elapsedUS_DWT(hlcd->init_mark, 100))
+                return HAL_BUSY;
+            //Reset
+            HAL_GPIO_WritePin(hlcd->reset_port, hlcd->reset_pin, 0);
+            _next_init_state(hlcd, LCD_INIT_RESET_PULSE);
+            /* fall through */
+        case LCD_INIT_RESET_PULSE:
+            if (!elapsedUS_DWT(hlcd->init_mark, 1000))
+                return HAL_BUSY;
+            HAL_GPIO_WritePin(hlcd->reset_port, hlcd->reset_pin, 1);
+            _next_init_state(hlcd, LCD_INIT_SETTLE);
+            /* fall through */
+        case LCD_INIT_SETTLE:
+            if (!elapsedUS_DWT(hlcd->init_mark, 10))
+                return HAL_BUSY;
+            _queue_init_commands(hlcd);
+            hlcd->init_state = LCD_INIT_FIRST_FRAME;
+            /* fall through */
+        case LCD_INIT_FIRST_FRAME:
+#ifdef LCD_USE_DMA
+            //bus may be taken by another LCD sharing it
+            if (LCDx_update_async(hlcd) != HAL_OK)
+                return HAL_BUSY;
+#else
+            LCDx_update(hlcd);
+#endif
+            hlcd->init_state = LCD_INIT_DONE;
+            /* fall through */
+        default:
+            return HAL_OK;
+    }
+}
+
+uint8_t LCDx_is_ready(LCD_HandleTypeDef *hlcd) {
+    return hlcd->init_state == LCD_INIT_DONE;
+}
+
+void LCDx_invert(LCD_HandleTypeDef *hlcd, uint8_t inverted) {
+    hlcd->inverted = inverted ? 1 : 0;
+}
+
+void LCDx_blank(LCD_HandleTypeDef *hlcd, uint8_t blank) {
+    hlcd->blanked = blank ? 1 : 0;
+}
+
+void LCDx_flash(LCD_HandleTypeDef *hlcd, uint16_t period_ms, uint32_t duration_ms) {
+    hlcd->effect_period   = period_ms < 2 ? 2 : period_ms;
+    hlcd->effect_duration = duration_ms;
+    hlcd->effect_start    = HAL_GetTick();
+    hlcd->effect          = LCD_EFFECT_FLASH;
+}
+
+void LCDx_blink(LCD_HandleTypeDef *hlcd, uint16_t period_ms, uint32_t duration_ms) {
+    hlcd->effect_period   = period_ms < 2 ? 2 : period_ms;
+    hlcd->effect_duration = duration_ms;
+    hlcd->effect_start    = HAL_GetTick();
+    hlcd->effect          = LCD_EFFECT_BLINK;
+}
+
+void LCDx_stop_effect(LCD_HandleTypeDef *hlcd) {
+    hlcd->effect = LCD_EFFECT_NONE;
+}
+
+void LCDx_set_idle_power_down(LCD_HandleTypeDef *hlcd, uint32_t idle_ms) {
+    hlcd->idle_timeout  = idle_ms;
+    hlcd->last_activity = HAL_GetTick();
+}
+
+uint8_t LCDx_is_powered_down(LCD_HandleTypeDef *hlcd) {
+    return hlcd->powered_down;
+}
+
+void LCDx_step_effects(LCD_HandleTypeDef *hlcd) {
+    _step_effects(hlcd, 0);
+}
+
+void _step_effects(LCD_HandleTypeDef *hlcd, uint8_t frame_follows) {
+    uint32_t now     = HAL_GetTick();
+    uint8_t  control = hlcd->blanked ? LCD_DISPLAY_CONTROL_DISPLAY_BLANK :
+                       hlcd->inverted ? LCD_DISPLAY_CONTROL_INVERTED_MODE : LCD_DISPLAY_CONTROL_NORMAL_MODE;
     
-    //wait
-    delayUS_DWT(10);
+    if (hlcd->effect != LCD_EFFECT_NONE) {
+        uint32_t elapsed = now - hlcd->effect_start;
+        if (hlcd->effect_duration && elapsed >= hlcd->effect_duration)
+            hlcd->effect = LCD_EFFECT_NONE;
+        else if (elapsed % hlcd->effect_period < hlcd->effect_period / 2)
+            control = hlcd->effect == LCD_EFFECT_FLASH ? LCD_DISPLAY_CONTROL_ALL_SEGMENTS_ON
+                                                       : LCD_DISPLAY_CONTROL_DISPLAY_BLANK;
+    }
     
+    if (frame_follows || hlcd->flag.area_changed || control != hlcd->shown_control) {
+        if (hlcd->powered_down) {
+            //panel kept its RAM, a function set byte brings it back as it was
+            _queue_command(hlcd, LCD_POWERDOWN_DISABLE);
+            hlcd->powered_down = 0;
+#ifdef LCD_USE_BUS_STATS
+            hlcd->bus_stats.mode_commands++;
+#endif
+        }
+        if (control != hlcd->shown_control) {
+            _queue_command(hlcd, control);
+            hlcd->shown_control = control;
+#ifdef LCD_USE_BUS_STATS
+            hlcd->bus_stats.mode_commands++;
+#endif
+        }
+        hlcd->last_activity = now;
+    } else if (hlcd->idle_timeout && !hlcd->powered_down && hlcd->effect == LCD_EFFECT_NONE &&
+               now - hlcd->last_activity >= hlcd->idle_timeout) {
+        //function set also clears V bit
+        _queue_command(hlcd, LCD_POWERDOWN_ENABLE);
+        hlcd->powered_down        = 1;
+        hlcd->vertical_addressing = 0;
+#ifdef LCD_USE_BUS_STATS
+        hlcd->bus_stats.mode_commands++;
+#endif
+    }
+}
+
+void _send_command_frame(LCD_HandleTypeDef *hlcd) {
+    if (hlcd->command_queue_length == 0)
+        return;
+#ifdef LCD_USE_PROFILING
+    uint32_t profile_bytes        = lcd_profile.bytes;
+    uint32_t profile_transactions = lcd_profile.transactions;
+#endif
+#ifdef LCD_USE_BUS_STATS
+    hlcd->frame_start_transactions = hlcd->bus_stats.transactions;
+    hlcd->frame_start_bytes        = hlcd->bus_stats.bytes;
+#endif
+    _flush_commands(hlcd);
+#ifdef LCD_USE_BUS_STATS
+    _end_frame_stats(hlcd);
+#endif
+#ifdef LCD_USE_PROFILING
+    LCD_stat_add(&lcd_profile.update_bytes, lcd_profile.bytes - profile_bytes);
+    LCD_stat_add(&lcd_profile.update_transactions, lcd_profile.transactions - profile_transactions);
+#endif
+}
+
+void _queue_init_commands(LCD_HandleTypeDef *hlcd) {
+    uint8_t contrast = hlcd->init_contrast;
+    //whole command sequence goes out in a single transaction along with first update address
     //Extended Mode Enable
-    _send_single_command(LCD_H_EXTENDED_INSTRUCTION);
+    _queue_command(hlcd, LCD_H_EXTENDED_INSTRUCTION);
     
     //Set Contrast(VOP)
     if (contrast > 0x7f) {
         contrast = 0x7f;
     }
-    _send_single_command(LCD_SET_VOP | contrast);
+    _queue_command(hlcd, LCD_SET_VOP | contrast);
     
     //Set Bias
-    _send_single_command(LCD_BIAS_SYSTEM | 0x03);
+    _queue_command(hlcd, LCD_BIAS_SYSTEM | 0x03);
     
     //Extended Mode Disable
-    _send_single_command(LCD_H_SIMPLE_INSTRUCTION);
-    
-    //Display in Normal Mode
-    _send_single_command(LCD_DISPLAY_CONTROL_NORMAL_MODE);
+    _queue_command(hlcd, LCD_H_SIMPLE_INSTRUCTION);
     
-    //Set X,Y
-    _send_single_command(LCD_SET_X_ADDRESS | 0x00);
-    _send_single_command(LCD_SET_Y_ADDRESS | 0x00);
-    
-    //Clear buffer
-    LCD_clear();
-    
-    //update
-    LCD_update();
+    //Display in Normal Mode - effects set up before init follow with first frame
+    _queue_command(hlcd, LCD_DISPLAY_CONTROL_NORMAL_MODE);
+    hlcd->shown_control = LCD_DISPLAY_CONTROL_NORMAL_MODE;
 }
 
-void _send_single_command(uint8_t command) {
-    //select to write command
-    HAL_GPIO_WritePin(LCD_DC_GPIO_Port, LCD_DC_Pin, 0);
+void _spi_transmit(LCD_HandleTypeDef *hlcd, uint8_t is_data, uint8_t *data, uint16_t length) {
+    LCD_PROFILE_BEGIN();
+#ifdef LCD_USE_BUS_MONITOR
+    if (hlcd->bus_monitor)
+        hlcd->bus_monitor(hlcd, is_data, data, length);
+#endif
+    //another LCD on this bus must be deselected before this one is selected
+    _wait_for_bus(hlcd);
+    HAL_GPIO_WritePin(hlcd->dc_port, hlcd->dc_pin, is_data);
+    if (hlcd->ce_port)
+        HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 0);
     
-    //Non-Blocking SPI Transmit---Check does it sent before following on
-    HAL_SPI_Transmit(&LCD_SPI_Handler, &command, 1, 1);
+    HAL_StatusTypeDef status = HAL_SPI_Transmit(hlcd->hspi, data, length, 10);
+    //bus was taken meanwhile, e.g. by a transfer outside this driver - step aside and try again
+    while (status == HAL_BUSY) {
+        if (hlcd->ce_port)
+            HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 1);
+        _wait_for_bus(hlcd);
+        HAL_GPIO_WritePin(hlcd->dc_port, hlcd->dc_pin, is_data);
+        if (hlcd->ce_port)
+            HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 0);
+        status = HAL_SPI_Transmit(hlcd->hspi, data, length, 10);
+    }
     
-    while (HAL_SPI_GetState(&LCD_SPI_Handler) != HAL_SPI_STATE_READY);
+    if (hlcd->ce_port)
+        HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 1);
+    //bytes may be partly taken by panel, next update resends everything
+    if (status != HAL_OK) {
+        hlcd->bus_error = 1;
+#ifdef LCD_USE_BUS_STATS
+        hlcd->bus_stats.errors++;
+#endif
+    }
+
+#ifdef LCD_USE_BUS_STATS
+    hlcd->bus_stats.transactions++;
+    hlcd->bus_stats.bytes += length;
+#endif
+#ifdef LCD_USE_PROFILING
+    lcd_profile.transactions++;
+    lcd_profile.bytes += length;
+#endif
+    LCD_PROFILE_END(LCD_PROBE_SPI_SEND);
+}
+
+void _wait_for_bus(LCD_HandleTypeDef *hlcd) {
+#ifdef LCD_USE_DMA
+    //a chain is idle between its segments, SPI state alone does not tell it ended
+    while (HAL_SPI_GetState(hlcd->hspi) != HAL_SPI_STATE_READY || _bus_taken(hlcd));
+#else
+    while (HAL_SPI_GetState(hlcd->hspi) != HAL_SPI_STATE_READY);
+#endif
+}
+
+void _recover_bus_error(LCD_HandleTypeDef *hlcd) {
+    if (!hlcd->bus_error)
+        return;
+    hlcd->bus_error = 0;
+    //basic function set leaves power down and vertical mode, effects queue display control again
+    _queue_command(hlcd, LCD_VERTICAL_DISABLE);
+    hlcd->vertical_addressing = 0;
+    hlcd->powered_down        = 0;
+    hlcd->shown_control       = 0;
+#ifdef LCD_USE_SHADOW_BUFFER
+    hlcd->shadow_valid = 0;
+#endif
+    _mark_dirty_area(hlcd, 0, LCD_WIDTH_IN_CHUNK, 0, LCD_Y_MAX_CHUNK);
 }
 
-void _send_single_data(uint8_t data) {
-    HAL_GPIO_WritePin(LCD_DC_GPIO_Port, LCD_DC_Pin, 1);
-    //Non-Blocking SPI Transmit---Check for if it does sent before follow on
-    HAL_SPI_Transmit(&LCD_SPI_Handler, &data, 1, 1);
-    while (HAL_SPI_GetState(&LCD_SPI_Handler) != HAL_SPI_STATE_READY);
+void _queue_command(LCD_HandleTypeDef *hlcd, uint8_t command) {
+    if (hlcd->command_queue_length == LCD_COMMAND_QUEUE_SIZE)
+        _flush_commands(hlcd);
+    hlcd->command_queue[hlcd->command_queue_length++] = command;
+}
+
+void _flush_commands(LCD_HandleTypeDef *hlcd) {
+    if (hlcd->command_queue_length == 0)
+        return;
+    _spi_transmit(hlcd, 0, hlcd->command_queue, hlcd->command_queue_length);
+    hlcd->command_queue_length = 0;
+}
+
+void _send_single_command(LCD_HandleTypeDef *hlcd, uint8_t command) {
+    _queue_command(hlcd, command);
+    _flush_commands(hlcd);
+}
+
+void _send_single_data(LCD_HandleTypeDef *hlcd, uint8_t data) {
+    _flush_commands(hlcd);
+    _spi_transmit(hlcd, 1, &data, 1);
 }
 
 /// <summary>
@@ -279,227 +704,963 @@ void _send_single_data(uint8_t data) {
 /// <param name="data">data array contains data bytes to be sent</param>
 /// <param name="start_index"></param>
 /// <param name="end_index"></param>
-void _send_multi_data(uint8_t data[], size_t start_index, size_t end_index) {
-    //select to write command
-    HAL_GPIO_WritePin(LCD_DC_GPIO_Port, LCD_DC_Pin, 1);
-    
+void _send_multi_data(LCD_HandleTypeDef *hlcd, uint8_t data[], size_t start_index, size_t end_index) {
     //To control max allowed elements
     if (end_index < start_index)
         return;
     if (end_index > LCD_BUFFER_SIZE)
         end_index = LCD_BUFFER_SIZE;
     
-    //Non-Blocking SPI Transmit---Check does it sent before following on
-    HAL_SPI_Transmit(&LCD_SPI_Handler, data + start_index, end_index - start_index, 10);
-    while (HAL_SPI_GetState(&LCD_SPI_Handler) != HAL_SPI_STATE_READY);
+    //pending address commands go out right before data
+    _flush_commands(hlcd);
+    _spi_transmit(hlcd, 1, data + start_index, (uint16_t) (end_index - start_index));
+}
+
+void _mark_dirty_area(LCD_HandleTypeDef *hlcd, uint8_t x_low, uint8_t x_high, uint8_t bank_low, uint8_t bank_high) {
+    if (x_high > LCD_WIDTH_IN_CHUNK)
+        x_high = LCD_WIDTH_IN_CHUNK;
+    if (bank_high > LCD_Y_MAX_CHUNK)
+        bank_high = LCD_Y_MAX_CHUNK;
+    if (x_low >= x_high || bank_low > bank_high)
+        return;
     
+    LCD_ENTER_CRITICAL();
+    for (uint8_t bank = bank_low; bank <= bank_high; bank++) {
+        if (hlcd->dirty_low[bank] >= hlcd->dirty_high[bank]) {
+            hlcd->dirty_low[bank]  = x_low;
+            hlcd->dirty_high[bank] = x_high;
+            continue;
+        }
+        if (hlcd->dirty_low[bank] > x_low)
+            hlcd->dirty_low[bank] = x_low;
+        if (hlcd->dirty_high[bank] < x_high)
+            hlcd->dirty_high[bank] = x_high;
+    }
+    hlcd->flag.area_changed = 1;
+    LCD_EXIT_CRITICAL();
 }
 
-void LCD_clear(void) {
-    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
-        buffer[i] = 0x00;
-    start_in_line_update  = 0;
-    end_in_line_update    = LCD_BUFFER_SIZE;
-    cursor_in_line_update = LCD_BUFFER_SIZE;
-    buffer_flag.in_line_changed = 1;
+void _mark_dirty_in_line(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index) {
+    if (end_index > LCD_BUFFER_SIZE)
+        end_index = LCD_BUFFER_SIZE;
+    if (start_index >= end_index)
+        return;
+    
+    uint8_t first_bank = (uint8_t) (start_index / LCD_WIDTH_IN_CHUNK);
+    uint8_t last_bank  = (uint8_t) ((end_index - 1) / LCD_WIDTH_IN_CHUNK);
+    uint8_t first_x    = (uint8_t) (start_index % LCD_WIDTH_IN_CHUNK);
+    uint8_t last_x     = (uint8_t) ((end_index - 1) % LCD_WIDTH_IN_CHUNK);
+    
+    if (first_bank == last_bank) {
+        _mark_dirty_area(hlcd, first_x, last_x + 1, first_bank, first_bank);
+        return;
+    }
+    //head and tail banks are partial, banks in between are full
+    _mark_dirty_area(hlcd, first_x, LCD_WIDTH_IN_CHUNK, first_bank, first_bank);
+    if (last_bank - first_bank > 1)
+        _mark_dirty_area(hlcd, 0, LCD_WIDTH_IN_CHUNK, first_bank + 1, last_bank - 1);
+    _mark_dirty_area(hlcd, 0, last_x + 1, last_bank, last_bank);
 }
 
-void LCD_write_char_8x6(uint8_t chr)//todo 1 I char chr)
+void LCDx_clear(LCD_HandleTypeDef *hlcd) {
+    for (uint16_t i = 0; i < LCD_FRAME_BUFFER_SIZE; i++)
+        hlcd->frame[i] = 0x00;
+    hlcd->cursor_in_line_update = 0;
+    _mark_dirty_area(hlcd, 0, LCD_WIDTH_IN_CHUNK, 0, LCD_Y_MAX_CHUNK);
+}
+
+void LCDx_write_char_8x6(LCD_HandleTypeDef *hlcd, uint8_t chr)//todo 1 I char chr)
 {
+    LCD_PROFILE_BEGIN();
     // if a new charater is entered but buffer is full then regret it.
-    if (cursor_in_line_update + 6 > LCD_BUFFER_SIZE)
+    if (hlcd->cursor_in_line_update + 6 > LCD_BUFFER_SIZE) {
+        LCD_PROFILE_END(LCD_PROBE_GLYPH);
         return;
-    for (uint16_t n = 0; n < 5; n++)
-        buffer[cursor_in_line_update++] = font_en_8x5[chr - 32][n];
+    }
+    //characters out of font are drawn as ' '
+    if (chr < LCD_FONT_FIRST_CHAR || chr > LCD_FONT_LAST_CHAR)
+        chr = LCD_FONT_FIRST_CHAR;
+    uint16_t start = hlcd->cursor_in_line_update;
+    for (uint16_t n = 0; n < 5; n++, hlcd->cursor_in_line_update++)
+        if (LCD_BUFFER_HOLDS(hlcd, hlcd->cursor_in_line_update))
+            hlcd->frame[LCD_BUFFER_INDEX(hlcd, hlcd->cursor_in_line_update)] =
+                    font_en_8x5[chr - LCD_FONT_FIRST_CHAR][n];
     //add a vertical space also horizontal row pixels is integral multipe of one charcter
-    buffer[cursor_in_line_update++]     = 0x00;
-    //if cursor is out of <start to end region> then update end_in_line_update
-    if (cursor_in_line_update > end_in_line_update)
-        end_in_line_update = cursor_in_line_update;
-    buffer_flag.in_line_changed = 1;
+    if (LCD_BUFFER_HOLDS(hlcd, hlcd->cursor_in_line_update))
+        hlcd->frame[LCD_BUFFER_INDEX(hlcd, hlcd->cursor_in_line_update)] = 0x00;
+    hlcd->cursor_in_line_update++;
+    _mark_dirty_in_line(hlcd, start, hlcd->cursor_in_line_update);
+    LCD_PROFILE_END(LCD_PROBE_GLYPH);
+}
+
+#ifndef LCD_USE_PAGED_MODE
+void _send_run(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index) {
+#ifdef LCD_USE_DMA
+    if (hlcd->dma_collecting) {
+        _queue_dma_run(hlcd, start_index, end_index);
+        return;
+    }
+#endif
+    if (hlcd->vertical_addressing) {
+        _queue_command(hlcd, LCD_VERTICAL_DISABLE);
+        hlcd->vertical_addressing = 0;
+    }
+    _queue_command(hlcd, LCD_SET_X_ADDRESS | (uint8_t) (start_index % LCD_WIDTH_IN_CHUNK));
+    _queue_command(hlcd, LCD_SET_Y_ADDRESS | (uint8_t) (start_index / LCD_WIDTH_IN_CHUNK));
+#ifdef LCD_USE_SHADOW_BUFFER
+    //shadow is copied first and sent, so it holds what LCD got even if frame is drawn into meanwhile
+    for (uint16_t i = start_index; i < end_index; i++)
+        hlcd->shadow_buffer[i] = hlcd->frame[i];
+    _send_multi_data(hlcd, hlcd->shadow_buffer, start_index, end_index);
+#else
+    _send_multi_data(hlcd, hlcd->frame, start_index, end_index);
+#endif
+}
+
+void _take_run(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index, uint8_t send, _Box *box,
+               uint16_t *cost) {
+    *cost += LCD_ADDRESS_JUMP_COST + (end_index - start_index);
+    if (send) {
+        _send_run(hlcd, start_index, end_index);
+        return;
+    }
     
+    uint8_t first_bank = (uint8_t) (start_index / LCD_WIDTH_IN_CHUNK);
+    uint8_t last_bank  = (uint8_t) ((end_index - 1) / LCD_WIDTH_IN_CHUNK);
+    uint8_t x_low      = 0;
+    uint8_t x_high     = LCD_WIDTH_IN_CHUNK;
+    if (first_bank == last_bank) {
+        x_low  = (uint8_t) (start_index % LCD_WIDTH_IN_CHUNK);
+        x_high = (uint8_t) ((end_index - 1) % LCD_WIDTH_IN_CHUNK + 1);
+    }
+    if (box->x_low > x_low)
+        box->x_low = x_low;
+    if (box->x_high < x_high)
+        box->x_high = x_high;
+    if (box->bank_low > first_bank)
+        box->bank_low = first_bank;
+    if (box->bank_high < last_bank)
+        box->bank_high = last_bank;
 }
 
+uint16_t _walk_runs(LCD_HandleTypeDef *hlcd, uint8_t send, _Box *box) {
+    uint16_t cost      = 0;
+    uint16_t run_start = 0;
+    uint16_t run_end   = 0;
+    
+    //runs are kept in in-line format, so a run may continue from end of a bank to head of next one
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        if (hlcd->send_low[bank] >= hlcd->send_high[bank])
+            continue;
+        uint16_t bank_start = (uint16_t) bank * LCD_WIDTH_IN_CHUNK;
 
-void LCD_update(void) {
-    //if both  types of buffer demonestrations have been changed
-    if (buffer_flag.area_changed && buffer_flag.in_line_changed) {
-        //todo Improve
-    }
-        //if just in-line type of buffer has been changed
-    else if (buffer_flag.in_line_changed) {
-        //goto xy command to lcd
-        _send_single_command(LCD_SET_X_ADDRESS | (start_in_line_update % LCD_BUFFER_SIZE) % (LCD_X_MAX_CHUNK + 1));
-        _send_single_command(
-                LCD_SET_Y_ADDRESS | (uint8_t) ((start_in_line_update % LCD_BUFFER_SIZE) / (LCD_X_MAX_CHUNK + 1)));
-        
-        _send_multi_data(buffer, start_in_line_update, end_in_line_update);
-        
-        start_in_line_update  = end_in_line_update % LCD_BUFFER_SIZE;
-        end_in_line_update    = start_in_line_update;
-        cursor_in_line_update = start_in_line_update;
-        buffer_flag.in_line_changed = 0;
-        
+#ifdef LCD_USE_SHADOW_BUFFER
+        //diff against frame last sent to LCD
+        for (uint16_t i = bank_start + hlcd->send_low[bank]; i < bank_start + hlcd->send_high[bank]; i++) {
+            if (hlcd->shadow_valid && hlcd->frame[i] == hlcd->shadow_buffer[i])
+                continue;
+            
+            //merge short unchanged gaps into current run - cheaper than a new address pair
+            if (run_start < run_end && i - run_end <= LCD_ADDRESS_JUMP_COST) {
+                run_end = i + 1;
+                continue;
+            }
+            if (run_start < run_end)
+                _take_run(hlcd, run_start, run_end, send, box, &cost);
+            run_start = i;
+            run_end   = i + 1;
+        }
+#else
+        //changed columns of each bank with one X/Y address pair per bank
+        //a span reaching end of a bank continues to next bank without new address (horizontal auto-increment)
+        if (run_end != bank_start + hlcd->send_low[bank]) {
+            if (run_start < run_end)
+                _take_run(hlcd, run_start, run_end, send, box, &cost);
+            run_start = bank_start + hlcd->send_low[bank];
+        }
+        run_end = bank_start + hlcd->send_high[bank];
+#endif
+    }
+    if (run_start < run_end)
+        _take_run(hlcd, run_start, run_end, send, box, &cost);
+    return cost;
+}
+
+void _send_vertical(LCD_HandleTypeDef *hlcd, _Box *box) {
+    if (!hlcd->vertical_addressing) {
+        _queue_command(hlcd, LCD_VERTICAL_ENABLE);
+        hlcd->vertical_addressing = 1;
     }
-        //if just area type of buffer has been changed
-    else if (buffer_flag.area_changed) {
-        //todo Improve
+    _queue_command(hlcd, LCD_SET_X_ADDRESS | box->x_low);
+    _queue_command(hlcd, LCD_SET_Y_ADDRESS | box->bank_low);
+    _flush_commands(hlcd);
+    
+    //in vertical mode LCD address walks down banks of a column, then goes to head of next column
+    uint16_t first = (uint16_t) box->x_low * LCD_HEIGHT_IN_CHUNK + box->bank_low;
+    uint16_t last  = (uint16_t) (box->x_high - 1) * LCD_HEIGHT_IN_CHUNK + box->bank_high;
+    uint8_t  count = 0;
+    for (uint16_t v = first; v <= last; v++) {
+        uint16_t index = (v % LCD_HEIGHT_IN_CHUNK) * LCD_WIDTH_IN_CHUNK + v / LCD_HEIGHT_IN_CHUNK;
+        hlcd->vertical_stage[count] = hlcd->frame[index];
+#ifdef LCD_USE_SHADOW_BUFFER
+        hlcd->shadow_buffer[index] = hlcd->vertical_stage[count];
+#endif
+        count++;
+        if (count == LCD_VERTICAL_STAGE_SIZE || v == last) {
+            _spi_transmit(hlcd, 1, hlcd->vertical_stage, count);
+            count = 0;
+        }
     }
 }
 
+uint8_t _try_vertical_update(LCD_HandleTypeDef *hlcd) {
+#ifdef LCD_USE_DMA
+    //DMA chain sends straight from snapshot which is laid out horizontally
+    if (hlcd->dma_collecting)
+        return 0;
+#endif
+    //a single bank is always cheaper in horizontal mode
+    uint8_t dirty_banks = 0;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        dirty_banks += hlcd->send_low[bank] < hlcd->send_high[bank];
+    if (dirty_banks < 2)
+        return 0;
+    
+    _Box     box             = {LCD_WIDTH_IN_CHUNK, 0, LCD_Y_MAX_CHUNK, 0};
+    uint16_t horizontal_cost = _walk_runs(hlcd, 0, &box) + hlcd->vertical_addressing;
+    if (box.x_low >= box.x_high)
+        return 0;
+    
+    //function set is needed to switch mode
+    uint16_t vertical_cost = LCD_ADDRESS_JUMP_COST + !hlcd->vertical_addressing
+                             + (box.x_high - 1 - box.x_low) * LCD_HEIGHT_IN_CHUNK + box.bank_high - box.bank_low + 1;
+    if (vertical_cost >= horizontal_cost)
+        return 0;
+    
+    _send_vertical(hlcd, &box);
+    return 1;
+}
 
-void LCD_goto_x_y_chunk(uint16_t x, uint16_t y) {
-    //control to not be out of range
-    if (x > LCD_X_MAX_CHUNK || y > LCD_Y_MAX_CHUNK || x < 0 || y < 0)
+void _flush_dirty(LCD_HandleTypeDef *hlcd) {
+    //spans are taken and cleared before sending, a mark made while runs go out stays for next update
+    LCD_ENTER_CRITICAL();
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        hlcd->send_low[bank]   = hlcd->dirty_low[bank];
+        hlcd->send_high[bank]  = hlcd->dirty_high[bank];
+        hlcd->dirty_low[bank]  = LCD_WIDTH_IN_CHUNK;
+        hlcd->dirty_high[bank] = 0;
+    }
+    hlcd->flag.area_changed = 0;
+    LCD_EXIT_CRITICAL();
+
+#ifdef LCD_USE_SHADOW_BUFFER
+    //LCD RAM content is unknown until a full frame is sent once
+    if (!hlcd->shadow_valid) {
+        memset(hlcd->send_low, 0, LCD_HEIGHT_IN_CHUNK);
+        memset(hlcd->send_high, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    }
+#endif
+    
+    if (!_try_vertical_update(hlcd))
+        _walk_runs(hlcd, 1, 0);
+
+#ifdef LCD_USE_SHADOW_BUFFER
+    hlcd->shadow_valid = 1;
+#endif
+}
+
+#else
+void _render_pages(LCD_HandleTypeDef *hlcd) {
+    if (hlcd->vertical_addressing) {
+        _queue_command(hlcd, LCD_VERTICAL_DISABLE);
+        hlcd->vertical_addressing = 0;
+    }
+    //banks are contiguous in horizontal mode, one address is enough for whole frame
+    _queue_command(hlcd, LCD_SET_X_ADDRESS | 0);
+    _queue_command(hlcd, LCD_SET_Y_ADDRESS | 0);
+    
+    //marks are cleared before rendering, a request made while pages go out stays for next update
+    LCD_ENTER_CRITICAL();
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        hlcd->dirty_low[bank]  = LCD_WIDTH_IN_CHUNK;
+        hlcd->dirty_high[bank] = 0;
+    }
+    hlcd->flag.area_changed = 0;
+    LCD_EXIT_CRITICAL();
+    
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        hlcd->page = bank;
+        memset(hlcd->frame, 0, LCD_FRAME_BUFFER_SIZE);
+        if (hlcd->draw_callback)
+            hlcd->draw_callback(hlcd, bank);
+        _send_multi_data(hlcd, hlcd->frame, 0, LCD_FRAME_BUFFER_SIZE);
+    }
+}
+
+void LCDx_set_draw_callback(LCD_HandleTypeDef *hlcd, void (*draw)(LCD_HandleTypeDef *hlcd, uint8_t bank)) {
+    hlcd->draw_callback = draw;
+    hlcd->flag.area_changed = 1;
+}
+#endif
+
+void LCDx_update(LCD_HandleTypeDef *hlcd) {
+    if (LCD_PANEL_IN_RESET(hlcd))
+        return;
+    //previous frame, or a chain of another LCD on this bus, must leave the bus before blocking transfers start
+    _wait_for_bus(hlcd);
+    LCD_PROFILE_BEGIN();
+    _recover_bus_error(hlcd);
+#ifdef LCD_USE_PAGED_MODE
+    //paged buffer holds nothing between updates, the draw callback is what changes
+    _step_effects(hlcd, 1);
+#else
+    _step_effects(hlcd, 0);
+    if (!hlcd->flag.area_changed) {
+        //effects alone cost their command bytes
+        _send_command_frame(hlcd);
+        LCD_PROFILE_END(LCD_PROBE_UPDATE);
         return;
+    }
+#endif
+#ifdef LCD_USE_PROFILING
+    uint32_t profile_bytes        = lcd_profile.bytes;
+    uint32_t profile_transactions = lcd_profile.transactions;
+#ifndef LCD_USE_PAGED_MODE
+    LCD_stat_add(&lcd_profile.dirty_bytes, _dirty_bytes(hlcd));
+#endif
+#endif
+#ifdef LCD_USE_BUS_STATS
+    hlcd->frame_start_transactions = hlcd->bus_stats.transactions;
+    hlcd->frame_start_bytes        = hlcd->bus_stats.bytes;
+#endif
+#ifdef LCD_USE_PAGED_MODE
+    _render_pages(hlcd);
+#else
+    _flush_dirty(hlcd);
+#endif
+#ifdef LCD_USE_BUS_STATS
+    _end_frame_stats(hlcd);
+#endif
+#ifdef LCD_USE_PROFILING
+    if (lcd_profile.bytes != profile_bytes) {
+        LCD_stat_add(&lcd_profile.update_bytes, lcd_profile.bytes - profile_bytes);
+        LCD_stat_add(&lcd_profile.update_transactions, lcd_profile.transactions - profile_transactions);
+    }
+#endif
+    LCD_PROFILE_END(LCD_PROBE_UPDATE);
+}
+
+uint32_t LCD_wire_time_us(uint32_t bytes, uint32_t transactions, uint32_t spi_hz) {
+    if (spi_hz == 0)
+        return 0;
+    uint64_t ns = (uint64_t) bytes * 8 * 1000000000u / spi_hz + (uint64_t) transactions * LCD_TRANSACTION_OVERHEAD_NS;
+    return (uint32_t) ((ns + 999) / 1000);
+}
+
+#ifdef LCD_USE_BUS_STATS
+void _end_frame_stats(LCD_HandleTypeDef *hlcd) {
+    hlcd->bus_stats.frames++;
+    hlcd->bus_stats.last_frame_transactions = (uint16_t) (hlcd->bus_stats.transactions - hlcd->frame_start_transactions);
+    hlcd->bus_stats.last_frame_bytes        = (uint16_t) (hlcd->bus_stats.bytes - hlcd->frame_start_bytes);
+}
+
+void LCDx_get_bus_stats(LCD_HandleTypeDef *hlcd, LCD_BusStats *stats) {
+    *stats = hlcd->bus_stats;
+}
+
+void LCDx_reset_bus_stats(LCD_HandleTypeDef *hlcd) {
+    hlcd->bus_stats = (LCD_BusStats) {0};
+}
+#endif
+
+#ifdef LCD_USE_BUS_MONITOR
+void LCDx_set_bus_monitor(LCD_HandleTypeDef *hlcd,
+                          void (*monitor)(LCD_HandleTypeDef *hlcd, uint8_t is_data, const uint8_t *data, uint16_t length)) {
+    hlcd->bus_monitor = monitor;
+}
+#endif
+
+#ifdef LCD_USE_PROFILING
+uint16_t _dirty_bytes(LCD_HandleTypeDef *hlcd) {
+    uint16_t bytes = 0;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        if (hlcd->dirty_low[bank] < hlcd->dirty_high[bank])
+            bytes += hlcd->dirty_high[bank] - hlcd->dirty_low[bank];
+    return bytes;
+}
+
+void LCD_stat_add(LCD_Stat *stat, uint32_t value) {
+    if (stat->count == 0 || value < stat->min)
+        stat->min = value;
+    if (value > stat->max)
+        stat->max = value;
+    stat->count++;
+    stat->total += value;
+}
+
+uint32_t LCD_stat_average(const LCD_Stat *stat) {
+    return stat->count ? (uint32_t) (stat->total / stat->count) : 0;
+}
+
+void LCD_get_profile(LCD_Profile *profile) {
+    *profile = lcd_profile;
+}
+
+void LCD_reset_profile(void) {
+    lcd_profile = (LCD_Profile) {0};
+}
+#endif
+
+#ifdef LCD_USE_DMA
+void _queue_dma_run(LCD_HandleTypeDef *hlcd, uint16_t start_index, uint16_t end_index) {
+    uint16_t copy_from = start_index;
+#ifdef LCD_USE_SHADOW_BUFFER
+    uint8_t *source = hlcd->dma_snapshot;
+#else
+    //an attached frame is owned by caller and kept intact during transfer, so it is sent in place
+    uint8_t *source = hlcd->frame == hlcd->buffer ? hlcd->dma_snapshot : hlcd->frame;
+#endif
     
-    uint16_t x_y_in_line_format = x + y * (LCD_X_MAX_CHUNK + 1);
-    if (start_in_line_update > x_y_in_line_format)
-        start_in_line_update = x_y_in_line_format;
+    if (hlcd->dma_run_count == LCD_DMA_MAX_RUNS) {
+        //chain is full - stretch last run up to this one, gap is resent from source
+        LCD_DMASegment *last = &hlcd->dma_chain[2 * hlcd->dma_run_count - 1];
+        copy_from    = (uint16_t) (last->data - source) + last->length;
+        last->length = end_index - (uint16_t) (last->data - source);
+    } else {
+        uint8_t run = hlcd->dma_run_count++;
+        hlcd->dma_address[run][0] = LCD_SET_X_ADDRESS | (uint8_t) (start_index % LCD_WIDTH_IN_CHUNK);
+        hlcd->dma_address[run][1] = LCD_SET_Y_ADDRESS | (uint8_t) (start_index / LCD_WIDTH_IN_CHUNK);
+        
+        hlcd->dma_chain[2 * run]     = (LCD_DMASegment) {hlcd->dma_address[run], 2, 0};
+        hlcd->dma_chain[2 * run + 1] = (LCD_DMASegment) {source + start_index, end_index - start_index, 1};
+    }
     
-    if (end_in_line_update < x_y_in_line_format)
-        end_in_line_update = x_y_in_line_format;
+    if (source == hlcd->dma_snapshot)
+        for (uint16_t i = copy_from; i < end_index; i++)
+            hlcd->dma_snapshot[i] = hlcd->frame[i];
+}
+
+uint8_t _bus_taken(LCD_HandleTypeDef *hlcd) {
+    for (uint8_t i = 0; i < LCD_MAX_INSTANCES && dma_handles[i]; i++)
+        if (dma_handles[i]->hspi == hlcd->hspi && dma_handles[i]->dma_busy)
+            return 1;
+    return 0;
+}
+
+uint8_t _dma_registered(LCD_HandleTypeDef *hlcd) {
+    for (uint8_t i = 0; i < LCD_MAX_INSTANCES && dma_handles[i]; i++)
+        if (dma_handles[i] == hlcd)
+            return 1;
+    return 0;
+}
+
+HAL_StatusTypeDef _start_dma_segment(LCD_HandleTypeDef *hlcd) {
+    LCD_DMASegment *segment = &hlcd->dma_chain[hlcd->dma_segment_index];
+#ifdef LCD_USE_BUS_MONITOR
+    if (hlcd->bus_monitor)
+        hlcd->bus_monitor(hlcd, segment->is_data, segment->data, segment->length);
+#endif
+#ifdef LCD_USE_BUS_STATS
+    //counted ahead, a short transfer may complete and end frame stats before HAL_SPI_Transmit_DMA returns
+    hlcd->bus_stats.transactions++;
+    hlcd->bus_stats.bytes += segment->length;
+#endif
+    HAL_GPIO_WritePin(hlcd->dc_port, hlcd->dc_pin, segment->is_data);
+    HAL_StatusTypeDef status = HAL_SPI_Transmit_DMA(hlcd->hspi, segment->data, segment->length);
+    if (status != HAL_OK) {
+        //rest of chain is dropped, next update resends whole frame
+        if (hlcd->ce_port)
+            HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 1);
+        hlcd->dma_busy  = 0;
+        hlcd->bus_error = 1;
+#ifdef LCD_USE_BUS_STATS
+        hlcd->bus_stats.errors++;
+#endif
+    }
+    return status;
+}
+
+HAL_StatusTypeDef LCDx_update_async(LCD_HandleTypeDef *hlcd) {
+    //completion of a chain could not find an LCD which LCDx_Init_async did not register
+    if (!_dma_registered(hlcd))
+        return HAL_ERROR;
+    //bus may be taken by another LCD sharing it
+    if (LCD_PANEL_IN_RESET(hlcd) || _bus_taken(hlcd) || HAL_SPI_GetState(hlcd->hspi) != HAL_SPI_STATE_READY)
+        return HAL_BUSY;
+    LCD_PROFILE_BEGIN();
+#ifdef LCD_USE_PROFILING
+    uint32_t profile_bytes        = lcd_profile.bytes;
+    uint32_t profile_transactions = lcd_profile.transactions;
+#endif
+    
+    _recover_bus_error(hlcd);
+    _step_effects(hlcd, 0);
+    //DMA chain is laid out for horizontal mode
+    if (hlcd->vertical_addressing) {
+        _queue_command(hlcd, LCD_VERTICAL_DISABLE);
+        hlcd->vertical_addressing = 0;
+    }
+    if (!hlcd->flag.area_changed) {
+        _send_command_frame(hlcd);
+        LCD_PROFILE_END(LCD_PROBE_UPDATE);
+        return HAL_OK;
+    }
+#ifdef LCD_USE_PROFILING
+    LCD_stat_add(&lcd_profile.dirty_bytes, _dirty_bytes(hlcd));
+#endif
+
+#ifdef LCD_USE_BUS_STATS
+    hlcd->frame_start_transactions = hlcd->bus_stats.transactions;
+    hlcd->frame_start_bytes        = hlcd->bus_stats.bytes;
+#endif
+    //pending commands go out blocking ahead of chain
+    _flush_commands(hlcd);
+    hlcd->dma_run_count  = 0;
+    hlcd->dma_collecting = 1;
+    _flush_dirty(hlcd);
+    hlcd->dma_collecting = 0;
     
-    cursor_in_line_update = x_y_in_line_format;
+    if (hlcd->dma_run_count == 0) {
+        LCD_PROFILE_END(LCD_PROBE_UPDATE);
+        return HAL_OK;
+    }
     
+    hlcd->dma_segment_count = 2 * hlcd->dma_run_count;
+    hlcd->dma_segment_index = 0;
+#ifdef LCD_USE_PROFILING
+    //chain is counted as queued, commands flushed before it went out blocking
+    uint32_t chain_bytes = 0;
+    for (uint8_t i = 0; i < hlcd->dma_segment_count; i++)
+        chain_bytes += hlcd->dma_chain[i].length;
+    LCD_stat_add(&lcd_profile.update_bytes, lcd_profile.bytes - profile_bytes + chain_bytes);
+    LCD_stat_add(&lcd_profile.update_transactions,
+                 lcd_profile.transactions - profile_transactions + hlcd->dma_segment_count);
+#endif
+    hlcd->dma_busy          = 1;
+    //CE stays low during whole chain
+    if (hlcd->ce_port)
+        HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 0);
+    HAL_StatusTypeDef status = _start_dma_segment(hlcd);
+    LCD_PROFILE_END(LCD_PROBE_UPDATE);
+    return status == HAL_OK ? HAL_OK : HAL_ERROR;
 }
 
-void LCD_goto_x_y_char_8x6(uint16_t x, uint16_t y) {
-    LCD_goto_x_y_chunk(x * (LCD_Y_MAX_CHUNK + 1), y);
+uint8_t LCDx_is_busy(LCD_HandleTypeDef *hlcd) {
+    return hlcd->dma_busy;
+}
+
+void LCDx_set_update_callback(LCD_HandleTypeDef *hlcd, void (*callback)(LCD_HandleTypeDef *hlcd)) {
+    hlcd->dma_complete_callback = callback;
 }
 
+void LCD_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+    for (uint8_t i = 0; i < LCD_MAX_INSTANCES && dma_handles[i]; i++) {
+        LCD_HandleTypeDef *hlcd = dma_handles[i];
+        if (hlcd->hspi != hspi || !hlcd->dma_busy)
+            continue;
+        
+        if (++hlcd->dma_segment_index < hlcd->dma_segment_count) {
+            //a segment which fails to start ends chain, no completion is reported for it
+            _start_dma_segment(hlcd);
+            return;
+        }
+        if (hlcd->ce_port)
+            HAL_GPIO_WritePin(hlcd->ce_port, hlcd->ce_pin, 1);
+        hlcd->dma_busy = 0;
+#ifdef LCD_USE_BUS_STATS
+        _end_frame_stats(hlcd);
+#endif
+        if (hlcd->dma_complete_callback)
+            hlcd->dma_complete_callback(hlcd);
+        return;
+    }
+}
+#endif
 
-void LCD_write_string(char *str) {
+
+void LCDx_goto_x_y_chunk(LCD_HandleTypeDef *hlcd, uint16_t x, uint16_t y) {
+    //control to not be out of range
+    if (x > LCD_X_MAX_CHUNK || y > LCD_Y_MAX_CHUNK)
+        return;
+    
+    uint16_t x_y_in_line_format = x + y * (LCD_X_MAX_CHUNK + 1);
+    hlcd->cursor_in_line_update = x_y_in_line_format;
+}
+
+void LCDx_goto_x_y_char_8x6(LCD_HandleTypeDef *hlcd, uint16_t x, uint16_t y) {
+    LCDx_goto_x_y_chunk(hlcd, x * (LCD_Y_MAX_CHUNK + 1), y);
+}
+
+
+void LCDx_write_string(LCD_HandleTypeDef *hlcd, char *str) {
     while (*str) {
-        LCD_write_char_8x6(*str);
+        LCDx_write_char_8x6(hlcd, *str);
         str++;
     }
 }
 
-void decompress_into_buffer(uint8_t *compressed_image, uint8_t *LCD_buffer, uint16_t x_start, uint16_t y_start) {
-    //# No marker for LCD_buffer is dedicated. This means whole buffer MUST be refreshed afterwards.
+uint8_t _read_byte(_ImageStream *stream) {
+    if (stream->index >= stream->length) {
+        stream->error = 1;
+        return 0;
+    }
+    return stream->image[stream->index++];
+}
+
+uint16_t _read_count(_ImageStream *stream) {
+    uint16_t count = _read_byte(stream);
+    if (count > 127)
+        count = (count & (uint16_t) 127) + _read_byte(stream);
+    return count;
+}
+
+void _image_stream_open(_ImageStream *stream, uint8_t *compressed_image, uint32_t length) {
     //protocol version = 1
     //For V1 no extra code needed
-    //
-    uint32_t index_compressedImage = 0;
-    uint16_t width_compressedImage;
-    uint16_t height_compressedImage;
-    uint16_t offset_compressedImage;
-    uint8_t  blank_chunk_color;//==1 means dominant color is inverted(pixel's state on ==BLACK)
+    stream->image  = compressed_image;
+    stream->length = length;
+    stream->index  = 0;
+    stream->ended  = 0;
+    stream->error  = 0;
     
     //index 0 = version and inversion state
-    if (compressed_image[index_compressedImage++] == 1)
-        blank_chunk_color = 255;
+    if (_read_byte(stream) == 1)
+        stream->blank_chunk_color = 255;
     else
-        blank_chunk_color      = 0;
+        stream->blank_chunk_color = 0;
     //index 1 & 1+ : width
-    width_compressedImage      = compressed_image[index_compressedImage++];
-    if (width_compressedImage > 127)
-        width_compressedImage  = width_compressedImage & (uint16_t) 127 + compressed_image[index_compressedImage++];
+    stream->width            = _read_count(stream);
     //index 2 & 2+ : height
-    height_compressedImage     = compressed_image[index_compressedImage++];
-    if (height_compressedImage > 127)
-        height_compressedImage = height_compressedImage & (uint16_t) 127 + compressed_image[index_compressedImage++];
-    //index 3 & 3+ : offset
-    offset_compressedImage     = compressed_image[index_compressedImage++];
-    if (offset_compressedImage > 127)
-        offset_compressedImage = offset_compressedImage & (uint16_t) 127 + compressed_image[index_compressedImage++];
+    stream->height           = _read_count(stream);
+    //index 3 & 3+ : offset - image starts with blank chunks
+    stream->blank_left       = _read_count(stream);
+    stream->non_blank_left   = 0;
+    stream->blank_count_next = 0;
+    stream->fragment_empty   = 0;
+    stream->chunks_left      = stream->error ? 0 : (uint32_t) stream->width * stream->height;
+}
+
+uint16_t _image_stream_read(_ImageStream *stream, uint8_t *out, uint16_t count) {
+    if (count > stream->chunks_left)
+        count = (uint16_t) stream->chunks_left;
     
-    //# check margins to not be out of LCD boarder and correct it if needed
-    if (x_start + width_compressedImage > LCD_WIDTH_IN_CHUNK)
-        x_start           = LCD_WIDTH_IN_CHUNK - width_compressedImage;
-    if (y_start + height_compressedImage > LCD_HEIGHT_IN_CHUNK)
-        y_start           = LCD_HEIGHT_IN_CHUNK - height_compressedImage;
-    
-    
-    //todo move variables to top
-    uint16_t non_blank_chunk_count;
-    uint16_t blank_chunk_count;
-    uint16_t index_buffer = (uint16_t) (x_start + y_start * LCD_WIDTH_IN_CHUNK);
-    uint16_t x_end        = x_start + width_compressedImage;
-    uint16_t fragment_first_x_pos;//always becomes 0< x <width of image in each row iteration
-    uint16_t fragment_last_x_pos;
-    uint16_t counter;
-    
-    //write blank chunks to offset part
-    for (counter = 0; counter < offset_compressedImage; counter++)
-        LCD_buffer[index_buffer++] = blank_chunk_color;
-    
-    //# Write down bytes
-    
-    
-    //write fragments
-    fragment_first_x_pos = offset_compressedImage;
-    fragment_last_x_pos  = offset_compressedImage;//will be added with non_blank_chunk_count after extraction
-    do {
-        non_blank_chunk_count     = compressed_image[index_compressedImage];
-        //read non-blank chunks count
-        if (non_blank_chunk_count > 127)
-            non_blank_chunk_count = non_blank_chunk_count & (uint16_t) 127 + compressed_image[index_compressedImage++];
-        fragment_last_x_pos += non_blank_chunk_count;
-        
-        //read blank chunks count
-        blank_chunk_count     = compressed_image[index_compressedImage];
-        if (blank_chunk_count > 127)
-            blank_chunk_count = blank_chunk_count & (uint16_t) 127 + compressed_image[index_compressedImage];
+    //each fragment: non-blank count, non-blank chunks, blank count
+    uint16_t produced = 0;
+    while (produced < count) {
+        uint16_t wanted = count - produced;
         
+        if (stream->ended) {
+            //no more data - rest of image is blank
+            if (out)
+                memset(out + produced, stream->blank_chunk_color, wanted);
+            produced += wanted;
+        } else if (stream->non_blank_left) {
+            uint16_t n = stream->non_blank_left < wanted ? stream->non_blank_left : wanted;
+            if (n > stream->length - stream->index) {
+                //truncated image - chunks still there are kept whatever count was asked, the rest reads as blank
+                n             = (uint16_t) (stream->length - stream->index);
+                stream->error = 1;
+                stream->ended = 1;
+            }
+            if (out)
+                memcpy(out + produced, stream->image + stream->index, n);
+            stream->index += n;
+            stream->non_blank_left -= n;
+            produced += n;
+        } else if (stream->blank_left) {
+            uint16_t n = stream->blank_left < wanted ? stream->blank_left : wanted;
+            if (out)
+                memset(out + produced, stream->blank_chunk_color, n);
+            stream->blank_left -= n;
+            produced += n;
+        } else if (stream->blank_count_next) {
+            stream->blank_count_next = 0;
+            stream->blank_left       = _read_count(stream);
+            //an empty fragment marks end of data
+            stream->ended            = (stream->blank_left == 0 && stream->fragment_empty) || stream->error;
+        } else {
+            stream->non_blank_left   = _read_count(stream);
+            stream->fragment_empty   = stream->non_blank_left == 0;
+            stream->blank_count_next = 1;
+            stream->ended            = stream->error;
+        }
+    }
+    stream->chunks_left -= produced;
+    return produced;
+}
+
+void _place_image(_ImageStream *stream, uint16_t *x_start, uint16_t *y_start, _Box *box) {
+    //# check margins to not be out of LCD boarder and correct it if needed
+    if (stream->width > LCD_WIDTH_IN_CHUNK)
+        *x_start = 0;
+    else if (*x_start + stream->width > LCD_WIDTH_IN_CHUNK)
+        *x_start = LCD_WIDTH_IN_CHUNK - stream->width;
+    if (stream->height > LCD_HEIGHT_IN_CHUNK)
+        *y_start = 0;
+    else if (*y_start + stream->height > LCD_HEIGHT_IN_CHUNK)
+        *y_start = LCD_HEIGHT_IN_CHUNK - stream->height;
+    
+    box->x_low     = (uint8_t) *x_start;
+    box->x_high    = (uint8_t) (stream->width > LCD_WIDTH_IN_CHUNK ? LCD_WIDTH_IN_CHUNK : *x_start + stream->width);
+    box->bank_low  = (uint8_t) *y_start;
+    box->bank_high = (uint8_t) ((stream->height > LCD_HEIGHT_IN_CHUNK ? LCD_HEIGHT_IN_CHUNK : *y_start + stream->height) - 1);
+}
+
+HAL_StatusTypeDef _decompress_image(uint8_t *compressed_image, uint32_t length, uint8_t *LCD_buffer, uint8_t first_bank,
+                                    uint8_t bank_count, uint16_t x_start, uint16_t y_start, _Box *box) {
+    LCD_PROFILE_BEGIN();
+    _ImageStream stream;
+    _image_stream_open(&stream, compressed_image, length);
+    if (stream.error || stream.width == 0 || stream.height == 0) {
+        box->x_low = box->x_high = 0;
+        LCD_PROFILE_END(LCD_PROBE_DECOMPRESS);
+        return HAL_ERROR;
+    }
+    _place_image(&stream, &x_start, &y_start, box);
+    
+    //# Write down bytes row by row, clipped columns are skipped
+    uint16_t visible_width = box->x_high - box->x_low;
+    //rows past the window are still read, so a truncated image fails in every window as it does in a full buffer
+    for (uint8_t bank = box->bank_low; bank <= box->bank_high; bank++) {
+        uint8_t *row = bank < first_bank || bank >= first_bank + bank_count ?
+                       0 : LCD_buffer + x_start + (bank - first_bank) * LCD_WIDTH_IN_CHUNK;
+        _image_stream_read(&stream, row, visible_width);
+        _image_stream_read(&stream, 0, stream.width - visible_width);
+    }
+    LCD_PROFILE_END(LCD_PROBE_DECOMPRESS);
+    return stream.error ? HAL_ERROR : HAL_OK;
+}
+
+void decompress_into_buffer(uint8_t *compressed_image, uint8_t *LCD_buffer, uint16_t x_start, uint16_t y_start) {
+    //# No marker for LCD_buffer is dedicated. This means whole buffer MUST be refreshed afterwards.
+    //image is trusted here, use LCD_decompress_image for a bounded read
+    _Box box;
+    _decompress_image(compressed_image, UINT32_MAX, LCD_buffer, 0, LCD_HEIGHT_IN_CHUNK, x_start, y_start, &box);
+}
+
+HAL_StatusTypeDef LCDx_decompress_image(LCD_HandleTypeDef *hlcd, uint8_t *compressed_image, uint32_t length,
+                                        uint16_t x_start, uint16_t y_start) {
+    _Box              box;
+#ifdef LCD_USE_PAGED_MODE
+    HAL_StatusTypeDef status = _decompress_image(compressed_image, length, hlcd->frame, hlcd->page, 1, x_start, y_start,
+                                                 &box);
+#else
+    HAL_StatusTypeDef status = _decompress_image(compressed_image, length, hlcd->frame, 0, LCD_HEIGHT_IN_CHUNK, x_start,
+                                                 y_start, &box);
+#endif
+    _mark_dirty_area(hlcd, box.x_low, box.x_high, box.bank_low, box.bank_high);
+    return status;
+}
+
+HAL_StatusTypeDef LCDx_stream_compressed_image(LCD_HandleTypeDef *hlcd, uint8_t *compressed_image, uint32_t length,
+                                               uint16_t x_start, uint16_t y_start) {
+    uint8_t      stage[LCD_STREAM_STAGE_SIZE];
+    _ImageStream stream;
+    _Box         box;
+    _image_stream_open(&stream, compressed_image, length);
+    if (stream.error || stream.width == 0 || stream.height == 0)
+        return HAL_ERROR;
+    _place_image(&stream, &x_start, &y_start, &box);
+    if (LCD_PANEL_IN_RESET(hlcd))
+        return HAL_BUSY;
+
+    _wait_for_bus(hlcd);
+    //a failed transfer left the panel in an unknown mode, the commands below must reach it in basic mode
+    _recover_bus_error(hlcd);
+    //wakes a powered down panel like an update does
+    _step_effects(hlcd, 1);
+    if (hlcd->vertical_addressing) {
+        _queue_command(hlcd, LCD_VERTICAL_DISABLE);
+        hlcd->vertical_addressing = 0;
+    }
+    
+    uint16_t visible_width = box.x_high - box.x_low;
+    for (uint8_t bank = box.bank_low; bank <= box.bank_high; bank++) {
+        uint16_t index = x_start + bank * LCD_WIDTH_IN_CHUNK;
+        //full-width rows are contiguous in LCD RAM, one address is enough for all of them
+        if (bank == box.bank_low || visible_width != LCD_WIDTH_IN_CHUNK) {
+            _queue_command(hlcd, LCD_SET_X_ADDRESS | (uint8_t) x_start);
+            _queue_command(hlcd, LCD_SET_Y_ADDRESS | bank);
+        }
+        _flush_commands(hlcd);
         
-        //write chunk bytes to buffer
-        
-        //# Ver2
-        uint16_t rows        = (uint16_t) (fragment_last_x_pos / width_compressedImage);
-        uint16_t current_row = 0;
-        do {
-            uint16_t k;
-            if (current_row == rows)
-                //process last row in multiple rows beside single row
-                k = fragment_last_x_pos % width_compressedImage - (uint16_t) (rows == 0) * fragment_first_x_pos;
-            else
-                k = current_row == 0 ? width_compressedImage - fragment_first_x_pos : width_compressedImage;
-            
-            for (uint16_t counter2 = 0; counter2 < k; counter2++)
-                LCD_buffer[index_buffer++] = compressed_image[index_compressedImage++];
-            //if there is just single row or we are in last row then don't goto head of next non-existing line
-            index_buffer += (uint16_t) (current_row < rows) * LCD_WIDTH_IN_CHUNK - width_compressedImage;
-            //todo blank and improve non-blank
-        } while (current_row++ < rows);
-        fragment_first_x_pos = fragment_last_x_pos % width_compressedImage;
-        fragment_last_x_pos =
-                blank_chunk_count != 0 ? fragment_first_x_pos + blank_chunk_count : width_compressedImage;
-        
-        //# blanks
-        rows                 = (uint16_t) (fragment_last_x_pos / width_compressedImage);
-        current_row          = 0;
-        do {
-            uint16_t k;
-            if (current_row == rows)
-                //process last row in multiple rows beside single row
-                k = fragment_last_x_pos % width_compressedImage - (uint16_t) (rows == 0) * fragment_first_x_pos;
-            else
-                k = current_row == 0 ? width_compressedImage - fragment_first_x_pos : width_compressedImage;
-            
-            for (uint16_t counter2 = 0; counter2 < k; counter2++)
-                LCD_buffer[index_buffer++] = blank_chunk_color;
-            //if there is just single row or we are in last row then don't goto head of next non-existing line
-            index_buffer += (uint16_t) (current_row < rows) * LCD_WIDTH_IN_CHUNK - width_compressedImage;
-            //todo blank and improve non-blank
-        } while (current_row++ < rows);
-        //fixme
-        fragment_first_x_pos = fragment_last_x_pos % width_compressedImage;
-        fragment_last_x_pos =
-                blank_chunk_count != 0 ? fragment_first_x_pos + blank_chunk_count : width_compressedImage;
-        
-    } while (blank_chunk_count == 0);
+        uint16_t left = visible_width;
+        while (left) {
+            uint16_t count = _image_stream_read(&stream, stage, left < LCD_STREAM_STAGE_SIZE ? left : LCD_STREAM_STAGE_SIZE);
+            if (count == 0)
+                break;
+            _spi_transmit(hlcd, 1, stage, count);
+#ifdef LCD_USE_SHADOW_BUFFER
+            memcpy(hlcd->shadow_buffer + index, stage, count);
+#endif
+            index += count;
+            left  -= count;
+        }
+        _image_stream_read(&stream, 0, stream.width - visible_width);
+    }
+    return stream.error ? HAL_ERROR : HAL_OK;
 }
 
 //todo remove or improve(little image but full buffer-->bad image)
-void LCD_write_full_pic(uint8_t full_pic[]) {
-    LCD_goto_x_y_chunk(0, 0);
+void LCDx_write_full_pic(LCD_HandleTypeDef *hlcd, uint8_t full_pic[]) {
+    LCDx_goto_x_y_chunk(hlcd, 0, 0);
     int n;
     for (n = 0; n < LCD_BUFFER_SIZE; n++)
-        buffer[n] = full_pic[n];
-    cursor_in_line_update  = n;
-    if (cursor_in_line_update > end_in_line_update)
-        end_in_line_update = cursor_in_line_update;
-    buffer_flag.in_line_changed = 1;
+        if (LCD_BUFFER_HOLDS(hlcd, n))
+            hlcd->frame[LCD_BUFFER_INDEX(hlcd, n)] = full_pic[n];
+    hlcd->cursor_in_line_update = n;
+    _mark_dirty_area(hlcd, 0, LCD_WIDTH_IN_CHUNK, 0, LCD_Y_MAX_CHUNK);
+}
+
+void LCDx_mark_dirty(LCD_HandleTypeDef *hlcd, uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    if (x > LCD_X_MAX_CHUNK || y > LCD_Y_MAX_CHUNK || width == 0 || height == 0)
+        return;
+    uint8_t x_high    = width > LCD_WIDTH_IN_CHUNK - x ? LCD_WIDTH_IN_CHUNK : x + width;
+    uint8_t bank_high = height > LCD_HEIGHT_IN_CHUNK - y ? LCD_Y_MAX_CHUNK : y + height - 1;
+    _mark_dirty_area(hlcd, x, x_high, y, bank_high);
+}
+
+#ifndef LCD_USE_PAGED_MODE
+void LCDx_attach_frame(LCD_HandleTypeDef *hlcd, const uint8_t *frame) {
+    //frame may be in flash - it is only written if caller draws into it
+    hlcd->frame = frame ? (uint8_t *) frame : hlcd->buffer;
+    _mark_dirty_area(hlcd, 0, LCD_WIDTH_IN_CHUNK, 0, LCD_Y_MAX_CHUNK);
+}
+
+uint8_t *LCDx_get_frame(LCD_HandleTypeDef *hlcd) {
+    return hlcd->frame;
+}
+#endif
+
+//default instance wrappers
+
+HAL_StatusTypeDef LCD_Init(uint8_t contrast) {
+    return LCDx_Init(&hlcd1, contrast);
+}
+
+HAL_StatusTypeDef LCD_Init_async(uint8_t contrast) {
+    return LCDx_Init_async(&hlcd1, contrast);
+}
+
+HAL_StatusTypeDef LCD_Init_step(void) {
+    return LCDx_Init_step(&hlcd1);
+}
+
+uint8_t LCD_is_ready(void) {
+    return LCDx_is_ready(&hlcd1);
+}
+
+void LCD_invert(uint8_t inverted) {
+    LCDx_invert(&hlcd1, inverted);
+}
+
+void LCD_blank(uint8_t blank) {
+    LCDx_blank(&hlcd1, blank);
+}
+
+void LCD_flash(uint16_t period_ms, uint32_t duration_ms) {
+    LCDx_flash(&hlcd1, period_ms, duration_ms);
+}
+
+void LCD_blink(uint16_t period_ms, uint32_t duration_ms) {
+    LCDx_blink(&hlcd1, period_ms, duration_ms);
+}
+
+void LCD_stop_effect(void) {
+    LCDx_stop_effect(&hlcd1);
+}
+
+void LCD_set_idle_power_down(uint32_t idle_ms) {
+    LCDx_set_idle_power_down(&hlcd1, idle_ms);
+}
+
+uint8_t LCD_is_powered_down(void) {
+    return LCDx_is_powered_down(&hlcd1);
+}
+
+void LCD_clear(void) {
+    LCDx_clear(&hlcd1);
+}
+
+void LCD_update(void) {
+    LCDx_update(&hlcd1);
+}
+
+void LCD_goto_x_y_chunk(uint16_t x, uint16_t y) {
+    LCDx_goto_x_y_chunk(&hlcd1, x, y);
+}
+
+void LCD_goto_x_y_char_8x6(uint16_t x, uint16_t y) {
+    LCDx_goto_x_y_char_8x6(&hlcd1, x, y);
+}
+
+void LCD_write_char_8x6(uint8_t chr) {
+    LCDx_write_char_8x6(&hlcd1, chr);
+}
+
+void LCD_write_string(char *str) {
+    LCDx_write_string(&hlcd1, str);
+}
+
+void LCD_write_full_pic(uint8_t full_pic[]) {
+    LCDx_write_full_pic(&hlcd1, full_pic);
+}
+
+void LCD_mark_dirty(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    LCDx_mark_dirty(&hlcd1, x, y, width, height);
+}
+
+#ifndef LCD_USE_PAGED_MODE
+void LCD_attach_frame(const uint8_t *frame) {
+    LCDx_attach_frame(&hlcd1, frame);
+}
+
+uint8_t *LCD_get_frame(void) {
+    return LCDx_get_frame(&hlcd1);
+}
+#endif
+
+#ifdef LCD_USE_PAGED_MODE
+void LCD_set_draw_callback(void (*draw)(LCD_HandleTypeDef *hlcd, uint8_t bank)) {
+    LCDx_set_draw_callback(&hlcd1, draw);
+}
+#endif
+
+HAL_StatusTypeDef LCD_decompress_image(uint8_t *compressed_image, uint32_t length, uint16_t x_start, uint16_t y_start) {
+    return LCDx_decompress_image(&hlcd1, compressed_image, length, x_start, y_start);
+}
+
+HAL_StatusTypeDef LCD_stream_compressed_image(uint8_t *compressed_image, uint32_t length, uint16_t x_start,
+                                              uint16_t y_start) {
+    return LCDx_stream_compressed_image(&hlcd1, compressed_image, length, x_start, y_start);
+}
+
+#ifdef LCD_USE_DMA
+HAL_StatusTypeDef LCD_update_async(void) {
+    return LCDx_update_async(&hlcd1);
+}
+
+uint8_t LCD_is_busy(void) {
+    return LCDx_is_busy(&hlcd1);
+}
+
+void LCD_set_update_callback(void (*callback)(LCD_HandleTypeDef *hlcd)) {
+    LCDx_set_update_callback(&hlcd1, callback);
+}
+#endif
+
+#ifdef LCD_USE_BUS_STATS
+void LCD_get_bus_stats(LCD_BusStats *stats) {
+    LCDx_get_bus_stats(&hlcd1, stats);
+}
+
+void LCD_reset_bus_stats(void) {
+    LCDx_reset_bus_stats(&hlcd1);
+}
+#endif
+
+#ifdef LCD_USE_BUS_MONITOR
+void LCD_set_bus_monitor(void (*monitor)(LCD_HandleTypeDef *hlcd, uint8_t is_data, const uint8_t *data, uint16_t length)) {
+    LCDx_set_bus_monitor(&hlcd1, monitor);
 }
+#endif
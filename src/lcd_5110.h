@@ -15,12 +15,637 @@ extern "C"
 
 #include "userconf.h"
 
+#define LCD_WIDTH_IN_CHUNK                      84
+#define LCD_HEIGHT_IN_CHUNK                     6
+#define LCD_BUFFER_SIZE                         504 // == 84*48/8
+
+#ifdef LCD_USE_PAGED_MODE
+#if defined(LCD_USE_SHADOW_BUFFER) || defined(LCD_USE_DMA)
+#error "LCD_USE_PAGED_MODE keeps no full frame, it cannot be combined with LCD_USE_SHADOW_BUFFER or LCD_USE_DMA"
+#endif
+//buffer holds a single bank, the one being rendered
+#define LCD_FRAME_BUFFER_SIZE                   LCD_WIDTH_IN_CHUNK
+#define LCD_BUFFER_HOLDS(hlcd, index)           ((uint16_t) ((index) - (hlcd)->page * LCD_WIDTH_IN_CHUNK) < LCD_WIDTH_IN_CHUNK)
+#define LCD_BUFFER_INDEX(hlcd, index)           ((index) - (hlcd)->page * LCD_WIDTH_IN_CHUNK)
+#define LCD_HELD_BANK_LOW(hlcd)                 ((hlcd)->page)
+#define LCD_HELD_BANK_HIGH(hlcd)                ((hlcd)->page)
+#else
+//buffer holds whole frame, accessors compile to plain indexing
+#define LCD_FRAME_BUFFER_SIZE                   LCD_BUFFER_SIZE
+#define LCD_BUFFER_HOLDS(hlcd, index)           1
+#define LCD_BUFFER_INDEX(hlcd, index)           (index)
+#define LCD_HELD_BANK_LOW(hlcd)                 0
+#define LCD_HELD_BANK_HIGH(hlcd)                (LCD_HEIGHT_IN_CHUNK - 1)
+#endif
+
+//consecutive command bytes are collected and sent in one DC-low transaction
+#define LCD_COMMAND_QUEUE_SIZE                  12
+
+//column-shaped updates are gathered in vertical order, then sent in pieces of this size
+#define LCD_VERTICAL_STAGE_SIZE                 48
+
+//compressed images are streamed to LCD through a staging buffer of this size on stack
+#ifndef LCD_STREAM_STAGE_SIZE
+#define LCD_STREAM_STAGE_SIZE                   16
+#endif
+
+#ifdef LCD_USE_DMA
+#ifndef LCD_DMA_MAX_RUNS
+#define LCD_DMA_MAX_RUNS                        12
+#endif
+//max count of handles served by LCD_SPI_TxCpltCallback
+#ifndef LCD_MAX_INSTANCES
+#define LCD_MAX_INSTANCES                       4
+#endif
+#endif
+
+//fixed cost of an SPI transaction besides its bytes (DC/CE toggles, HAL call) in ns - tune it to your MCU, e.g. from
+//LCD_PROBE_SPI_SEND cycles of a one-byte send
+#ifndef LCD_TRANSACTION_OVERHEAD_NS
+#define LCD_TRANSACTION_OVERHEAD_NS             3000
+#endif
+
+//dirty spans are marked by drawing in any context and taken by updates which may run in an interrupt
+//(scheduler, DMA completion) - both sides hold interrupts off, nesting keeps an already masked caller masked
+#ifndef LCD_ENTER_CRITICAL
+#define LCD_ENTER_CRITICAL()                    uint32_t lcd_primask = __get_PRIMASK(); __disable_irq()
+#define LCD_EXIT_CRITICAL()                     __set_PRIMASK(lcd_primask)
+#endif
+
+#ifdef LCD_USE_BUS_STATS
+/**
+ * @brief SPI bus usage of LCD driver
+ */
+typedef struct {
+    uint32_t frames;                  //updates which sent something
+    uint32_t transactions;            //total SPI transactions (each one toggles DC and pays HAL setup)
+    uint32_t bytes;                   //total bytes, commands and data
+    uint16_t last_frame_transactions; //transactions of last update
+    uint16_t last_frame_bytes;        //bytes of last update
+    uint32_t mode_commands;           //display control and power down commands of effects and idle policy
+    uint32_t errors;                  //failed transfers, each makes next update resend whole frame
+} LCD_BusStats;
+#endif
+
+#ifdef LCD_USE_PROFILING
+//cycle counter read by probes - define it in userconf.h to profile on a host or another core
+#ifndef LCD_PROFILE_CYCLES
+#define LCD_PROFILE_CYCLES()                    (DWT->CYCCNT)
+#endif
+
+/**
+ * @brief count, min, max and sum of a measured value - see LCD_stat_average
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} LCD_Stat;
+
+/**
+ * @brief driver functions measured in cycles
+ */
+typedef enum {
+    LCD_PROBE_UPDATE = 0,//LCDx_update and LCDx_update_async calls
+    LCD_PROBE_SPI_SEND,//blocking SPI transactions
+    LCD_PROBE_GLYPH,//LCDx_write_char_8x6, LCDx_draw_char and LCDx_draw_glyph
+    LCD_PROBE_DECOMPRESS,//decompress_into_buffer and LCDx_decompress_image
+    LCD_PROBE_COUNT
+} LCD_Probe;
+
+/**
+ * @brief profile of all LCDs driven by the driver
+ */
+typedef struct {
+    LCD_Stat cycles[LCD_PROBE_COUNT];//cycles per call of each probe
+    LCD_Stat update_bytes;//bytes per update which sent something, commands and data
+    LCD_Stat update_transactions;//SPI transactions per update which sent something
+    LCD_Stat dirty_bytes;//size of dirty region at start of update, in bytes of buffer
+    uint32_t bytes;//running count of bytes sent by blocking transactions
+    uint32_t transactions;//running count of blocking transactions
+} LCD_Profile;
+
+//!profile filled by probes, read it by LCD_get_profile
+extern LCD_Profile lcd_profile;
+
+//probes around measured code, LCD_PROFILE_END must see the LCD_PROFILE_BEGIN of the same block
+#define LCD_PROFILE_BEGIN()                     uint32_t lcd_profile_start = LCD_PROFILE_CYCLES()
+#define LCD_PROFILE_END(probe)                  LCD_stat_add(&lcd_profile.cycles[probe], LCD_PROFILE_CYCLES() - lcd_profile_start)
+#else
+#define LCD_PROFILE_BEGIN()
+#define LCD_PROFILE_END(probe)
+#endif
+
+/**
+ * @brief steps of LCDx_Init_step - panel takes no commands before LCD_INIT_FIRST_FRAME
+ */
+typedef enum {
+    LCD_INIT_DONE = 0,//panel is running
+    LCD_INIT_FIRST_FRAME,//commands and first frame wait for the bus
+    LCD_INIT_SETTLE,//reset released, 10 us before commands
+    LCD_INIT_RESET_PULSE,//reset pulse, 1000 us low
+    LCD_INIT_RESET_HIGH,//reset released, 100 us
+    LCD_INIT_RESET_LOW//reset held low, 100 us
+} LCD_InitState;
+
+/**
+ * @brief timed full-screen effects done by display control command of panel, buffer is left alone
+ */
+typedef enum {
+    LCD_EFFECT_NONE = 0,
+    LCD_EFFECT_FLASH,//all segments on every other half period
+    LCD_EFFECT_BLINK//blank every other half period
+} LCD_Effect;
+
+#ifdef LCD_USE_DMA
+/**
+ * @brief one piece of DMA transfer chain, DC pin is set before each segment starts
+ */
+typedef struct {
+    uint8_t  *data;
+    uint16_t length;
+    uint8_t  is_data;
+} LCD_DMASegment;
+#endif
+
+/**
+ * @brief state of one LCD panel - pins, buffer and dirty tracking
+ * @note fill the first fields by LCD_HANDLE_INIT and leave the rest to LCDx_Init
+ */
+typedef struct __LCD_HandleTypeDef {
+    SPI_HandleTypeDef *hspi;
+    GPIO_TypeDef      *dc_port;
+    uint16_t          dc_pin;
+    GPIO_TypeDef      *reset_port;
+    uint16_t          reset_pin;
+    GPIO_TypeDef      *ce_port;//0 if CE is tied low or driven by hardware NSS
+    uint16_t          ce_pin;
+    
+    //Display Buffer - in paged mode only bank `page` (x + y * LCD_WIDTH_IN_CHUNK indexes go through LCD_BUFFER_INDEX)
+    uint8_t  buffer[LCD_FRAME_BUFFER_SIZE];
+    //frame drawn into and sent - buffer, or an external frame attached by LCDx_attach_frame
+    uint8_t  *frame;
+#ifdef LCD_USE_PAGED_MODE
+    uint8_t  page;
+    void (*draw_callback)(struct __LCD_HandleTypeDef *hlcd, uint8_t bank);
+#endif
+    //changed area of buffer - one column span per bank, [low, high) in chunks; low >= high means clean bank
+    uint8_t  dirty_low[LCD_HEIGHT_IN_CHUNK];
+    uint8_t  dirty_high[LCD_HEIGHT_IN_CHUNK];
+#ifndef LCD_USE_PAGED_MODE
+    //dirty spans taken by the update being sent - drawing meanwhile marks dirty spans again for next update
+    uint8_t  send_low[LCD_HEIGHT_IN_CHUNK];
+    uint8_t  send_high[LCD_HEIGHT_IN_CHUNK];
+#endif
+    //text cursor in buffer (in-line format: x + y * LCD_WIDTH_IN_CHUNK)
+    uint16_t cursor_in_line_update;
+    
+    struct {
+        uint8_t area_changed : 1;//set when at least one bank has a dirty span
+    } flag;
+    //current addressing mode of LCD - written by update only, kept out of flag which drawing writes from any context
+    uint8_t  vertical_addressing;
+    //set by a layer change until LCDx_composite, frame does not show its marks yet and scheduler holds it back
+    volatile uint8_t composing;
+    
+    //start-up sequence of LCDx_Init_async - LCD_InitState, DWT->CYCCNT at start of current step, contrast to set
+    volatile uint8_t init_state;
+    uint32_t         init_mark;
+    uint8_t          init_contrast;
+    
+    //display effects and idle power down, times from HAL_GetTick
+    uint8_t  inverted;
+    uint8_t  blanked;
+    uint8_t  effect;//LCD_Effect running
+    uint16_t effect_period;//ms of one on/off cycle
+    uint32_t effect_duration;//ms, 0 runs until LCDx_stop_effect
+    uint32_t effect_start;
+    uint8_t  shown_control;//display control command last queued to panel
+    uint8_t  powered_down;
+    uint32_t idle_timeout;//ms without traffic before power down, 0 never
+    uint32_t last_activity;
+    
+    uint8_t command_queue[LCD_COMMAND_QUEUE_SIZE];
+    uint8_t command_queue_length;
+    uint8_t bus_error;//a transfer failed, next update brings panel back to a known state
+#ifndef LCD_USE_PAGED_MODE
+    uint8_t vertical_stage[LCD_VERTICAL_STAGE_SIZE];
+#endif
+
+#ifdef LCD_USE_SHADOW_BUFFER
+    //copy of the frame last sent to LCD - only valid after first full update
+    uint8_t shadow_buffer[LCD_BUFFER_SIZE];
+    uint8_t shadow_valid;
+#endif
+
+#ifdef LCD_USE_DMA
+    LCD_DMASegment   dma_chain[2 * LCD_DMA_MAX_RUNS];
+    uint8_t          dma_address[LCD_DMA_MAX_RUNS][2];//X/Y command pair of each run
+    uint8_t          dma_run_count;
+    uint8_t          dma_collecting;//runs are queued to dma_chain instead of being sent
+    volatile uint8_t dma_segment_count;
+    volatile uint8_t dma_segment_index;
+    volatile uint8_t dma_busy;
+    void (*dma_complete_callback)(struct __LCD_HandleTypeDef *hlcd);
+#ifndef LCD_USE_SHADOW_BUFFER
+    //snapshot of sent runs, buffer stays free for drawing while DMA is in flight
+    uint8_t dma_snapshot[LCD_BUFFER_SIZE];
+#endif
+#endif
+
+#ifdef LCD_USE_BUS_STATS
+    LCD_BusStats bus_stats;
+    uint32_t     frame_start_transactions;
+    uint32_t     frame_start_bytes;
+#endif
+
+#ifdef LCD_USE_BUS_MONITOR
+    //sees every transaction as it starts, e.g. to feed an LCD_Emulator
+    void (*bus_monitor)(struct __LCD_HandleTypeDef *hlcd, uint8_t is_data, const uint8_t *data, uint16_t length);
+#endif
+} LCD_HandleTypeDef;
+
+/**
+ * @brief static initializer of LCD_HandleTypeDef
+ * @note e.g. LCD_HandleTypeDef hlcd2 = LCD_HANDLE_INIT(&hspi2, LCD2_DC_GPIO_Port, LCD2_DC_Pin, LCD2_RESET_GPIO_Port, LCD2_RESET_Pin, LCD2_CE_GPIO_Port, LCD2_CE_Pin);
+ */
+#define LCD_HANDLE_INIT(spi, dc_gpio_port, dc_gpio_pin, reset_gpio_port, reset_gpio_pin, ce_gpio_port, ce_gpio_pin) \
+    {.hspi = (spi), .dc_port = (dc_gpio_port), .dc_pin = (dc_gpio_pin),                                            \
+     .reset_port = (reset_gpio_port), .reset_pin = (reset_gpio_pin), .ce_port = (ce_gpio_port), .ce_pin = (ce_gpio_pin)}
+
+//!default LCD instance used by LCD_* functions - wired to LCD_SPI_Handler, LCD_DC and LCD_RESET pins
+extern LCD_HandleTypeDef hlcd1;
+
+/**
+ * @brief Initializes LCD - MUST BE call as soon as possible- Reset pin must be low as default
+ * @param hlcd LCD handle
+ * @param contrast set contrast of LCD 0-127
+ * @return HAL_ERROR if LCD_USE_DMA already serves LCD_MAX_INSTANCES other LCDs - nothing is touched then - else HAL_OK
+ */
+HAL_StatusTypeDef LCDx_Init(LCD_HandleTypeDef *hlcd, uint8_t contrast);
+
+/**
+ * @brief starts initializing LCD and returns at once - step it by LCDx_Init_step until it returns HAL_OK
+ * @param hlcd LCD handle
+ * @param contrast set contrast of LCD 0-127
+ * @note buffer is cleared and may be drawn into right away, updates wait and whole buffer is sent as first frame
+ * @return HAL_ERROR if LCD_USE_DMA already serves LCD_MAX_INSTANCES other LCDs - nothing is touched then - else HAL_OK
+ * @note needs initializeDWTtimer, reset pulses are timed by DWT->CYCCNT
+ */
+HAL_StatusTypeDef LCDx_Init_async(LCD_HandleTypeDef *hlcd, uint8_t contrast);
+
+/**
+ * @brief advances initialization started by LCDx_Init_async as far as elapsed time allows, never waits
+ * @param hlcd LCD handle
+ * @return HAL_BUSY while initialization goes on, HAL_OK once commands and first frame are sent (or started by DMA)
+ * @note call it from main loop or a timer, e.g. a running LCD_Scheduler steps it - not from both
+ */
+HAL_StatusTypeDef LCDx_Init_step(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief checks whether initialization is finished
+ * @param hlcd LCD handle
+ * @return 1 when LCD is running, 0 during LCDx_Init_async sequence
+ */
+uint8_t LCDx_is_ready(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief shows buffer inverted, by one display control command instead of resending it
+ * @param hlcd LCD handle
+ * @param inverted 1 for light pixels on dark, 0 for normal
+ * @note like all effects it takes a byte on the next update, buffer and its dirty spans are left alone
+ */
+void LCDx_invert(LCD_HandleTypeDef *hlcd, uint8_t inverted);
+
+/**
+ * @brief blanks display keeping its content, unblanking shows it again without resending
+ * @param hlcd LCD handle
+ * @param blank 1 to blank, 0 to show
+ */
+void LCDx_blank(LCD_HandleTypeDef *hlcd, uint8_t blank);
+
+/**
+ * @brief flashes whole display, all segments on for first half of every period
+ * @param hlcd LCD handle
+ * @param period_ms on/off cycle, at least 2
+ * @param duration_ms run time, 0 flashes until LCDx_stop_effect
+ * @note effects advance on each update, call LCDx_update at least twice a period or run an LCD_Scheduler
+ */
+void LCDx_flash(LCD_HandleTypeDef *hlcd, uint16_t period_ms, uint32_t duration_ms);
+
+/**
+ * @brief blinks display, blank for first half of every period
+ * @param hlcd LCD handle
+ * @param period_ms on/off cycle, at least 2
+ * @param duration_ms run time, 0 blinks until LCDx_stop_effect
+ */
+void LCDx_blink(LCD_HandleTypeDef *hlcd, uint16_t period_ms, uint32_t duration_ms);
+
+/**
+ * @brief stops flash or blink, display goes back to its inverted and blank settings
+ * @param hlcd LCD handle
+ */
+void LCDx_stop_effect(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief powers panel down after a time without updates, the next update with something to send wakes it
+ * @param hlcd LCD handle
+ * @param idle_ms time without traffic before power down, 0 keeps panel on
+ * @note RAM is not cleared before power down as datasheet suggests - panel keeps it, so waking takes a single
+ *       function set byte instead of a full frame, for a few uA more in power down
+ * @note nothing powers down while flash or blink runs
+ */
+void LCDx_set_idle_power_down(LCD_HandleTypeDef *hlcd, uint32_t idle_ms);
+
+/**
+ * @brief checks whether panel is powered down by idle policy
+ * @param hlcd LCD handle
+ * @return 1 if powered down
+ */
+uint8_t LCDx_is_powered_down(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief advances effects and idle policy, commands they need go out with the next update
+ * @param hlcd LCD handle
+ * @note updates call it themselves, e.g. a running LCD_Scheduler calls it every tick
+ */
+void LCDx_step_effects(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief clears whole buffer
+ * @param hlcd LCD handle
+ */
+void LCDx_clear(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief updates LCD smartly - updates LCD with changed part of buffer
+ * @param hlcd LCD handle
+ * @note does nothing while LCDx_Init_async sequence holds LCD in reset, changes are sent as first frame
+ * @note waits for a DMA chain of any LCD on the same bus before selecting this one
+ * @note a failed transfer makes next update set addressing mode, display mode and whole frame again
+ */
+void LCDx_update(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief goto 8-bit chunck in buffer area
+ * @param hlcd LCD handle
+ * @param x x of chunk
+ * @param y y of chunk
+ */
+void LCDx_goto_x_y_chunk(LCD_HandleTypeDef *hlcd, uint16_t x, uint16_t y);
+
+/**
+ * @brief goto 8x6 pixel char in buffer
+ * @param hlcd LCD handle
+ * @param x x of char
+ * @param y y of char
+ */
+void LCDx_goto_x_y_char_8x6(LCD_HandleTypeDef *hlcd, uint16_t x, uint16_t y);
+
+/**
+ * @brief write an ascii character in current cursor of buffer (cursor also goes forward)
+ * @param hlcd LCD handle
+ * @param chr ' ' to '~', others are written as ' '
+ */
+void LCDx_write_char_8x6(LCD_HandleTypeDef *hlcd, uint8_t chr);
+
+/**
+ * @brief write ascii based string in buffer
+ * @param hlcd LCD handle
+ * @param str an array of chars
+ */
+void LCDx_write_string(LCD_HandleTypeDef *hlcd, char *str);
+
+/**
+ * @brief copy a full 504-byte picture into buffer
+ * @param hlcd LCD handle
+ * @param full_pic picture in x-y chunk format
+ */
+void LCDx_write_full_pic(LCD_HandleTypeDef *hlcd, uint8_t full_pic[]);
+
+/**
+ * @brief decompress an image into buffer and mark its rectangle as changed
+ * @param hlcd LCD handle
+ * @param compressed_image image compressed by BICTES
+ * @param length size of compressed image in bytes - nothing beyond it is read
+ * @param x_start x of image in chunks
+ * @param y_start y of image in banks
+ * @return HAL_ERROR if image is truncated or malformed (decoded part is kept), otherwise HAL_OK
+ * @note image is moved inside LCD border, parts bigger than LCD are clipped
+ */
+HAL_StatusTypeDef LCDx_decompress_image(LCD_HandleTypeDef *hlcd, uint8_t *compressed_image, uint32_t length,
+                                        uint16_t x_start, uint16_t y_start);
+
+/**
+ * @brief decompress an image straight to LCD RAM, bank by bank, without passing through buffer
+ * @param hlcd LCD handle
+ * @param compressed_image image compressed by BICTES
+ * @param length size of compressed image in bytes - nothing beyond it is read
+ * @param x_start x of image in chunks
+ * @param y_start y of image in banks
+ * @return HAL_ERROR if image is truncated or malformed, HAL_BUSY if LCD is still initializing, otherwise HAL_OK
+ * @note buffer is left untouched, so later updates of the same area overwrite the image
+ * @note not a frame - its bytes and transactions add to bus stats totals, but frames, last frame counters and the
+ *       update and decompress probes of profiling are left alone
+ */
+HAL_StatusTypeDef LCDx_stream_compressed_image(LCD_HandleTypeDef *hlcd, uint8_t *compressed_image, uint32_t length,
+                                               uint16_t x_start, uint16_t y_start);
+
+/**
+ * @brief marks a rectangle as changed, for frames modified without the drawing functions
+ * @param hlcd LCD handle
+ * @param x left of rectangle in chunks 0-83
+ * @param y top of rectangle in banks 0-5
+ * @param width width in chunks - clipped at right edge
+ * @param height height in banks - clipped at bottom edge
+ */
+void LCDx_mark_dirty(LCD_HandleTypeDef *hlcd, uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+
+#ifndef LCD_USE_PAGED_MODE
+/**
+ * @brief draws into and sends from a caller-owned 504-byte frame instead of own buffer - no copy is made
+ * @param hlcd LCD handle
+ * @param frame frame to show, may live in flash; 0 goes back to own buffer
+ * @note whole frame is marked as changed, with LCD_USE_SHADOW_BUFFER only bytes differing from LCD are sent
+ * @note drawing functions write into attached frame - do not draw while a read-only frame is attached
+ * @note with LCD_USE_DMA a frame is sent in place, keep it intact until LCDx_is_busy returns 0
+ */
+void LCDx_attach_frame(LCD_HandleTypeDef *hlcd, const uint8_t *frame);
+
+/**
+ * @brief gets frame currently drawn into and sent
+ * @param hlcd LCD handle
+ * @return attached frame or own buffer
+ */
+uint8_t *LCDx_get_frame(LCD_HandleTypeDef *hlcd);
+#endif
+
+#ifdef LCD_USE_PAGED_MODE
+/**
+ * @brief sets function drawing the screen - every LCDx_update calls it once per bank with only that bank in buffer
+ * @param hlcd LCD handle
+ * @param draw draws into bank `bank` (pixel rows bank*8 .. bank*8+7) - writes outside it are dropped
+ */
+void LCDx_set_draw_callback(LCD_HandleTypeDef *hlcd, void (*draw)(LCD_HandleTypeDef *hlcd, uint8_t bank));
+#endif
+
+#ifdef LCD_USE_DMA
+/**
+ * @brief starts updating LCD with changed part of buffer by DMA and returns immediately
+ * @param hlcd LCD handle
+ * @return HAL_BUSY if previous frame (of this LCD or another one on the same bus) is still in flight or LCD is still
+ *         initializing, HAL_ERROR if LCD was not set up by LCDx_Init or the chain failed to start, otherwise HAL_OK
+ * @note changed parts are snapshot before start, so drawing into buffer may go on during transfer
+ */
+HAL_StatusTypeDef LCDx_update_async(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief checks whether an asynchronous update is in flight
+ * @param hlcd LCD handle
+ * @return 1 while DMA transfer chain is running, 0 otherwise
+ */
+uint8_t LCDx_is_busy(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief sets function called (in interrupt context) when an asynchronous update completes
+ * @param hlcd LCD handle
+ * @param callback function to be called, 0 to disable
+ */
+void LCDx_set_update_callback(LCD_HandleTypeDef *hlcd, void (*callback)(LCD_HandleTypeDef *hlcd));
+#endif
+
+#ifdef LCD_USE_BUS_STATS
+/**
+ * @brief copies SPI bus usage counters
+ * @param hlcd LCD handle
+ * @param stats destination of counters
+ */
+void LCDx_get_bus_stats(LCD_HandleTypeDef *hlcd, LCD_BusStats *stats);
+
+/**
+ * @brief resets SPI bus usage counters
+ * @param hlcd LCD handle
+ */
+void LCDx_reset_bus_stats(LCD_HandleTypeDef *hlcd);
+#endif
+
+#ifdef LCD_USE_BUS_MONITOR
+/**
+ * @brief sets function seeing every SPI transaction of LCD, with its DC level
+ * @param hlcd LCD handle
+ * @param monitor function to be called, 0 to disable - runs in interrupt context for DMA segments after the first
+ */
+void LCDx_set_bus_monitor(LCD_HandleTypeDef *hlcd,
+                          void (*monitor)(LCD_HandleTypeDef *hlcd, uint8_t is_data, const uint8_t *data, uint16_t length));
+#endif
+
+#ifdef LCD_USE_PROFILING
+/**
+ * @brief adds a measured value to a stat
+ * @param stat stat
+ * @param value measured value
+ */
+void LCD_stat_add(LCD_Stat *stat, uint32_t value);
+
+/**
+ * @brief average of values added to a stat
+ * @param stat stat
+ * @return average, 0 if nothing is added
+ */
+uint32_t LCD_stat_average(const LCD_Stat *stat);
+
+/**
+ * @brief copies profile of driver
+ * @param profile destination of profile
+ * @note an update running in an interrupt meanwhile may leave a copy half old
+ */
+void LCD_get_profile(LCD_Profile *profile);
+
+/**
+ * @brief resets profile of driver
+ */
+void LCD_reset_profile(void);
+#endif
+
+/**
+ * @brief models how long bus traffic keeps SPI busy - 8 clocks per byte plus LCD_TRANSACTION_OVERHEAD_NS per transaction
+ * @param bytes bytes sent, e.g. last_frame_bytes of LCD_BusStats
+ * @param transactions transactions they were sent in
+ * @param spi_hz SPI clock, PCD8544 takes up to 4 MHz
+ * @return time in us, 0 if spi_hz is 0
+ */
+uint32_t LCD_wire_time_us(uint32_t bytes, uint32_t transactions, uint32_t spi_hz);
 
 /**
  * @brief Initializes LCD - MUST BE call as soon as possible- Reset pin must be low as default
  * @param contrast set contrast of LCD 0-127
+ * @return HAL_ERROR if no DMA slot is left for it, see LCDx_Init
+ */
+HAL_StatusTypeDef LCD_Init(uint8_t contrast);
+
+/**
+ * @brief starts initializing LCD and returns at once - step it by LCD_Init_step until it returns HAL_OK
+ * @param contrast set contrast of LCD 0-127
+ * @return HAL_ERROR if no DMA slot is left for it, see LCDx_Init_async
+ * @note buffer may be drawn into right away, whole buffer is sent as first frame
+ */
+HAL_StatusTypeDef LCD_Init_async(uint8_t contrast);
+
+/**
+ * @brief advances initialization started by LCD_Init_async, never waits
+ * @return HAL_BUSY while initialization goes on, HAL_OK once first frame is sent (or started by DMA)
+ */
+HAL_StatusTypeDef LCD_Init_step(void);
+
+/**
+ * @brief checks whether initialization is finished
+ * @return 1 when LCD is running, 0 during LCD_Init_async sequence
  */
-void LCD_Init(uint8_t contrast);
+uint8_t LCD_is_ready(void);
+
+/**
+ * @brief shows buffer inverted, see LCDx_invert
+ * @param inverted 1 for light pixels on dark, 0 for normal
+ */
+void LCD_invert(uint8_t inverted);
+
+/**
+ * @brief blanks display keeping its content, see LCDx_blank
+ * @param blank 1 to blank, 0 to show
+ */
+void LCD_blank(uint8_t blank);
+
+/**
+ * @brief flashes whole display, see LCDx_flash
+ * @param period_ms on/off cycle
+ * @param duration_ms run time, 0 flashes until LCD_stop_effect
+ */
+void LCD_flash(uint16_t period_ms, uint32_t duration_ms);
+
+/**
+ * @brief blinks display, see LCDx_blink
+ * @param period_ms on/off cycle
+ * @param duration_ms run time, 0 blinks until LCD_stop_effect
+ */
+void LCD_blink(uint16_t period_ms, uint32_t duration_ms);
+
+/**
+ * @brief stops flash or blink
+ */
+void LCD_stop_effect(void);
+
+/**
+ * @brief powers panel down after a time without updates, see LCDx_set_idle_power_down
+ * @param idle_ms time without traffic before power down, 0 keeps panel on
+ */
+void LCD_set_idle_power_down(uint32_t idle_ms);
+
+/**
+ * @brief checks whether panel is powered down by idle policy
+ * @return 1 if powered down
+ */
+uint8_t LCD_is_powered_down(void);
 
 /**
  * @brief clears whole buffer
@@ -32,6 +657,33 @@ void LCD_clear(void);
  */
 void LCD_update(void);
 
+#ifdef LCD_USE_DMA
+/**
+ * @brief starts updating LCD with changed part of buffer by DMA and returns immediately
+ * @return HAL_BUSY if previous frame is still in flight or LCD is still initializing, otherwise HAL_OK
+ * @note changed parts are snapshot before start, so drawing into buffer may go on during transfer
+ */
+HAL_StatusTypeDef LCD_update_async(void);
+
+/**
+ * @brief checks whether an asynchronous update is in flight
+ * @return 1 while DMA transfer chain is running, 0 otherwise
+ */
+uint8_t LCD_is_busy(void);
+
+/**
+ * @brief sets function called (in interrupt context) when an asynchronous update completes
+ * @param callback function to be called, 0 to disable
+ */
+void LCD_set_update_callback(void (*callback)(LCD_HandleTypeDef *hlcd));
+
+/**
+ * @brief advances DMA transfer chains of all LCDs - MUST BE called from HAL_SPI_TxCpltCallback
+ * @param hspi SPI handle passed to HAL_SPI_TxCpltCallback
+ */
+void LCD_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+#endif
+
 /**
  * @brief goto 8-bit chunck in buffer area
  * @param x x of chunk
@@ -42,7 +694,7 @@ void LCD_goto_x_y_chunk(uint16_t x, uint16_t y);
 
 /**
  * @brief write an ascii character in current cursor of buffer (cursor also goes forward) - each character is 8x6 pixels
- * @param chr
+ * @param chr ' ' to '~', others are written as ' '
  */
 void LCD_write_char_8x6(uint8_t chr);
 
@@ -64,6 +716,85 @@ void decompress_into_buffer(uint8_t *compressed_image, uint8_t *LCD_buffer, uint
 //todo 2 may be remove due to further updates - write 8x1 chunk
 void LCD_write_full_pic(uint8_t full_pic[]);
 
+/**
+ * @brief decompress an image into buffer and mark its rectangle as changed
+ * @param compressed_image image compressed by BICTES
+ * @param length size of compressed image in bytes - nothing beyond it is read
+ * @param x_start x of image in chunks
+ * @param y_start y of image in banks
+ * @return HAL_ERROR if image is truncated or malformed (decoded part is kept), otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_decompress_image(uint8_t *compressed_image, uint32_t length, uint16_t x_start, uint16_t y_start);
+
+/**
+ * @brief decompress an image straight to LCD RAM, bank by bank, using only a small staging buffer
+ * @param compressed_image image compressed by BICTES
+ * @param length size of compressed image in bytes - nothing beyond it is read
+ * @param x_start x of image in chunks
+ * @param y_start y of image in banks
+ * @return HAL_ERROR if image is truncated or malformed, HAL_BUSY if LCD is still initializing, otherwise HAL_OK
+ * @note buffer is left untouched, so later updates of the same area overwrite the image
+ * @note not a frame - its bytes and transactions add to bus stats totals, but frames, last frame counters and the
+ *       update and decompress probes of profiling are left alone
+ */
+HAL_StatusTypeDef LCD_stream_compressed_image(uint8_t *compressed_image, uint32_t length, uint16_t x_start,
+                                              uint16_t y_start);
+
+/**
+ * @brief marks a rectangle as changed, for frames modified without the drawing functions
+ * @param x left of rectangle in chunks 0-83
+ * @param y top of rectangle in banks 0-5
+ * @param width width in chunks - clipped at right edge
+ * @param height height in banks - clipped at bottom edge
+ */
+void LCD_mark_dirty(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+
+#ifndef LCD_USE_PAGED_MODE
+/**
+ * @brief draws into and sends from a caller-owned 504-byte frame instead of own buffer - no copy is made
+ * @param frame frame to show, may live in flash; 0 goes back to own buffer
+ * @note whole frame is marked as changed, with LCD_USE_SHADOW_BUFFER only bytes differing from LCD are sent
+ * @note drawing functions write into attached frame - do not draw while a read-only frame is attached
+ * @note with LCD_USE_DMA a frame is sent in place, keep it intact until LCD_is_busy returns 0
+ */
+void LCD_attach_frame(const uint8_t *frame);
+
+/**
+ * @brief gets frame currently drawn into and sent
+ * @return attached frame or own buffer
+ */
+uint8_t *LCD_get_frame(void);
+#endif
+
+#ifdef LCD_USE_PAGED_MODE
+/**
+ * @brief sets function drawing the screen - every LCD_update calls it once per bank with only that bank in buffer
+ * @param draw draws into bank `bank` (pixel rows bank*8 .. bank*8+7) - writes outside it are dropped
+ */
+void LCD_set_draw_callback(void (*draw)(LCD_HandleTypeDef *hlcd, uint8_t bank));
+#endif
+
+#ifdef LCD_USE_BUS_STATS
+/**
+ * @brief copies SPI bus usage counters
+ * @param stats destination of counters
+ */
+void LCD_get_bus_stats(LCD_BusStats *stats);
+
+/**
+ * @brief resets SPI bus usage counters
+ */
+void LCD_reset_bus_stats(void);
+#endif
+
+#ifdef LCD_USE_BUS_MONITOR
+/**
+ * @brief sets function seeing every SPI transaction of LCD, with its DC level
+ * @param monitor function to be called, 0 to disable
+ */
+void LCD_set_bus_monitor(void (*monitor)(LCD_HandleTypeDef *hlcd, uint8_t is_data, const uint8_t *data, uint16_t length));
+#endif
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif
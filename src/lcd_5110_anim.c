@@ -0,0 +1,93 @@
+/**
+ *  @file lcd_5110_anim.c
+ *  @brief delta-frame animations on LCD 5110
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Each frame only holds the bytes that differ from the previous one, XORed, so decoding and updating a frame
+ *  costs in proportion to what moved rather than to the screen.
+ */
+
+#include "userconf.h"
+#include "lcd_5110_anim.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+HAL_StatusTypeDef LCD_animation_open(LCD_Animation *animation, const uint8_t *data, uint32_t length) {
+    animation->data        = data;
+    animation->length      = length;
+    animation->index       = 3;
+    animation->first_delta = 0;
+    animation->frame       = 0;
+    animation->delay_ms    = 0;
+    animation->ended       = 1;
+    if (length < 3)
+        return HAL_ERROR;
+    animation->loops       = data[0] & LCD_ANIMATION_LOOPS;
+    animation->frame_count = (uint16_t) (data[1] | data[2] << 8);
+    animation->ended       = animation->frame_count == 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef LCDx_animation_next(LCD_HandleTypeDef *hlcd, LCD_Animation *animation) {
+    const uint8_t *data = animation->data;
+    uint32_t      index = animation->index;
+
+    if (animation->ended)
+        return HAL_OK;
+    if (index >= animation->length)
+        goto malformed;
+    animation->delay_ms = data[index++] * 10;
+
+    for (;;) {
+        if (index >= animation->length)
+            goto malformed;
+        uint8_t bank = data[index++];
+        if (bank == LCD_ANIMATION_END_OF_FRAME)
+            break;
+        if (index + 2 > animation->length)
+            goto malformed;
+        uint8_t x      = data[index++];
+        uint8_t length = data[index++];
+        if (bank >= LCD_HEIGHT_IN_CHUNK || length == 0 || x + length > LCD_WIDTH_IN_CHUNK ||
+            index + length > animation->length)
+            goto malformed;
+
+        uint8_t *row = hlcd->frame + bank * LCD_WIDTH_IN_CHUNK + x;
+        for (uint8_t n = 0; n < length; n++)
+            row[n] ^= data[index + n];
+        index += length;
+        LCDx_mark_dirty(hlcd, x, bank, length, 1);
+    }
+
+    animation->frame++;
+    if (animation->frame == 1)
+        animation->first_delta = index;
+    if (animation->frame < animation->frame_count) {
+        animation->index = index;
+    } else if (animation->loops && animation->frame == animation->frame_count) {
+        //closing frame follows, it takes last frame back to frame 0
+        animation->index = index;
+    } else if (animation->loops) {
+        animation->frame = 1;
+        animation->index = animation->first_delta;
+    } else {
+        animation->ended = 1;
+    }
+    //a single-frame loop has nothing to play after frame 0
+    if (animation->loops && animation->frame_count == 1)
+        animation->ended = 1;
+    return HAL_OK;
+
+malformed:
+    animation->ended = 1;
+    return HAL_ERROR;
+}
+
+//default instance wrappers
+
+HAL_StatusTypeDef LCD_animation_next(LCD_Animation *animation) {
+    return LCDx_animation_next(&hlcd1, animation);
+}
+
+#endif
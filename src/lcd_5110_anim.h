@@ -0,0 +1,77 @@
+/**
+*  @file lcd_5110_anim.h
+*  @brief delta-frame animations on LCD 5110
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_ANIM
+#define LCD_5110_ANIM
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+/*
+ * animation format - build with tools/anim2lcd.py
+ *  header : flags (bit 0: loops), frame count (16-bit little endian)
+ *  frame  : delay in 10 ms, records, 0xFF
+ *  record : bank 0-5, x 0-83, length 1-84, `length` bytes XORed into bank from x on
+ * frame 0 is relative to a cleared frame; a looping animation has one more frame taking last frame back to frame 0.
+ */
+#define LCD_ANIMATION_LOOPS                     0x01
+#define LCD_ANIMATION_END_OF_FRAME              0xFF
+
+/**
+ * @brief state of an animation being played
+ */
+typedef struct {
+    const uint8_t *data;
+    uint32_t      length;
+    uint32_t      index;//next byte to read
+    uint32_t      first_delta;//start of frame 1, where a looping animation goes on after its closing frame
+    uint16_t      frame_count;
+    uint16_t      frame;//next frame to show
+    uint16_t      delay_ms;//how long the last shown frame stays
+    uint8_t       loops;
+    uint8_t       ended;
+} LCD_Animation;
+
+/**
+ * @brief starts playing an animation - clear the frame before showing first frame
+ * @param animation state to set up
+ * @param data animation bytes
+ * @param length length of data
+ * @return HAL_ERROR if header is truncated, otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_animation_open(LCD_Animation *animation, const uint8_t *data, uint32_t length);
+
+/**
+ * @brief shows next frame - its deltas are XORed into buffer in place and marked as changed, one span per bank
+ *        from first to last record
+ * @param hlcd LCD handle
+ * @param animation animation being played
+ * @return HAL_ERROR if frame is truncated or malformed (animation then ends), otherwise HAL_OK
+ * @note after last frame of a non-looping animation, animation->ended is set and calls do nothing
+ */
+HAL_StatusTypeDef LCDx_animation_next(LCD_HandleTypeDef *hlcd, LCD_Animation *animation);
+
+/**
+ * @brief shows next frame of an animation, see LCDx_animation_next
+ * @param animation animation being played
+ * @return HAL_ERROR if frame is truncated or malformed, otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_animation_next(LCD_Animation *animation);
+
+#endif
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
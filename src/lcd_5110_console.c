@@ -0,0 +1,158 @@
+/**
+ *  @file lcd_5110_console.c
+ *  @brief scrolling text console on LCD 5110
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Text is kept as characters in a ring of lines; a new line or a scroll moves ring indexes and the view offset,
+ *  nothing is copied. Pixels are only produced by LCDx_console_render, once per update however much was written.
+ */
+
+#include <string.h>
+#include "userconf.h"
+#include "lcd_5110_console.h"
+#include "lcd_5110_gfx.h"
+
+#define LCD_CONSOLE_LINE_HEIGHT                 8
+#define LCD_CONSOLE_CHAR_WIDTH                  6
+
+/*private in-lib functions*/
+
+/**
+ * @brief ring slot of a line
+ * @param console console
+ * @param line 0 for oldest line
+ * @return slot in console->text
+ */
+uint8_t _console_slot(LCD_Console *console, uint16_t line);
+
+/**
+ * @brief appends an empty line, dropping oldest one if ring is full
+ * @param console console
+ */
+void _console_new_line(LCD_Console *console);
+
+/**
+ * @brief largest view offset, where oldest line is on top of LCD
+ * @param console console
+ * @return pixels
+ */
+uint16_t _console_max_view(LCD_Console *console);
+
+uint8_t _console_slot(LCD_Console *console, uint16_t line) {
+    return (uint8_t) ((console->head + line) % LCD_CONSOLE_LINES);
+}
+
+void _console_new_line(LCD_Console *console) {
+    if (console->count < LCD_CONSOLE_LINES)
+        console->count++;
+    else
+        console->head = _console_slot(console, 1);
+    //scrolled back view stays on the same text until that text is dropped
+    if (console->view)
+        console->view += LCD_CONSOLE_LINE_HEIGHT;
+    if (console->view > _console_max_view(console))
+        console->view = _console_max_view(console);
+
+    uint8_t slot = _console_slot(console, console->count - 1);
+    memset(console->text[slot], ' ', LCD_CONSOLE_COLUMNS);
+    console->modified[slot] = 1;
+    console->column         = 0;
+}
+
+uint16_t _console_max_view(LCD_Console *console) {
+    uint16_t content = console->count * LCD_CONSOLE_LINE_HEIGHT;
+    return content > LCD_HEIGHT_IN_CHUNK * 8 ? content - LCD_HEIGHT_IN_CHUNK * 8 : 0;
+}
+
+void LCD_console_init(LCD_Console *console) {
+    console->head  = 0;
+    console->count = 1;
+    console->view  = 0;
+    memset(console->text[0], ' ', LCD_CONSOLE_COLUMNS);
+    console->column = 0;
+    LCD_console_invalidate(console);
+}
+
+void LCD_console_putc(LCD_Console *console, char chr) {
+    if (chr == '\n') {
+        _console_new_line(console);
+        return;
+    }
+    if (chr == '\r') {
+        console->column = 0;
+        return;
+    }
+    if (console->column == LCD_CONSOLE_COLUMNS)
+        _console_new_line(console);
+    uint8_t slot = _console_slot(console, console->count - 1);
+    console->text[slot][console->column++] = chr;
+    console->modified[slot] = 1;
+}
+
+void LCD_console_write(LCD_Console *console, const char *str) {
+    while (*str)
+        LCD_console_putc(console, *str++);
+}
+
+void LCD_console_scroll(LCD_Console *console, int16_t pixels) {
+    int32_t view = (int32_t) console->view + pixels;
+    if (view < 0)
+        view = 0;
+    if (view > _console_max_view(console))
+        view = _console_max_view(console);
+    console->view = (uint16_t) view;
+}
+
+void LCD_console_scroll_lines(LCD_Console *console, int16_t lines) {
+    LCD_console_scroll(console, (int16_t) (lines * LCD_CONSOLE_LINE_HEIGHT));
+}
+
+void LCD_console_follow(LCD_Console *console) {
+    console->view = 0;
+}
+
+void LCD_console_invalidate(LCD_Console *console) {
+    console->rendered_top = 0xffff;
+}
+
+void LCDx_console_render(LCD_HandleTypeDef *hlcd, LCD_Console *console) {
+    uint16_t content = console->count * LCD_CONSOLE_LINE_HEIGHT;
+    //pixel row of content shown on top of LCD
+    uint16_t top     = content > LCD_HEIGHT_IN_CHUNK * 8 + console->view ?
+                       content - LCD_HEIGHT_IN_CHUNK * 8 - console->view : 0;
+    uint8_t  all     = top != console->rendered_top || console->head != console->rendered_head;
+#ifdef LCD_USE_PAGED_MODE
+    //paged buffer is redrawn for every bank
+    all = 1;
+#endif
+
+    //a window not aligned to lines shows parts of 7 lines
+    for (uint16_t row = 0; row <= LCD_HEIGHT_IN_CHUNK; row++) {
+        uint16_t line = top / LCD_CONSOLE_LINE_HEIGHT + row;
+        int16_t  y    = (int16_t) (row * LCD_CONSOLE_LINE_HEIGHT - top % LCD_CONSOLE_LINE_HEIGHT);
+        if (y >= LCD_HEIGHT_IN_CHUNK * 8)
+            break;
+        if (line >= console->count) {
+            if (all)
+                LCDx_fill_rect(hlcd, 0, y, LCD_WIDTH_IN_CHUNK, LCD_CONSOLE_LINE_HEIGHT, LCD_DRAW_CLEAR);
+            continue;
+        }
+        uint8_t slot = _console_slot(console, line);
+        if (!all && !console->modified[slot])
+            continue;
+        for (uint8_t column = 0; column < LCD_CONSOLE_COLUMNS; column++)
+            LCDx_draw_char(hlcd, (int16_t) (column * LCD_CONSOLE_CHAR_WIDTH), y, console->text[slot][column],
+                           LCD_DRAW_COPY);
+    }
+
+    memset(console->modified, 0, LCD_CONSOLE_LINES);
+    console->rendered_top  = top;
+    console->rendered_head = console->head;
+}
+
+//default instance wrappers
+
+void LCD_console_render(LCD_Console *console) {
+    LCDx_console_render(&hlcd1, console);
+}
@@ -0,0 +1,107 @@
+/**
+*  @file lcd_5110_console.h
+*  @brief scrolling text console on LCD 5110
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_CONSOLE
+#define LCD_5110_CONSOLE
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+//characters per line - 84 / 6
+#define LCD_CONSOLE_COLUMNS                     14
+
+//lines kept for scrollback, at least the 6 visible ones
+#ifndef LCD_CONSOLE_LINES
+#define LCD_CONSOLE_LINES                       16
+#endif
+
+/**
+ * @brief a ring of text lines shown full screen in 8x6 characters
+ * @note set it up with LCD_console_init - writing and scrolling only touch the ring, LCDx_console_render draws
+ */
+typedef struct {
+    char     text[LCD_CONSOLE_LINES][LCD_CONSOLE_COLUMNS];//ring of lines padded with ' '
+    uint8_t  modified[LCD_CONSOLE_LINES];//line changed since last render
+    uint8_t  head;//ring slot of oldest line
+    uint8_t  count;//lines in ring
+    uint8_t  column;//cursor in newest line
+    uint16_t view;//pixels scrolled back from newest line, 0 follows new lines
+    //window drawn by last render, rendered_top is 0xffff when nothing is drawn
+    uint16_t rendered_top;
+    uint8_t  rendered_head;
+} LCD_Console;
+
+/**
+ * @brief sets up an empty console, following new lines
+ * @param console console to set up
+ */
+void LCD_console_init(LCD_Console *console);
+
+/**
+ * @brief appends a character - '\n' starts a new line, '\r' returns to line start, long lines wrap
+ * @param console console
+ * @param chr character, those out of ' ' to '~' are shown as ' '
+ * @note oldest line is dropped when ring is full
+ */
+void LCD_console_putc(LCD_Console *console, char chr);
+
+/**
+ * @brief appends a string, see LCD_console_putc
+ * @param console console
+ * @param str string
+ */
+void LCD_console_write(LCD_Console *console, const char *str);
+
+/**
+ * @brief scrolls view by pixels
+ * @param console console
+ * @param pixels positive scrolls back to older lines, negative towards newest - clipped to content
+ */
+void LCD_console_scroll(LCD_Console *console, int16_t pixels);
+
+/**
+ * @brief scrolls view by lines
+ * @param console console
+ * @param lines positive scrolls back to older lines, negative towards newest - clipped to content
+ */
+void LCD_console_scroll_lines(LCD_Console *console, int16_t lines);
+
+/**
+ * @brief jumps to newest line and follows new lines again
+ * @param console console
+ */
+void LCD_console_follow(LCD_Console *console);
+
+/**
+ * @brief forgets what is drawn, so next render draws whole window - call after drawing over console
+ * @param console console
+ */
+void LCD_console_invalidate(LCD_Console *console);
+
+/**
+ * @brief draws visible window of console into buffer - only lines changed since last render, or whole window if it moved
+ * @param hlcd LCD handle
+ * @param console console
+ * @note call before LCDx_update; in LCD_USE_PAGED_MODE call it from draw callback
+ */
+void LCDx_console_render(LCD_HandleTypeDef *hlcd, LCD_Console *console);
+
+/**
+ * @brief draws visible window of console into buffer, see LCDx_console_render
+ * @param console console
+ */
+void LCD_console_render(LCD_Console *console);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
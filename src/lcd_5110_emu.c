@@ -0,0 +1,128 @@
+/**
+ *  @file lcd_5110_emu.c
+ *  @brief software model of PCD8544 controller
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Rebuilds the panel RAM from the bytes put on the bus, following the PCD8544 datasheet: function set with its
+ *  PD, V and H bits, basic (display control, X/Y address) and extended (temperature, bias, Vop) instruction sets,
+ *  and the address counters of horizontal and vertical addressing. Whatever the driver sends is what is shown.
+ */
+
+#include <string.h>
+#include "userconf.h"
+#include "lcd_5110_emu.h"
+
+//bytes per row of a P4 image of LCD
+#define LCD_EMU_PBM_ROW                         ((LCD_WIDTH_IN_CHUNK + 7) / 8)
+
+/*private in-lib functions*/
+
+/**
+ * @brief executes a command byte
+ * @param emulator emulator
+ * @param command command byte
+ */
+void _emu_command(LCD_Emulator *emulator, uint8_t command);
+
+/**
+ * @brief writes a data byte at address counters and moves them on
+ * @param emulator emulator
+ * @param data data byte
+ */
+void _emu_data(LCD_Emulator *emulator, uint8_t data);
+
+void _emu_command(LCD_Emulator *emulator, uint8_t command) {
+    //function set is common to both instruction sets
+    if ((command & 0xf8) == 0x20) {
+        emulator->power_down = (command >> 2) & 1;
+        emulator->vertical   = (command >> 1) & 1;
+        emulator->extended   = command & 1;
+        return;
+    }
+    if (emulator->extended) {
+        if (command & 0x80)
+            emulator->vop = command & 0x7f;
+        else if ((command & 0xf8) == 0x10)
+            emulator->bias = command & 0x07;
+        else if ((command & 0xfc) == 0x04)
+            emulator->temperature = command & 0x03;
+        return;
+    }
+    if (command & 0x80) {
+        if ((command & 0x7f) < LCD_WIDTH_IN_CHUNK)
+            emulator->x = command & 0x7f;
+    } else if ((command & 0xf8) == 0x40) {
+        if ((command & 0x07) < LCD_HEIGHT_IN_CHUNK)
+            emulator->y = command & 0x07;
+    } else if ((command & 0xf8) == 0x08) {
+        emulator->display = command & 0x05;
+    }
+}
+
+void _emu_data(LCD_Emulator *emulator, uint8_t data) {
+    emulator->ram[emulator->y][emulator->x] = data;
+    if (emulator->vertical) {
+        if (++emulator->y == LCD_HEIGHT_IN_CHUNK) {
+            emulator->y = 0;
+            if (++emulator->x == LCD_WIDTH_IN_CHUNK)
+                emulator->x = 0;
+        }
+    } else {
+        if (++emulator->x == LCD_WIDTH_IN_CHUNK) {
+            emulator->x = 0;
+            if (++emulator->y == LCD_HEIGHT_IN_CHUNK)
+                emulator->y = 0;
+        }
+    }
+}
+
+void LCD_emu_init(LCD_Emulator *emulator) {
+    memset(emulator, 0, sizeof(*emulator));
+    emulator->power_down = 1;
+    emulator->display    = LCD_EMU_DISPLAY_BLANK;
+}
+
+void LCD_emu_feed(LCD_Emulator *emulator, uint8_t is_data, const uint8_t *data, uint16_t length) {
+    emulator->transactions++;
+    if (is_data)
+        emulator->data_bytes += length;
+    else
+        emulator->command_bytes += length;
+    for (uint16_t i = 0; i < length; i++) {
+        if (is_data)
+            _emu_data(emulator, data[i]);
+        else
+            _emu_command(emulator, data[i]);
+    }
+}
+
+uint8_t LCD_emu_pixel(const LCD_Emulator *emulator, uint8_t x, uint8_t y) {
+    if (x >= LCD_WIDTH_IN_CHUNK || y >= LCD_HEIGHT_IN_CHUNK * 8 || emulator->power_down)
+        return 0;
+    uint8_t bit = (emulator->ram[y / 8][x] >> (y % 8)) & 1;
+    switch (emulator->display) {
+        case LCD_EMU_DISPLAY_ALL_ON:
+            return 1;
+        case LCD_EMU_DISPLAY_NORMAL:
+            return bit;
+        case LCD_EMU_DISPLAY_INVERTED:
+            return !bit;
+        default:
+            return 0;
+    }
+}
+
+void LCD_emu_write_pbm(const LCD_Emulator *emulator, void (*write)(const uint8_t *data, uint16_t length)) {
+    static const char header[] = "P4\n84 48\n";
+    uint8_t           row[LCD_EMU_PBM_ROW];
+
+    write((const uint8_t *) header, sizeof(header) - 1);
+    for (uint8_t y = 0; y < LCD_HEIGHT_IN_CHUNK * 8; y++) {
+        memset(row, 0, sizeof(row));
+        for (uint8_t x = 0; x < LCD_WIDTH_IN_CHUNK; x++)
+            if (LCD_emu_pixel(emulator, x, y))
+                row[x / 8] |= (uint8_t) (0x80 >> (x % 8));
+        write(row, sizeof(row));
+    }
+}
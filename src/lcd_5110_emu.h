@@ -0,0 +1,81 @@
+/**
+*  @file lcd_5110_emu.h
+*  @brief software model of PCD8544 controller
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_EMU
+#define LCD_5110_EMU
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+//display control modes, D and E bits of display control command
+#define LCD_EMU_DISPLAY_BLANK                   0x00
+#define LCD_EMU_DISPLAY_ALL_ON                  0x01
+#define LCD_EMU_DISPLAY_NORMAL                  0x04
+#define LCD_EMU_DISPLAY_INVERTED                0x05
+
+/**
+ * @brief state of an emulated PCD8544 - its RAM, address counters and mode bits
+ * @note feed it every SPI transaction with its DC level, e.g. from LCDx_set_bus_monitor or a host HAL stand-in
+ */
+typedef struct {
+    uint8_t  ram[LCD_HEIGHT_IN_CHUNK][LCD_WIDTH_IN_CHUNK];//banks of column bytes, LSB on top
+    uint8_t  x;//address counters
+    uint8_t  y;
+    uint8_t  extended;//H bit of function set
+    uint8_t  vertical;//V bit of function set
+    uint8_t  power_down;//PD bit of function set
+    uint8_t  display;//LCD_EMU_DISPLAY_*
+    uint8_t  vop;//extended instruction settings
+    uint8_t  bias;
+    uint8_t  temperature;
+    //bus traffic fed in
+    uint32_t transactions;
+    uint32_t command_bytes;
+    uint32_t data_bytes;
+} LCD_Emulator;
+
+/**
+ * @brief puts emulator in state of a panel after reset - RAM is cleared, display blank and powered down
+ * @param emulator emulator
+ */
+void LCD_emu_init(LCD_Emulator *emulator);
+
+/**
+ * @brief feeds one SPI transaction into emulator
+ * @param emulator emulator
+ * @param is_data level of DC pin, 0 for command bytes
+ * @param data bytes of transaction
+ * @param length count of bytes
+ * @note out of range X/Y addresses are ignored, like reserved commands
+ */
+void LCD_emu_feed(LCD_Emulator *emulator, uint8_t is_data, const uint8_t *data, uint16_t length);
+
+/**
+ * @brief gets a pixel as shown on glass - display mode and power down applied
+ * @param emulator emulator
+ * @param x 0-83
+ * @param y 0-47
+ * @return 1 if pixel is dark, 0 for light or out of LCD
+ */
+uint8_t LCD_emu_pixel(const LCD_Emulator *emulator, uint8_t x, uint8_t y);
+
+/**
+ * @brief writes what is shown on glass as a binary PBM (P4) image
+ * @param emulator emulator
+ * @param write called with consecutive pieces of image, e.g. to fwrite them or send them over UART
+ */
+void LCD_emu_write_pbm(const LCD_Emulator *emulator, void (*write)(const uint8_t *data, uint16_t length));
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
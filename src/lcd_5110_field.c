@@ -0,0 +1,130 @@
+/**
+ *  @file lcd_5110_field.c
+ *  @brief fixed-width numeric fields on LCD 5110 buffer
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Values are converted without stdio into the field's characters and compared with what the field shows;
+ *  only changed 6-column character cells are rewritten and marked as changed.
+ */
+
+#include "userconf.h"
+#include "lcd_5110_field.h"
+#include "lcd_5110_font.h"
+
+//character cell: 5 glyph columns and a spacing column
+#define LCD_FIELD_CHAR_WIDTH                    6
+
+/*private in-lib functions*/
+
+/**
+ * @brief writes a number right-aligned into a fixed-width text
+ * @param text receives `width` characters, not terminated
+ * @param width characters of text
+ * @param magnitude absolute value
+ * @param negative 1 to add '-'
+ * @param base 10 or 16
+ * @param decimals digits after point
+ * @param zero_pad 1 to pad with '0' instead of ' '
+ * @return 0 if number does not fit text
+ */
+uint8_t _format_number(char *text, uint8_t width, uint32_t magnitude, uint8_t negative, uint8_t base,
+                       uint8_t decimals, uint8_t zero_pad);
+
+/**
+ * @brief writes a character cell into buffer, clipped at right edge of LCD
+ * @param hlcd LCD handle
+ * @param x first column of cell
+ * @param y bank
+ * @param chr ' ' to '~'
+ */
+void _field_put_char(LCD_HandleTypeDef *hlcd, uint8_t x, uint8_t y, char chr);
+
+uint8_t _format_number(char *text, uint8_t width, uint32_t magnitude, uint8_t negative, uint8_t base,
+                       uint8_t decimals, uint8_t zero_pad) {
+    uint8_t pos    = width;
+    uint8_t digits = 0;
+
+    //at least one digit before point
+    do {
+        if (decimals && digits == decimals) {
+            if (pos == 0)
+                return 0;
+            text[--pos] = '.';
+        }
+        if (pos == 0)
+            return 0;
+        text[--pos] = "0123456789ABCDEF"[magnitude % base];
+        magnitude /= base;
+        digits++;
+    } while (magnitude || digits <= decimals);
+
+    if (zero_pad)
+        while (pos > negative)
+            text[--pos] = '0';
+    if (negative) {
+        if (pos == 0)
+            return 0;
+        text[--pos] = '-';
+    }
+    while (pos > 0)
+        text[--pos] = ' ';
+    return 1;
+}
+
+void _field_put_char(LCD_HandleTypeDef *hlcd, uint8_t x, uint8_t y, char chr) {
+    uint16_t index = x + y * LCD_WIDTH_IN_CHUNK;
+
+    for (uint8_t n = 0; n < LCD_FIELD_CHAR_WIDTH && x + n < LCD_WIDTH_IN_CHUNK; n++, index++)
+        if (LCD_BUFFER_HOLDS(hlcd, index))
+            hlcd->frame[LCD_BUFFER_INDEX(hlcd, index)] = n < 5 ? font_en_8x5[chr - LCD_FONT_FIRST_CHAR][n] : 0x00;
+}
+
+void LCD_field_init(LCD_Field *field, uint8_t x, uint8_t y, uint8_t width, LCD_FieldFormat format, uint8_t decimals,
+                    uint8_t zero_pad) {
+    field->x        = x;
+    field->y        = y;
+    field->width    = width > LCD_FIELD_MAX_WIDTH ? LCD_FIELD_MAX_WIDTH : width;
+    field->format   = format;
+    field->decimals = decimals;
+    field->zero_pad = zero_pad;
+    LCD_field_invalidate(field);
+}
+
+void LCD_field_invalidate(LCD_Field *field) {
+    for (uint8_t i = 0; i < LCD_FIELD_MAX_WIDTH; i++)
+        field->shown[i] = 0;
+}
+
+void LCDx_field_set(LCD_HandleTypeDef *hlcd, LCD_Field *field, int32_t value) {
+    char     text[LCD_FIELD_MAX_WIDTH];
+    uint8_t  negative  = field->format == LCD_FIELD_DECIMAL && value < 0;
+    uint32_t magnitude = negative ? 0u - (uint32_t) value : (uint32_t) value;
+
+    if (field->x > LCD_WIDTH_IN_CHUNK - 1 || field->y > LCD_HEIGHT_IN_CHUNK - 1)
+        return;
+    if (!_format_number(text, field->width, magnitude, negative, field->format == LCD_FIELD_HEX ? 16 : 10,
+                        field->decimals, field->zero_pad))
+        for (uint8_t i = 0; i < field->width; i++)
+            text[i] = '#';
+
+    for (uint8_t i = 0; i < field->width; i++) {
+        uint16_t x = field->x + i * LCD_FIELD_CHAR_WIDTH;
+        if (x >= LCD_WIDTH_IN_CHUNK)
+            break;
+#ifndef LCD_USE_PAGED_MODE
+        //paged buffer is redrawn for every bank, so it never holds what the field shows
+        if (field->shown[i] == text[i])
+            continue;
+        field->shown[i] = text[i];
+#endif
+        _field_put_char(hlcd, (uint8_t) x, field->y, text[i]);
+        LCDx_mark_dirty(hlcd, (uint8_t) x, field->y, LCD_FIELD_CHAR_WIDTH, 1);
+    }
+}
+
+//default instance wrappers
+
+void LCD_field_set(LCD_Field *field, int32_t value) {
+    LCDx_field_set(&hlcd1, field, value);
+}
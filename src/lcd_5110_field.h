@@ -0,0 +1,83 @@
+/**
+*  @file lcd_5110_field.h
+*  @brief fixed-width numeric fields on LCD 5110 buffer
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_FIELD
+#define LCD_5110_FIELD
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+//longest field in characters - fits "-2147483648" and a point
+#ifndef LCD_FIELD_MAX_WIDTH
+#define LCD_FIELD_MAX_WIDTH                     12
+#endif
+
+/**
+ * @brief how a field shows its value
+ */
+typedef enum {
+    LCD_FIELD_DECIMAL = 0,//signed decimal, right-aligned
+    LCD_FIELD_HEX,//value as unsigned 32-bit hex, right-aligned
+} LCD_FieldFormat;
+
+/**
+ * @brief a right-aligned number in 8x6 characters at a fixed place of buffer
+ * @note set it up with LCD_field_init, the struct remembers characters in buffer so updates only redraw changed ones
+ */
+typedef struct {
+    uint8_t x;//column of first character in chunks 0-83
+    uint8_t y;//bank 0-5
+    uint8_t width;//characters, 1 to LCD_FIELD_MAX_WIDTH
+    uint8_t format;//LCD_FieldFormat
+    uint8_t decimals;//digits after point - value 1234 with 2 decimals is shown as 12.34
+    uint8_t zero_pad;//pad with '0' instead of ' '
+    char    shown[LCD_FIELD_MAX_WIDTH];//characters in buffer, 0 if unknown
+} LCD_Field;
+
+/**
+ * @brief sets up a field - nothing is drawn until its first LCD_field_set
+ * @param field field to set up
+ * @param x column of first character in chunks 0-83
+ * @param y bank 0-5
+ * @param width characters, clipped to LCD_FIELD_MAX_WIDTH
+ * @param format LCD_FIELD_DECIMAL or LCD_FIELD_HEX
+ * @param decimals digits after point, 0 for integers
+ * @param zero_pad 1 to pad with '0' instead of ' '
+ */
+void LCD_field_init(LCD_Field *field, uint8_t x, uint8_t y, uint8_t width, LCD_FieldFormat format, uint8_t decimals,
+                    uint8_t zero_pad);
+
+/**
+ * @brief forgets what a field shows, so its next update redraws it fully - call after clearing or drawing over it
+ * @param field field to forget
+ */
+void LCD_field_invalidate(LCD_Field *field);
+
+/**
+ * @brief shows a value in a field, redrawing and marking as changed only characters that differ from what it shows
+ * @param hlcd LCD handle
+ * @param field field to update
+ * @param value new value - values not fitting the field are shown as '#'s
+ */
+void LCDx_field_set(LCD_HandleTypeDef *hlcd, LCD_Field *field, int32_t value);
+
+/**
+ * @brief shows a value in a field, redrawing and marking as changed only characters that differ from what it shows
+ * @param field field to update
+ * @param value new value - values not fitting the field are shown as '#'s
+ */
+void LCD_field_set(LCD_Field *field, int32_t value);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+/**
+*  @file lcd_5110_font.h
+*  @brief 5x7 ASCII font of LCD 5110 driver
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_FONT
+#define LCD_5110_FONT
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+//first and last character of font
+#define LCD_FONT_FIRST_CHAR                     32
+#define LCD_FONT_LAST_CHAR                      126
+#define LCD_FONT_GLYPH_COUNT                    (LCD_FONT_LAST_CHAR - LCD_FONT_FIRST_CHAR + 1)
+
+/**
+ * @brief glyphs of ' ' to '~' as GLYPH(column0, ..., column4) - each column is 8 pixels tall, LSB on top
+ * @note expand with your own GLYPH macro to build tables from the same data at compile time
+ */
+#define LCD_FONT_EN_8X5(GLYPH) \
+    GLYPH(0x00, 0x00, 0x00, 0x00, 0x00) /* ' ' */       \
+    GLYPH(0x00, 0x00, 0x2f, 0x00, 0x00) /* '!' */       \
+    GLYPH(0x00, 0x07, 0x00, 0x07, 0x00) /* '"' */       \
+    GLYPH(0x14, 0x7f, 0x14, 0x7f, 0x14) /* '#' */       \
+    GLYPH(0x24, 0x2a, 0x7f, 0x2a, 0x12) /* '$' */       \
+    GLYPH(0x32, 0x34, 0x08, 0x16, 0x26) /* '%' */       \
+    GLYPH(0x36, 0x49, 0x55, 0x22, 0x50) /* '&' */       \
+    GLYPH(0x00, 0x05, 0x03, 0x00, 0x00) /* ''' */       \
+    GLYPH(0x00, 0x1c, 0x22, 0x41, 0x00) /* '(' */       \
+    GLYPH(0x00, 0x41, 0x22, 0x1c, 0x00) /* ')' */       \
+    GLYPH(0x14, 0x08, 0x3E, 0x08, 0x14) /* '*' */       \
+    GLYPH(0x08, 0x08, 0x3E, 0x08, 0x08) /* '+' */       \
+    GLYPH(0x00, 0x00, 0x50, 0x30, 0x00) /* ',' */       \
+    GLYPH(0x10, 0x10, 0x10, 0x10, 0x10) /* '-' */       \
+    GLYPH(0x00, 0x60, 0x60, 0x00, 0x00) /* '.' */       \
+    GLYPH(0x20, 0x10, 0x08, 0x04, 0x02) /* '/' */       \
+    GLYPH(0x3E, 0x51, 0x49, 0x45, 0x3E) /* '0' */       \
+    GLYPH(0x00, 0x42, 0x7F, 0x40, 0x00) /* '1' */       \
+    GLYPH(0x42, 0x61, 0x51, 0x49, 0x46) /* '2' */       \
+    GLYPH(0x21, 0x41, 0x45, 0x4B, 0x31) /* '3' */       \
+    GLYPH(0x18, 0x14, 0x12, 0x7F, 0x10) /* '4' */       \
+    GLYPH(0x27, 0x45, 0x45, 0x45, 0x39) /* '5' */       \
+    GLYPH(0x3C, 0x4A, 0x49, 0x49, 0x30) /* '6' */       \
+    GLYPH(0x01, 0x71, 0x09, 0x05, 0x03) /* '7' */       \
+    GLYPH(0x36, 0x49, 0x49, 0x49, 0x36) /* '8' */       \
+    GLYPH(0x06, 0x49, 0x49, 0x29, 0x1E) /* '9' */       \
+    GLYPH(0x00, 0x36, 0x36, 0x00, 0x00) /* ':' */       \
+    GLYPH(0x00, 0x56, 0x36, 0x00, 0x00) /* ';' */       \
+    GLYPH(0x08, 0x14, 0x22, 0x41, 0x00) /* '<' */       \
+    GLYPH(0x14, 0x14, 0x14, 0x14, 0x14) /* '=' */       \
+    GLYPH(0x00, 0x41, 0x22, 0x14, 0x08) /* '>' */       \
+    GLYPH(0x02, 0x01, 0x51, 0x09, 0x06) /* '?' */       \
+    GLYPH(0x32, 0x49, 0x59, 0x51, 0x3E) /* '@' */       \
+    GLYPH(0x7E, 0x11, 0x11, 0x11, 0x7E) /* 'A' */       \
+    GLYPH(0x7F, 0x49, 0x49, 0x49, 0x36) /* 'B' */       \
+    GLYPH(0x3E, 0x41, 0x41, 0x41, 0x22) /* 'C' */       \
+    GLYPH(0x7F, 0x41, 0x41, 0x22, 0x1C) /* 'D' */       \
+    GLYPH(0x7F, 0x49, 0x49, 0x49, 0x41) /* 'E' */       \
+    GLYPH(0x7F, 0x09, 0x09, 0x09, 0x01) /* 'F' */       \
+    GLYPH(0x3E, 0x41, 0x49, 0x49, 0x7A) /* 'G' */       \
+    GLYPH(0x7F, 0x08, 0x08, 0x08, 0x7F) /* 'H' */       \
+    GLYPH(0x00, 0x41, 0x7F, 0x41, 0x00) /* 'I' */       \
+    GLYPH(0x20, 0x40, 0x41, 0x3F, 0x01) /* 'J' */       \
+    GLYPH(0x7F, 0x08, 0x14, 0x22, 0x41) /* 'K' */       \
+    GLYPH(0x7F, 0x40, 0x40, 0x40, 0x40) /* 'L' */       \
+    GLYPH(0x7F, 0x02, 0x0C, 0x02, 0x7F) /* 'M' */       \
+    GLYPH(0x7F, 0x04, 0x08, 0x10, 0x7F) /* 'N' */       \
+    GLYPH(0x3E, 0x41, 0x41, 0x41, 0x3E) /* 'O' */       \
+    GLYPH(0x7F, 0x09, 0x09, 0x09, 0x06) /* 'P' */       \
+    GLYPH(0x3E, 0x41, 0x51, 0x21, 0x5E) /* 'Q' */       \
+    GLYPH(0x7F, 0x09, 0x19, 0x29, 0x46) /* 'R' */       \
+    GLYPH(0x46, 0x49, 0x49, 0x49, 0x31) /* 'S' */       \
+    GLYPH(0x01, 0x01, 0x7F, 0x01, 0x01) /* 'T' */       \
+    GLYPH(0x3F, 0x40, 0x40, 0x40, 0x3F) /* 'U' */       \
+    GLYPH(0x1F, 0x20, 0x40, 0x20, 0x1F) /* 'V' */       \
+    GLYPH(0x3F, 0x40, 0x38, 0x40, 0x3F) /* 'W' */       \
+    GLYPH(0x63, 0x14, 0x08, 0x14, 0x63) /* 'X' */       \
+    GLYPH(0x07, 0x08, 0x70, 0x08, 0x07) /* 'Y' */       \
+    GLYPH(0x61, 0x51, 0x49, 0x45, 0x43) /* 'Z' */       \
+    GLYPH(0x00, 0x7F, 0x41, 0x41, 0x00) /* '[' */       \
+    GLYPH(0x55, 0x2A, 0x55, 0x2A, 0x55) /* backslash */ \
+    GLYPH(0x00, 0x41, 0x41, 0x7F, 0x00) /* ']' */       \
+    GLYPH(0x04, 0x02, 0x01, 0x02, 0x04) /* '^' */       \
+    GLYPH(0x40, 0x40, 0x40, 0x40, 0x40) /* '_' */       \
+    GLYPH(0x00, 0x01, 0x02, 0x04, 0x00) /* '`' */       \
+    GLYPH(0x20, 0x54, 0x54, 0x54, 0x78) /* 'a' */       \
+    GLYPH(0x7F, 0x48, 0x44, 0x44, 0x38) /* 'b' */       \
+    GLYPH(0x38, 0x44, 0x44, 0x44, 0x20) /* 'c' */       \
+    GLYPH(0x38, 0x44, 0x44, 0x48, 0x7F) /* 'd' */       \
+    GLYPH(0x38, 0x54, 0x54, 0x54, 0x18) /* 'e' */       \
+    GLYPH(0x08, 0x7E, 0x09, 0x01, 0x02) /* 'f' */       \
+    GLYPH(0x0C, 0x52, 0x52, 0x52, 0x3E) /* 'g' */       \
+    GLYPH(0x7F, 0x08, 0x04, 0x04, 0x78) /* 'h' */       \
+    GLYPH(0x00, 0x44, 0x7D, 0x40, 0x00) /* 'i' */       \
+    GLYPH(0x20, 0x40, 0x44, 0x3D, 0x00) /* 'j' */       \
+    GLYPH(0x7F, 0x10, 0x28, 0x44, 0x00) /* 'k' */       \
+    GLYPH(0x00, 0x41, 0x7F, 0x40, 0x00) /* 'l' */       \
+    GLYPH(0x7C, 0x04, 0x18, 0x04, 0x78) /* 'm' */       \
+    GLYPH(0x7C, 0x08, 0x04, 0x04, 0x78) /* 'n' */       \
+    GLYPH(0x38, 0x44, 0x44, 0x44, 0x38) /* 'o' */       \
+    GLYPH(0x7C, 0x14, 0x14, 0x14, 0x08) /* 'p' */       \
+    GLYPH(0x08, 0x14, 0x14, 0x18, 0x7C) /* 'q' */       \
+    GLYPH(0x7C, 0x08, 0x04, 0x04, 0x08) /* 'r' */       \
+    GLYPH(0x48, 0x54, 0x54, 0x54, 0x20) /* 's' */       \
+    GLYPH(0x04, 0x3F, 0x44, 0x40, 0x20) /* 't' */       \
+    GLYPH(0x3C, 0x40, 0x40, 0x20, 0x7C) /* 'u' */       \
+    GLYPH(0x1C, 0x20, 0x40, 0x20, 0x1C) /* 'v' */       \
+    GLYPH(0x3C, 0x40, 0x30, 0x40, 0x3C) /* 'w' */       \
+    GLYPH(0x44, 0x28, 0x10, 0x28, 0x44) /* 'x' */       \
+    GLYPH(0x0C, 0x50, 0x50, 0x50, 0x3C) /* 'y' */       \
+    GLYPH(0x44, 0x64, 0x54, 0x4C, 0x44) /* 'z' */       \
+    GLYPH(0x00, 0x08, 0x36, 0x41, 0x00) /* '{' */       \
+    GLYPH(0x00, 0x00, 0x7F, 0x00, 0x00) /* '|' */       \
+    GLYPH(0x00, 0x41, 0x36, 0x08, 0x00) /* '}' */       \
+    GLYPH(0x10, 0x08, 0x08, 0x10, 0x08) /* '~' */
+
+//Fonts 5x7
+extern const uint8_t font_en_8x5[LCD_FONT_GLYPH_COUNT][5];
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,419 @@
+/**
+ *  @file lcd_5110_gfx.c
+ *  @brief pixel graphics on LCD 5110 buffer
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Buffer is laid out in banks: byte x + bank * 84 holds pixels (x, bank * 8) .. (x, bank * 8 + 7), LSB on top.
+ *  Shapes are drawn bank by bank with one mask per bank, so a rectangle costs a few word operations per bank
+ *  instead of one read-modify-write per pixel.
+ */
+
+#include <string.h>
+#include "userconf.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_font.h"
+
+//character cell: 5 glyph columns and a spacing column, 8 pixels tall
+#define LCD_CHAR_WIDTH                          6
+
+#ifdef LCD_USE_PRESHIFTED_FONT
+#define LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, shift)                                                \
+    {(uint16_t) ((c0) << (shift)), (uint16_t) ((c1) << (shift)), (uint16_t) ((c2) << (shift)),     \
+     (uint16_t) ((c3) << (shift)), (uint16_t) ((c4) << (shift))}
+#define LCD_GLYPH_ALL_SHIFTS(c0, c1, c2, c3, c4)                                                    \
+    {LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 0), LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 1),          \
+     LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 2), LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 3),          \
+     LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 4), LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 5),          \
+     LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 6), LCD_GLYPH_SHIFTED(c0, c1, c2, c3, c4, 7)},
+
+//font_en_8x5 shifted down by 0-7 pixels at compile time - low byte goes to upper bank, high byte to lower bank
+const uint16_t font_en_8x5_shifted[LCD_FONT_GLYPH_COUNT][8][5] = {
+        LCD_FONT_EN_8X5(LCD_GLYPH_ALL_SHIFTS)
+};
+#define LCD_GLYPH_COLUMN(glyph, shift, column)  font_en_8x5_shifted[glyph][shift][column]
+#else
+#define LCD_GLYPH_COLUMN(glyph, shift, column)  ((uint16_t) (font_en_8x5[glyph][column] << (shift)))
+#endif
+
+/*private in-lib functions*/
+
+/**
+ * @brief combines bytes of buffer with drawn bits - works on one byte or four packed in a word
+ * @param dst bytes of buffer
+ * @param bits drawn bits
+ * @param mask bits of dst covered by drawing, only used by LCD_DRAW_COPY
+ * @param mode drawing mode
+ * @return new bytes of buffer
+ */
+uint32_t _combine(uint32_t dst, uint32_t bits, uint32_t mask, LCD_DrawMode mode);
+
+/**
+ * @brief combines a run of columns of one bank with the same mask, four columns at a time
+ * @param row first byte of run in buffer
+ * @param count count of columns
+ * @param mask pixels of each column to draw
+ * @param mode drawing mode
+ */
+void _fill_span(uint8_t *row, uint16_t count, uint8_t mask, LCD_DrawMode mode);
+
+/**
+ * @brief moves bits of four packed bytes up or down, bits crossing into the next byte are dropped
+ * @param word four bytes
+ * @param left bits to move to higher pixels (down on LCD)
+ * @param right bits to move to lower pixels (up on LCD)
+ * @return shifted bytes
+ */
+uint32_t _shift_lanes(uint32_t word, uint8_t left, uint8_t right);
+
+/**
+ * @brief combines a run of bitmap bytes, shifted by `left` or `right`, with a run of one bank
+ * @param row first byte of run in buffer
+ * @param src first byte of run in bitmap
+ * @param count count of columns
+ * @param band_mask valid bits of bitmap bytes
+ * @param left see _shift_lanes
+ * @param right see _shift_lanes
+ * @param mode drawing mode
+ */
+void _blit_span(uint8_t *row, const uint8_t *src, uint16_t count, uint8_t band_mask, uint8_t left, uint8_t right,
+                LCD_DrawMode mode);
+
+/**
+ * @brief draws a pixel without marking it as changed
+ * @param hlcd LCD handle
+ * @return 1 if pixel is on LCD
+ */
+uint8_t _plot(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, LCD_DrawMode mode);
+
+/**
+ * @brief bank of a pixel row, rounded down for rows above LCD
+ * @param y pixel row
+ * @return bank
+ */
+int16_t _bank_of(int16_t y);
+
+/**
+ * @brief combines a 16-pixel tall column with a bank and the one below it
+ * @param hlcd LCD handle
+ * @param x column 0-83
+ * @param bank bank of low byte, may be out of LCD
+ * @param bits drawn pixels - low byte in `bank`, high byte in `bank + 1`
+ * @param mask pixels covered by drawing, see _combine
+ * @param mode drawing mode
+ */
+void _put_column(LCD_HandleTypeDef *hlcd, uint8_t x, int16_t bank, uint16_t bits, uint16_t mask, LCD_DrawMode mode);
+
+/**
+ * @brief marks a pixel rectangle as changed after clipping it to LCD
+ * @param hlcd LCD handle
+ * @param x_low left
+ * @param y_low top
+ * @param x_high one past right
+ * @param y_high one past bottom
+ */
+void _mark_pixels(LCD_HandleTypeDef *hlcd, int32_t x_low, int32_t y_low, int32_t x_high, int32_t y_high);
+
+/**
+ * @brief first byte of a bank in buffer
+ * @param hlcd LCD handle
+ * @param bank a bank held in buffer
+ * @return pointer to column 0 of bank
+ */
+uint8_t *_bank_row(LCD_HandleTypeDef *hlcd, uint8_t bank);
+
+uint32_t _combine(uint32_t dst, uint32_t bits, uint32_t mask, LCD_DrawMode mode) {
+    switch (mode) {
+        case LCD_DRAW_CLEAR:
+            return dst & ~bits;
+        case LCD_DRAW_XOR:
+            return dst ^ bits;
+        case LCD_DRAW_COPY:
+            return (dst & ~mask) | (bits & mask);
+        default:
+            return dst | bits;
+    }
+}
+
+void _fill_span(uint8_t *row, uint16_t count, uint8_t mask, LCD_DrawMode mode) {
+    uint32_t mask32 = mask * 0x01010101u;
+    uint32_t word;
+
+    //head bytes up to a word boundary
+    for (; count && ((uintptr_t) row & 3); count--, row++)
+        *row = (uint8_t) _combine(*row, mask, mask, mode);
+    for (; count >= 4; count -= 4, row += 4) {
+        memcpy(&word, row, 4);
+        word = _combine(word, mask32, mask32, mode);
+        memcpy(row, &word, 4);
+    }
+    for (; count; count--, row++)
+        *row = (uint8_t) _combine(*row, mask, mask, mode);
+}
+
+uint32_t _shift_lanes(uint32_t word, uint8_t left, uint8_t right) {
+    uint32_t lanes = (uint8_t) ((uint8_t) (0xff << left) >> right) * 0x01010101u;
+    return (word << left >> right) & lanes;
+}
+
+void _blit_span(uint8_t *row, const uint8_t *src, uint16_t count, uint8_t band_mask, uint8_t left, uint8_t right,
+                LCD_DrawMode mode) {
+    uint8_t  mask   = (uint8_t) ((uint8_t) (band_mask << left) >> right);
+    uint32_t mask32 = mask * 0x01010101u;
+    uint32_t word, bits;
+
+    for (; count >= 4; count -= 4, row += 4, src += 4) {
+        memcpy(&bits, src, 4);
+        memcpy(&word, row, 4);
+        word = _combine(word, _shift_lanes(bits, left, right) & mask32, mask32, mode);
+        memcpy(row, &word, 4);
+    }
+    for (; count; count--, row++, src++)
+        *row = (uint8_t) _combine(*row, _shift_lanes(*src, left, right) & mask, mask, mode);
+}
+
+uint8_t _plot(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, LCD_DrawMode mode) {
+    if ((uint16_t) x >= LCD_WIDTH_IN_PIXEL || (uint16_t) y >= LCD_HEIGHT_IN_PIXEL)
+        return 0;
+    uint16_t index = (uint16_t) (x + (y >> 3) * LCD_WIDTH_IN_CHUNK);
+    if (LCD_BUFFER_HOLDS(hlcd, index)) {
+        uint8_t bit = (uint8_t) (1 << (y & 7));
+        uint8_t *p  = &hlcd->frame[LCD_BUFFER_INDEX(hlcd, index)];
+        *p = (uint8_t) _combine(*p, bit, bit, mode);
+    }
+    return 1;
+}
+
+int16_t _bank_of(int16_t y) {
+    return (int16_t) (y >= 0 ? y / 8 : -((7 - y) / 8));
+}
+
+uint8_t *_bank_row(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    return hlcd->frame + LCD_BUFFER_INDEX(hlcd, bank * LCD_WIDTH_IN_CHUNK);
+}
+
+void _put_column(LCD_HandleTypeDef *hlcd, uint8_t x, int16_t bank, uint16_t bits, uint16_t mask, LCD_DrawMode mode) {
+    for (uint8_t half = 0; half < 2; half++, bank++, bits >>= 8, mask >>= 8) {
+        if (bank < LCD_HELD_BANK_LOW(hlcd) || bank > LCD_HELD_BANK_HIGH(hlcd) || !(mask & 0xff))
+            continue;
+        uint8_t *p = _bank_row(hlcd, (uint8_t) bank) + x;
+        *p = (uint8_t) _combine(*p, bits & 0xff, mask & 0xff, mode);
+    }
+}
+
+void _mark_pixels(LCD_HandleTypeDef *hlcd, int32_t x_low, int32_t y_low, int32_t x_high, int32_t y_high) {
+    if (x_low < 0) x_low = 0;
+    if (y_low < 0) y_low = 0;
+    if (x_high > LCD_WIDTH_IN_PIXEL) x_high = LCD_WIDTH_IN_PIXEL;
+    if (y_high > LCD_HEIGHT_IN_PIXEL) y_high = LCD_HEIGHT_IN_PIXEL;
+    if (x_low >= x_high || y_low >= y_high)
+        return;
+    LCDx_mark_dirty(hlcd, (uint8_t) x_low, (uint8_t) (y_low >> 3), (uint8_t) (x_high - x_low),
+                    (uint8_t) (((y_high - 1) >> 3) - (y_low >> 3) + 1));
+}
+
+void LCDx_draw_pixel(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, LCD_DrawMode mode) {
+    if (_plot(hlcd, x, y, mode))
+        LCDx_mark_dirty(hlcd, (uint8_t) x, (uint8_t) (y >> 3), 1, 1);
+}
+
+uint8_t LCDx_get_pixel(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y) {
+    if ((uint16_t) x >= LCD_WIDTH_IN_PIXEL || (uint16_t) y >= LCD_HEIGHT_IN_PIXEL)
+        return 0;
+    uint16_t index = (uint16_t) (x + (y >> 3) * LCD_WIDTH_IN_CHUNK);
+    if (!LCD_BUFFER_HOLDS(hlcd, index))
+        return 0;
+    return (hlcd->frame[LCD_BUFFER_INDEX(hlcd, index)] >> (y & 7)) & 1;
+}
+
+void LCDx_fill_rect(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode) {
+    int32_t x_low  = x < 0 ? 0 : x;
+    int32_t x_high = (int32_t) x + width > LCD_WIDTH_IN_PIXEL ? LCD_WIDTH_IN_PIXEL : (int32_t) x + width;
+    int32_t y_low  = y < 0 ? 0 : y;
+    int32_t y_high = (int32_t) y + height > LCD_HEIGHT_IN_PIXEL ? LCD_HEIGHT_IN_PIXEL : (int32_t) y + height;
+    if (x_low >= x_high || y_low >= y_high)
+        return;
+
+    uint8_t bank_low  = (uint8_t) (y_low >> 3);
+    uint8_t bank_high = (uint8_t) ((y_high - 1) >> 3);
+    uint8_t first     = bank_low > LCD_HELD_BANK_LOW(hlcd) ? bank_low : LCD_HELD_BANK_LOW(hlcd);
+    uint8_t last      = bank_high < LCD_HELD_BANK_HIGH(hlcd) ? bank_high : LCD_HELD_BANK_HIGH(hlcd);
+    for (uint8_t bank = first; bank <= last; bank++) {
+        uint8_t mask = 0xff;
+        if (bank == bank_low)
+            mask &= (uint8_t) (0xff << (y_low & 7));
+        if (bank == bank_high)
+            mask &= (uint8_t) (0xff >> (7 - ((y_high - 1) & 7)));
+        _fill_span(_bank_row(hlcd, bank) + x_low, (uint16_t) (x_high - x_low), mask, mode);
+    }
+    LCDx_mark_dirty(hlcd, (uint8_t) x_low, bank_low, (uint8_t) (x_high - x_low), (uint8_t) (bank_high - bank_low + 1));
+}
+
+void LCDx_draw_hline(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t length, LCD_DrawMode mode) {
+    LCDx_fill_rect(hlcd, x, y, length, 1, mode);
+}
+
+void LCDx_draw_vline(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t length, LCD_DrawMode mode) {
+    LCDx_fill_rect(hlcd, x, y, 1, length, mode);
+}
+
+void LCDx_draw_rect(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode) {
+    if (width <= 0 || height <= 0)
+        return;
+    //sides skip the corners, so every pixel is drawn once
+    LCDx_draw_hline(hlcd, x, y, width, mode);
+    if (height > 1)
+        LCDx_draw_hline(hlcd, x, (int16_t) (y + height - 1), width, mode);
+    if (height > 2) {
+        LCDx_draw_vline(hlcd, x, (int16_t) (y + 1), (int16_t) (height - 2), mode);
+        if (width > 1)
+            LCDx_draw_vline(hlcd, (int16_t) (x + width - 1), (int16_t) (y + 1), (int16_t) (height - 2), mode);
+    }
+}
+
+void LCDx_draw_line(LCD_HandleTypeDef *hlcd, int16_t x0, int16_t y0, int16_t x1, int16_t y1, LCD_DrawMode mode) {
+    if (y0 == y1) {
+        LCDx_draw_hline(hlcd, x0 < x1 ? x0 : x1, y0, (int16_t) ((x0 < x1 ? x1 - x0 : x0 - x1) + 1), mode);
+        return;
+    }
+    if (x0 == x1) {
+        LCDx_draw_vline(hlcd, x0, y0 < y1 ? y0 : y1, (int16_t) ((y0 < y1 ? y1 - y0 : y0 - y1) + 1), mode);
+        return;
+    }
+
+    int32_t dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int32_t dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int8_t  sx = x1 > x0 ? 1 : -1;
+    int8_t  sy = y1 > y0 ? 1 : -1;
+    int32_t error = dx + dy;
+    //box of drawn pixels, marked as changed once at the end
+    int16_t x_low = LCD_WIDTH_IN_PIXEL, x_high = -1, y_low = LCD_HEIGHT_IN_PIXEL, y_high = -1;
+
+    for (;;) {
+        if (_plot(hlcd, x0, y0, mode)) {
+            if (x0 < x_low) x_low = x0;
+            if (x0 > x_high) x_high = x0;
+            if (y0 < y_low) y_low = y0;
+            if (y0 > y_high) y_high = y0;
+        }
+        if (x0 == x1 && y0 == y1)
+            break;
+        int32_t error2 = 2 * error;
+        if (error2 >= dy) {
+            error += dy;
+            x0 += sx;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y0 += sy;
+        }
+    }
+    if (x_high >= 0)
+        LCDx_mark_dirty(hlcd, (uint8_t) x_low, (uint8_t) (y_low >> 3), (uint8_t) (x_high - x_low + 1),
+                        (uint8_t) ((y_high >> 3) - (y_low >> 3) + 1));
+}
+
+void LCDx_draw_bitmap(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, const uint8_t *bitmap, int16_t width,
+                      int16_t height, LCD_DrawMode mode) {
+    if (width <= 0 || height <= 0)
+        return;
+    int32_t column_low  = x < 0 ? -(int32_t) x : 0;
+    int32_t column_high = (int32_t) x + width > LCD_WIDTH_IN_PIXEL ? LCD_WIDTH_IN_PIXEL - x : width;
+    if (column_low >= column_high)
+        return;
+
+    int16_t top_bank = _bank_of(y);
+    uint8_t shift    = (uint8_t) (y - top_bank * 8);
+    int16_t bands    = (int16_t) ((height + 7) / 8);
+    uint16_t count   = (uint16_t) (column_high - column_low);
+
+    for (int16_t band = 0; band < bands; band++) {
+        const uint8_t *src = bitmap + (int32_t) band * width + column_low;
+        uint8_t band_mask  = (band == bands - 1 && (height & 7)) ? (uint8_t) ((1 << (height & 7)) - 1) : 0xff;
+        int16_t bank       = (int16_t) (top_bank + band);
+
+        //a band straddles two banks unless y is a multiple of 8
+        if (bank >= LCD_HELD_BANK_LOW(hlcd) && bank <= LCD_HELD_BANK_HIGH(hlcd))
+            _blit_span(_bank_row(hlcd, (uint8_t) bank) + x + column_low, src, count, band_mask, shift, 0, mode);
+        bank++;
+        if (shift && (band_mask >> (8 - shift)) && bank >= LCD_HELD_BANK_LOW(hlcd) && bank <= LCD_HELD_BANK_HIGH(hlcd))
+            _blit_span(_bank_row(hlcd, (uint8_t) bank) + x + column_low, src, count, band_mask, 0,
+                       (uint8_t) (8 - shift), mode);
+    }
+    _mark_pixels(hlcd, x + column_low, y, x + column_high, (int32_t) y + height);
+}
+
+int16_t LCDx_draw_char(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, char chr, LCD_DrawMode mode) {
+    LCD_PROFILE_BEGIN();
+    uint8_t glyph = (uint8_t) chr >= LCD_FONT_FIRST_CHAR && (uint8_t) chr <= LCD_FONT_LAST_CHAR ?
+                    (uint8_t) chr - LCD_FONT_FIRST_CHAR : 0;
+    int16_t bank  = _bank_of(y);
+    uint8_t shift = (uint8_t) (y - bank * 8);
+    //cell mask, used by LCD_DRAW_COPY to clear background and spacing column
+    uint16_t mask = (uint16_t) (0xff << shift);
+
+    for (uint8_t column = 0; column < LCD_CHAR_WIDTH; column++) {
+        if ((uint16_t) (x + column) >= LCD_WIDTH_IN_PIXEL)
+            continue;
+        uint16_t bits = column < 5 ? LCD_GLYPH_COLUMN(glyph, shift, column) : 0;
+        _put_column(hlcd, (uint8_t) (x + column), bank, bits, mask, mode);
+    }
+    _mark_pixels(hlcd, x, y, (int32_t) x + LCD_CHAR_WIDTH, (int32_t) y + 8);
+    LCD_PROFILE_END(LCD_PROBE_GLYPH);
+    return (int16_t) (x + LCD_CHAR_WIDTH);
+}
+
+int16_t LCDx_draw_string(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, const char *str, LCD_DrawMode mode) {
+    for (; *str; str++) {
+        //characters left of LCD are skipped without drawing, right of LCD end the string
+        if (x <= -LCD_CHAR_WIDTH)
+            x = (int16_t) (x + LCD_CHAR_WIDTH);
+        else if (x < LCD_WIDTH_IN_PIXEL)
+            x = LCDx_draw_char(hlcd, x, y, *str, mode);
+        else
+            break;
+    }
+    return x;
+}
+
+//default instance wrappers
+
+void LCD_draw_pixel(int16_t x, int16_t y, LCD_DrawMode mode) {
+    LCDx_draw_pixel(&hlcd1, x, y, mode);
+}
+
+uint8_t LCD_get_pixel(int16_t x, int16_t y) {
+    return LCDx_get_pixel(&hlcd1, x, y);
+}
+
+void LCD_draw_hline(int16_t x, int16_t y, int16_t length, LCD_DrawMode mode) {
+    LCDx_draw_hline(&hlcd1, x, y, length, mode);
+}
+
+void LCD_draw_vline(int16_t x, int16_t y, int16_t length, LCD_DrawMode mode) {
+    LCDx_draw_vline(&hlcd1, x, y, length, mode);
+}
+
+void LCD_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, LCD_DrawMode mode) {
+    LCDx_draw_line(&hlcd1, x0, y0, x1, y1, mode);
+}
+
+void LCD_draw_rect(int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode) {
+    LCDx_draw_rect(&hlcd1, x, y, width, height, mode);
+}
+
+void LCD_fill_rect(int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode) {
+    LCDx_fill_rect(&hlcd1, x, y, width, height, mode);
+}
+
+void LCD_draw_bitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t width, int16_t height, LCD_DrawMode mode) {
+    LCDx_draw_bitmap(&hlcd1, x, y, bitmap, width, height, mode);
+}
+
+int16_t LCD_draw_char(int16_t x, int16_t y, char chr, LCD_DrawMode mode) {
+    return LCDx_draw_char(&hlcd1, x, y, chr, mode);
+}
+
+int16_t LCD_draw_string(int16_t x, int16_t y, const char *str, LCD_DrawMode mode) {
+    return LCDx_draw_string(&hlcd1, x, y, str, mode);
+}
@@ -0,0 +1,185 @@
+/**
+*  @file lcd_5110_gfx.h
+*  @brief pixel graphics on LCD 5110 buffer
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_GFX
+#define LCD_5110_GFX
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+#define LCD_WIDTH_IN_PIXEL                      84
+#define LCD_HEIGHT_IN_PIXEL                     48
+
+/**
+ * @brief how drawn pixels combine with buffer
+ */
+typedef enum {
+    LCD_DRAW_CLEAR = 0,//drawn pixels are turned off
+    LCD_DRAW_SET,//drawn pixels are turned on
+    LCD_DRAW_XOR,//drawn pixels are inverted
+    LCD_DRAW_COPY,//bitmaps and characters overwrite their rectangle, zero bits included; same as LCD_DRAW_SET for shapes
+} LCD_DrawMode;
+
+/**
+ * @brief draws a pixel - coordinates out of LCD are ignored
+ * @param hlcd LCD handle
+ * @param x 0-83
+ * @param y 0-47
+ * @param mode LCD_DRAW_CLEAR, LCD_DRAW_SET or LCD_DRAW_XOR
+ */
+void LCDx_draw_pixel(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, LCD_DrawMode mode);
+
+/**
+ * @brief reads a pixel of buffer
+ * @param hlcd LCD handle
+ * @param x 0-83
+ * @param y 0-47
+ * @return 1 if pixel is on, 0 if it is off or out of buffer
+ */
+uint8_t LCDx_get_pixel(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y);
+
+/**
+ * @brief draws a horizontal line from (x, y) to the right
+ * @param hlcd LCD handle
+ * @param length in pixels
+ */
+void LCDx_draw_hline(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t length, LCD_DrawMode mode);
+
+/**
+ * @brief draws a vertical line from (x, y) downwards
+ * @param hlcd LCD handle
+ * @param length in pixels
+ */
+void LCDx_draw_vline(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t length, LCD_DrawMode mode);
+
+/**
+ * @brief draws a line between two pixels, both included (Bresenham)
+ * @param hlcd LCD handle
+ * @note parts out of LCD are clipped, each pixel is drawn once so LCD_DRAW_XOR lines can be erased by drawing again
+ */
+void LCDx_draw_line(LCD_HandleTypeDef *hlcd, int16_t x0, int16_t y0, int16_t x1, int16_t y1, LCD_DrawMode mode);
+
+/**
+ * @brief draws outline of a rectangle
+ * @param hlcd LCD handle
+ * @param x left
+ * @param y top
+ * @param width in pixels
+ * @param height in pixels
+ */
+void LCDx_draw_rect(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode);
+
+/**
+ * @brief fills a rectangle - each bank is filled by one mask, four columns at a time
+ * @param hlcd LCD handle
+ * @param x left
+ * @param y top
+ * @param width in pixels
+ * @param height in pixels
+ */
+void LCDx_fill_rect(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode);
+
+/**
+ * @brief draws a 1-bpp bitmap at any pixel position
+ * @param hlcd LCD handle
+ * @param x left, may be out of LCD
+ * @param y top, may be out of LCD and need not be a multiple of 8
+ * @param bitmap laid out like LCD buffer - (height + 7) / 8 bands of `width` bytes, LSB on top
+ * @param width in pixels
+ * @param height in pixels
+ * @param mode LCD_DRAW_COPY overwrites the rectangle, other modes only act on 1 bits
+ */
+void LCDx_draw_bitmap(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, const uint8_t *bitmap, int16_t width,
+                      int16_t height, LCD_DrawMode mode);
+
+/**
+ * @brief draws an 8x6 character cell with its top-left pixel at (x, y) - y need not be a multiple of 8
+ * @param hlcd LCD handle
+ * @param chr ' ' to '~', others are drawn as ' '
+ * @param mode LCD_DRAW_COPY also clears background of cell, other modes only act on glyph pixels
+ * @return x of next character
+ */
+int16_t LCDx_draw_char(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, char chr, LCD_DrawMode mode);
+
+/**
+ * @brief draws a string of 8x6 characters at any pixel position, clipped at LCD edges
+ * @param hlcd LCD handle
+ * @param x left of first character, may be negative for scrolling text
+ * @param y top of characters
+ * @return x after last drawn character
+ */
+int16_t LCDx_draw_string(LCD_HandleTypeDef *hlcd, int16_t x, int16_t y, const char *str, LCD_DrawMode mode);
+
+/**
+ * @brief draws a pixel - coordinates out of LCD are ignored
+ * @param x 0-83
+ * @param y 0-47
+ * @param mode LCD_DRAW_CLEAR, LCD_DRAW_SET or LCD_DRAW_XOR
+ */
+void LCD_draw_pixel(int16_t x, int16_t y, LCD_DrawMode mode);
+
+/**
+ * @brief reads a pixel of buffer
+ * @param x 0-83
+ * @param y 0-47
+ * @return 1 if pixel is on, 0 if it is off or out of buffer
+ */
+uint8_t LCD_get_pixel(int16_t x, int16_t y);
+
+/**
+ * @brief draws a horizontal line from (x, y) to the right
+ * @param length in pixels
+ */
+void LCD_draw_hline(int16_t x, int16_t y, int16_t length, LCD_DrawMode mode);
+
+/**
+ * @brief draws a vertical line from (x, y) downwards
+ * @param length in pixels
+ */
+void LCD_draw_vline(int16_t x, int16_t y, int16_t length, LCD_DrawMode mode);
+
+/**
+ * @brief draws a line between two pixels, both included (Bresenham)
+ */
+void LCD_draw_line(int16_t x0, int16_t y0, int16_t x1, int16_t y1, LCD_DrawMode mode);
+
+/**
+ * @brief draws outline of a rectangle
+ */
+void LCD_draw_rect(int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode);
+
+/**
+ * @brief fills a rectangle
+ */
+void LCD_fill_rect(int16_t x, int16_t y, int16_t width, int16_t height, LCD_DrawMode mode);
+
+/**
+ * @brief draws a 1-bpp bitmap, laid out like LCD buffer, at any pixel position
+ */
+void LCD_draw_bitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t width, int16_t height, LCD_DrawMode mode);
+
+/**
+ * @brief draws an 8x6 character cell with its top-left pixel at (x, y) - y need not be a multiple of 8
+ * @return x of next character
+ */
+int16_t LCD_draw_char(int16_t x, int16_t y, char chr, LCD_DrawMode mode);
+
+/**
+ * @brief draws a string of 8x6 characters at any pixel position, clipped at LCD edges
+ * @return x after last drawn character
+ */
+int16_t LCD_draw_string(int16_t x, int16_t y, const char *str, LCD_DrawMode mode);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ *  @file lcd_5110_gray.c
+ *  @brief grayscale images on LCD 5110 by temporal dithering
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  A pixel dark in some of the planes looks gray once the planes are cycled faster than liquid crystal follows.
+ *  Only the columns of a bank between the first and last byte that differ from the plane on LCD are marked, so
+ *  black and white areas cost nothing per plane and the bus carries just the dithered parts.
+ */
+
+#include "userconf.h"
+#include "lcd_5110_gray.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+/*private in-lib functions*/
+
+/**
+ * @brief writes a plane into frame of LCD, marking changed column span of each bank
+ * @param hlcd LCD handle
+ * @param plane frame of LCD_BUFFER_SIZE bytes
+ */
+void _write_plane(LCD_HandleTypeDef *hlcd, const uint8_t *plane);
+
+void _write_plane(LCD_HandleTypeDef *hlcd, const uint8_t *plane) {
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        const uint8_t *source = plane + bank * LCD_WIDTH_IN_CHUNK;
+        uint8_t       *target = hlcd->frame + bank * LCD_WIDTH_IN_CHUNK;
+        uint8_t       low     = 0;
+        uint8_t       high    = LCD_WIDTH_IN_CHUNK;
+        while (low < high && source[low] == target[low])
+            low++;
+        while (high > low && source[high - 1] == target[high - 1])
+            high--;
+        if (low == high)
+            continue;
+        for (uint8_t x = low; x < high; x++)
+            target[x] = source[x];
+        LCDx_mark_dirty(hlcd, low, bank, high - low, 1);
+    }
+}
+
+HAL_StatusTypeDef LCDx_gray_start(LCD_HandleTypeDef *hlcd, LCD_Grayscale *gray, const uint8_t *planes,
+                                  uint8_t plane_count) {
+    if (plane_count == 0)
+        return HAL_ERROR;
+    gray->planes        = planes;
+    gray->plane_count   = plane_count;
+    gray->plane         = 0;
+    gray->planes_shown  = 0;
+    gray->planes_missed = 0;
+    gray->window_start  = HAL_GetTick();
+    gray->window_planes = 0;
+    gray->rate_mhz      = 0;
+#ifdef LCD_USE_DMA
+    while (LCDx_is_busy(hlcd));
+#endif
+    _write_plane(hlcd, planes);
+    LCDx_update(hlcd);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef LCDx_gray_next(LCD_HandleTypeDef *hlcd, LCD_Grayscale *gray) {
+#ifdef LCD_USE_DMA
+    if (LCDx_is_busy(hlcd)) {
+        gray->planes_missed++;
+        return HAL_BUSY;
+    }
+#endif
+    uint8_t next = (uint8_t) (gray->plane + 1 == gray->plane_count ? 0 : gray->plane + 1);
+    _write_plane(hlcd, gray->planes + next * LCD_BUFFER_SIZE);
+#ifdef LCD_USE_DMA
+    //bus may be taken by another LCD sharing it, plane stays marked and goes out next time
+    if (LCDx_update_async(hlcd) != HAL_OK) {
+        gray->planes_missed++;
+        return HAL_BUSY;
+    }
+#else
+    LCDx_update(hlcd);
+#endif
+    gray->plane = next;
+    gray->planes_shown++;
+    gray->window_planes++;
+
+    uint32_t elapsed = HAL_GetTick() - gray->window_start;
+    if (elapsed >= LCD_GRAY_RATE_WINDOW_MS) {
+        gray->rate_mhz      = (uint32_t) ((uint64_t) gray->window_planes * 1000000u / elapsed / gray->plane_count);
+        gray->window_start += elapsed;
+        gray->window_planes = 0;
+    }
+    return HAL_OK;
+}
+
+uint32_t LCD_gray_refresh_mhz(const LCD_Grayscale *gray) {
+    return gray->rate_mhz;
+}
+
+//default instance wrappers
+
+HAL_StatusTypeDef LCD_gray_start(LCD_Grayscale *gray, const uint8_t *planes, uint8_t plane_count) {
+    return LCDx_gray_start(&hlcd1, gray, planes, plane_count);
+}
+
+HAL_StatusTypeDef LCD_gray_next(LCD_Grayscale *gray) {
+    return LCDx_gray_next(&hlcd1, gray);
+}
+
+#endif
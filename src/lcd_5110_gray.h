@@ -0,0 +1,92 @@
+/**
+*  @file lcd_5110_gray.h
+*  @brief grayscale images on LCD 5110 by temporal dithering
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_GRAY
+#define LCD_5110_GRAY
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+//time over which LCD_gray_refresh_mhz is measured
+#ifndef LCD_GRAY_RATE_WINDOW_MS
+#define LCD_GRAY_RATE_WINDOW_MS                 1000
+#endif
+
+/**
+ * @brief bit-planes of a grayscale image cycled on an LCD - build them with tools/gray2lcd.py
+ * @note set it up with LCDx_gray_start, fields are private
+ */
+typedef struct {
+    const uint8_t *planes;//plane_count frames of LCD_BUFFER_SIZE bytes
+    uint8_t       plane_count;
+    uint8_t       plane;//plane on LCD
+    uint32_t      planes_shown;
+    uint32_t      planes_missed;//calls of LCDx_gray_next which found previous plane still in flight
+    uint32_t      window_start;//HAL_GetTick at start of rate window
+    uint16_t      window_planes;//planes shown in rate window
+    uint32_t      rate_mhz;//whole gray frames per second in mHz, over last rate window
+} LCD_Grayscale;
+
+/**
+ * @brief shows first plane of a grayscale image on an LCD
+ * @param hlcd LCD handle
+ * @param gray grayscale state to set up
+ * @param planes plane_count frames of LCD_BUFFER_SIZE bytes, kept until image is left
+ * @param plane_count bit-planes in image, plane_count + 1 gray levels
+ * @return HAL_ERROR if plane_count is 0, otherwise HAL_OK
+ * @note planes are written into frame of LCD, nothing else should draw there meanwhile
+ */
+HAL_StatusTypeDef LCDx_gray_start(LCD_HandleTypeDef *hlcd, LCD_Grayscale *gray, const uint8_t *planes,
+                                  uint8_t plane_count);
+
+/**
+ * @brief shows next plane - only columns whose bytes differ from plane on LCD are sent
+ * @param hlcd LCD handle
+ * @param gray grayscale state
+ * @return HAL_BUSY if previous plane is still in flight by DMA (call is counted as missed), otherwise HAL_OK
+ * @note call it at a fixed cadence, e.g. from a timer interrupt at 50-100 Hz - gray levels need the LCD to average
+ *       planes, so a cadence slower than its response time flickers
+ * @note with LCD_USE_DMA planes go out by LCDx_update_async, otherwise LCDx_update blocks until sent
+ */
+HAL_StatusTypeDef LCDx_gray_next(LCD_HandleTypeDef *hlcd, LCD_Grayscale *gray);
+
+/**
+ * @brief measured refresh rate of whole gray image, all planes shown once
+ * @param gray grayscale state
+ * @return rate in mHz over last LCD_GRAY_RATE_WINDOW_MS, 0 until first window ends
+ */
+uint32_t LCD_gray_refresh_mhz(const LCD_Grayscale *gray);
+
+/**
+ * @brief shows first plane of a grayscale image on default LCD, see LCDx_gray_start
+ * @param gray grayscale state to set up
+ * @param planes plane_count frames of LCD_BUFFER_SIZE bytes
+ * @param plane_count bit-planes in image
+ * @return HAL_ERROR if plane_count is 0, otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_gray_start(LCD_Grayscale *gray, const uint8_t *planes, uint8_t plane_count);
+
+/**
+ * @brief shows next plane on default LCD, see LCDx_gray_next
+ * @param gray grayscale state
+ * @return HAL_BUSY if previous plane is still in flight, otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_gray_next(LCD_Grayscale *gray);
+
+#endif
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ *  @file lcd_5110_layer.c
+ *  @brief off-screen layers composited into LCD 5110 frame
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Drawing into a layer points the LCD frame at the layer, so every drawing function works on layers and marks
+ *  what it touches. Those marks are both where the output has to be recomposited and where the LCD has to be
+ *  updated; compositing walks only them, four bytes at a time. Spans are taken and merged with interrupts masked
+ *  like every other mark, and a layer change holds scheduler frames back until it is composited, so a tick never
+ *  sends the layer's marks over a frame that does not show them yet.
+ */
+
+#include <string.h>
+#include "userconf.h"
+#include "lcd_5110_layer.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+/*private in-lib functions*/
+
+/**
+ * @brief widens column spans of one set of banks to cover another
+ * @param low low ends of spans to widen
+ * @param high high ends of spans to widen
+ * @param add_low low ends of spans to cover
+ * @param add_high high ends of spans to cover
+ */
+void _merge_spans(uint8_t *low, uint8_t *high, const uint8_t *add_low, const uint8_t *add_high);
+
+/**
+ * @brief blends a word of a layer with the word composited below it
+ * @param below composited bytes of lower layers
+ * @param layer bytes of layer
+ * @param blend LCD_BlendMode of layer
+ * @return composited bytes
+ */
+uint32_t _blend(uint32_t below, uint32_t layer, uint8_t blend);
+
+void _merge_spans(uint8_t *low, uint8_t *high, const uint8_t *add_low, const uint8_t *add_high) {
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        if (add_low[bank] >= add_high[bank])
+            continue;
+        if (low[bank] >= high[bank]) {
+            low[bank]  = add_low[bank];
+            high[bank] = add_high[bank];
+            continue;
+        }
+        if (add_low[bank] < low[bank])
+            low[bank] = add_low[bank];
+        if (add_high[bank] > high[bank])
+            high[bank] = add_high[bank];
+    }
+}
+
+uint32_t _blend(uint32_t below, uint32_t layer, uint8_t blend) {
+    switch (blend) {
+        case LCD_BLEND_OR:
+            return below | layer;
+        case LCD_BLEND_AND:
+            return below & layer;
+        case LCD_BLEND_XOR:
+            return below ^ layer;
+        default:
+            return layer;
+    }
+}
+
+void LCD_layer_init(LCD_Layer *layer, uint8_t *pixels, LCD_BlendMode blend) {
+    layer->pixels  = pixels;
+    layer->blend   = blend;
+    layer->visible = 1;
+    memset(pixels, 0, LCD_BUFFER_SIZE);
+    memset(layer->extent_low, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    memset(layer->extent_high, 0, LCD_HEIGHT_IN_CHUNK);
+}
+
+void LCDx_compositor_init(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, LCD_Layer *layers, uint8_t count) {
+    compositor->layers  = layers;
+    compositor->count   = count;
+    compositor->output  = hlcd->frame;
+    compositor->drawing = 0;
+    LCDx_mark_dirty(hlcd, 0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+}
+
+void LCDx_layer_begin(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, uint8_t index) {
+    if (compositor->drawing)
+        LCDx_layer_end(hlcd, compositor);
+    if (index >= compositor->count)
+        return;
+
+    //set LCD dirty spans aside, so the ones left at end are exactly what was drawn into layer
+    hlcd->composing = 1;
+    LCD_ENTER_CRITICAL();
+    memcpy(compositor->saved_low, hlcd->dirty_low, LCD_HEIGHT_IN_CHUNK);
+    memcpy(compositor->saved_high, hlcd->dirty_high, LCD_HEIGHT_IN_CHUNK);
+    memset(hlcd->dirty_low, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    memset(hlcd->dirty_high, 0, LCD_HEIGHT_IN_CHUNK);
+    LCD_EXIT_CRITICAL();
+    compositor->drawing = &compositor->layers[index];
+    hlcd->frame         = compositor->drawing->pixels;
+}
+
+void LCDx_layer_end(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor) {
+    LCD_Layer *layer = compositor->drawing;
+    if (!layer)
+        return;
+
+    LCD_ENTER_CRITICAL();
+    _merge_spans(layer->extent_low, layer->extent_high, hlcd->dirty_low, hlcd->dirty_high);
+    _merge_spans(hlcd->dirty_low, hlcd->dirty_high, compositor->saved_low, compositor->saved_high);
+    hlcd->flag.area_changed = 0;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        if (hlcd->dirty_low[bank] < hlcd->dirty_high[bank])
+            hlcd->flag.area_changed = 1;
+    LCD_EXIT_CRITICAL();
+    hlcd->frame         = compositor->output;
+    compositor->drawing = 0;
+}
+
+void LCDx_layer_set_visible(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, uint8_t index, uint8_t visible) {
+    if (index >= compositor->count || compositor->layers[index].visible == (visible != 0))
+        return;
+    LCD_Layer *layer = &compositor->layers[index];
+    layer->visible  = visible != 0;
+    hlcd->composing = 1;
+    //blank pixels of a copy or mask layer hide what is below them too, its extent is not all it changes
+    if (layer->blend == LCD_BLEND_COPY || layer->blend == LCD_BLEND_AND) {
+        LCDx_mark_dirty(hlcd, 0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+        return;
+    }
+    LCD_ENTER_CRITICAL();
+    _merge_spans(hlcd->dirty_low, hlcd->dirty_high, layer->extent_low, layer->extent_high);
+    hlcd->flag.area_changed = 1;
+    LCD_EXIT_CRITICAL();
+}
+
+void LCDx_layer_clear(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, uint8_t index) {
+    if (index >= compositor->count)
+        return;
+    LCD_Layer *layer = &compositor->layers[index];
+    hlcd->composing = 1;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        if (layer->extent_low[bank] < layer->extent_high[bank])
+            memset(layer->pixels + bank * LCD_WIDTH_IN_CHUNK + layer->extent_low[bank], 0,
+                   layer->extent_high[bank] - layer->extent_low[bank]);
+    LCD_ENTER_CRITICAL();
+    _merge_spans(hlcd->dirty_low, hlcd->dirty_high, layer->extent_low, layer->extent_high);
+    hlcd->flag.area_changed = 1;
+    LCD_EXIT_CRITICAL();
+    memset(layer->extent_low, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    memset(layer->extent_high, 0, LCD_HEIGHT_IN_CHUNK);
+}
+
+void LCDx_composite(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor) {
+    if (compositor->drawing)
+        LCDx_layer_end(hlcd, compositor);
+
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        uint16_t index = bank * LCD_WIDTH_IN_CHUNK + hlcd->dirty_low[bank];
+        uint16_t end   = bank * LCD_WIDTH_IN_CHUNK + hlcd->dirty_high[bank];
+
+        for (; index < end; index += 4) {
+            //a short tail is done as a word too, only its own bytes are stored back
+            uint8_t  count = end - index < 4 ? (uint8_t) (end - index) : 4;
+            uint32_t word  = 0, pixels = 0;
+            for (uint8_t n = 0; n < compositor->count; n++) {
+                LCD_Layer *layer = &compositor->layers[n];
+                if (!layer->visible)
+                    continue;
+                memcpy(&pixels, layer->pixels + index, count);
+                word = _blend(word, pixels, layer->blend);
+            }
+            memcpy(compositor->output + index, &word, count);
+        }
+    }
+    //frame shows its marks again
+    hlcd->composing = 0;
+}
+
+//default instance wrappers
+
+void LCD_compositor_init(LCD_Compositor *compositor, LCD_Layer *layers, uint8_t count) {
+    LCDx_compositor_init(&hlcd1, compositor, layers, count);
+}
+
+void LCD_layer_begin(LCD_Compositor *compositor, uint8_t index) {
+    LCDx_layer_begin(&hlcd1, compositor, index);
+}
+
+void LCD_layer_end(LCD_Compositor *compositor) {
+    LCDx_layer_end(&hlcd1, compositor);
+}
+
+void LCD_layer_set_visible(LCD_Compositor *compositor, uint8_t index, uint8_t visible) {
+    LCDx_layer_set_visible(&hlcd1, compositor, index, visible);
+}
+
+void LCD_layer_clear(LCD_Compositor *compositor, uint8_t index) {
+    LCDx_layer_clear(&hlcd1, compositor, index);
+}
+
+void LCD_composite(LCD_Compositor *compositor) {
+    LCDx_composite(&hlcd1, compositor);
+}
+
+#endif
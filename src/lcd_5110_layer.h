@@ -0,0 +1,154 @@
+/**
+*  @file lcd_5110_layer.h
+*  @brief off-screen layers composited into LCD 5110 frame
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_LAYER
+#define LCD_5110_LAYER
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+/**
+ * @brief how a layer combines with layers below it
+ */
+typedef enum {
+    LCD_BLEND_COPY = 0,//layer hides everything below it
+    LCD_BLEND_OR,//pixels of layer are turned on
+    LCD_BLEND_AND,//pixels off in layer are turned off - a mask
+    LCD_BLEND_XOR,//pixels of layer invert those below - cursors and selections
+} LCD_BlendMode;
+
+/**
+ * @brief a 504-byte 1-bpp off-screen frame, laid out like LCD buffer
+ */
+typedef struct {
+    uint8_t *pixels;
+    uint8_t blend;//LCD_BlendMode
+    uint8_t visible;
+    //area ever drawn into layer, one column span per bank as in LCD_HandleTypeDef
+    uint8_t extent_low[LCD_HEIGHT_IN_CHUNK];
+    uint8_t extent_high[LCD_HEIGHT_IN_CHUNK];
+} LCD_Layer;
+
+/**
+ * @brief a stack of layers composited into the frame of an LCD
+ * @note frame is output only - where it is composited it is rebuilt from the layers alone, what was in it is lost
+ */
+typedef struct {
+    LCD_Layer *layers;//bottom layer first
+    uint8_t   count;
+    uint8_t   *output;//frame layers are composited into
+    LCD_Layer *drawing;//layer being drawn into, 0 if none
+    //dirty spans of LCD set aside while drawing into a layer
+    uint8_t   saved_low[LCD_HEIGHT_IN_CHUNK];
+    uint8_t   saved_high[LCD_HEIGHT_IN_CHUNK];
+} LCD_Compositor;
+
+/**
+ * @brief sets up a layer with cleared pixels, visible
+ * @param layer layer to set up
+ * @param pixels 504 bytes owned by caller
+ * @param blend how layer combines with layers below it
+ */
+void LCD_layer_init(LCD_Layer *layer, uint8_t *pixels, LCD_BlendMode blend);
+
+/**
+ * @brief sets up a compositor writing into the current frame of an LCD and marks whole frame for compositing
+ * @param hlcd LCD handle
+ * @param compositor compositor to set up
+ * @param layers layers set up by LCD_layer_init, bottom first
+ * @param count count of layers
+ */
+void LCDx_compositor_init(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, LCD_Layer *layers, uint8_t count);
+
+/**
+ * @brief redirects all drawing functions of an LCD to a layer until LCDx_layer_end
+ * @param hlcd LCD handle
+ * @param compositor compositor of layer
+ * @param index layer to draw into
+ * @note a running LCD_Scheduler sends no frame from here until LCDx_composite; do not call LCDx_update yourself
+ *       before it either, it would send and clear marks the frame does not show yet
+ */
+void LCDx_layer_begin(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, uint8_t index);
+
+/**
+ * @brief ends drawing into a layer - drawn area is marked for compositing and remembered as part of layer extent
+ * @param hlcd LCD handle
+ * @param compositor compositor of layer
+ */
+void LCDx_layer_end(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor);
+
+/**
+ * @brief shows or hides a layer - an OR or XOR layer only marks its extent for compositing, a COPY or AND layer
+ *        marks the whole frame, as its blank pixels hide what is below them too
+ * @param hlcd LCD handle
+ * @param compositor compositor of layer
+ * @param index layer
+ * @param visible 1 to show, 0 to hide
+ */
+void LCDx_layer_set_visible(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, uint8_t index, uint8_t visible);
+
+/**
+ * @brief clears a layer - only its extent is cleared and marked for compositing
+ * @param hlcd LCD handle
+ * @param compositor compositor of layer
+ * @param index layer
+ */
+void LCDx_layer_clear(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor, uint8_t index);
+
+/**
+ * @brief composites visible layers into frame of LCD over its changed area only - call before LCDx_update
+ * @param hlcd LCD handle
+ * @param compositor compositor
+ * @note changed area is rebuilt from blank by the visible layers, bottom first - anything drawn into the frame
+ *       itself there is overwritten, draw a background into a bottom LCD_BLEND_COPY layer instead
+ * @note lets a scheduler held back by a layer change send frames again
+ */
+void LCDx_composite(LCD_HandleTypeDef *hlcd, LCD_Compositor *compositor);
+
+/**
+ * @brief sets up a compositor writing into the current frame of LCD and marks whole frame for compositing
+ */
+void LCD_compositor_init(LCD_Compositor *compositor, LCD_Layer *layers, uint8_t count);
+
+/**
+ * @brief redirects all drawing functions to a layer until LCD_layer_end
+ */
+void LCD_layer_begin(LCD_Compositor *compositor, uint8_t index);
+
+/**
+ * @brief ends drawing into a layer
+ */
+void LCD_layer_end(LCD_Compositor *compositor);
+
+/**
+ * @brief shows or hides a layer
+ */
+void LCD_layer_set_visible(LCD_Compositor *compositor, uint8_t index, uint8_t visible);
+
+/**
+ * @brief clears a layer
+ */
+void LCD_layer_clear(LCD_Compositor *compositor, uint8_t index);
+
+/**
+ * @brief composites visible layers into frame over its changed area only - call before LCD_update
+ */
+void LCD_composite(LCD_Compositor *compositor);
+
+#endif
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ *  @file lcd_5110_queue.c
+ *  @brief lock-free queue of draw commands for LCD 5110
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Tasks and ISRs never touch the buffer; they queue commands and one render owner draws them. Every slot has a
+ *  sequence number: a producer claims the next position with one compare-and-swap, fills the slot and then
+ *  publishes it by setting sequence to position + 1. The render owner takes published slots in order and hands
+ *  each back by setting sequence to position + LCD_QUEUE_LENGTH. A producer finding a slot not handed back yet
+ *  knows the queue is full and drops its command, so nobody ever waits for a lock or a 504 byte SPI transfer.
+ */
+
+#include <string.h>
+#include "userconf.h"
+#include "lcd_5110_queue.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+//claims a queue position - moves *position from expected to expected + 1 atomically, nonzero on success
+#ifndef LCD_QUEUE_CLAIM
+#define LCD_QUEUE_CLAIM(position, expected)     _claim_position(position, expected)
+#define LCD_QUEUE_CLAIM_BY_EXCLUSIVE_ACCESS
+#endif
+
+//orders memory accesses of slot contents against their sequence number
+#ifndef LCD_QUEUE_BARRIER
+#define LCD_QUEUE_BARRIER()                     __DMB()
+#endif
+
+/*private in-lib functions*/
+
+#ifdef LCD_QUEUE_CLAIM_BY_EXCLUSIVE_ACCESS
+/**
+ * @brief default LCD_QUEUE_CLAIM by exclusive load/store - needs Cortex-M3 or above
+ * @param position enqueue position of a queue
+ * @param expected position the caller saw
+ * @return 1 if position was claimed, 0 if another producer came first or an interrupt broke the exclusive access
+ */
+uint8_t _claim_position(volatile uint32_t *position, uint32_t expected);
+#endif
+
+/**
+ * @brief claims a slot for a producer
+ * @param queue queue
+ * @param producer id of producer, already checked
+ * @param position set to claimed position
+ * @return claimed slot, 0 if queue is full (drop is counted)
+ */
+LCD_QueueSlot *_claim_slot(LCD_DrawQueue *queue, uint8_t producer, uint32_t *position);
+
+/**
+ * @brief hands a filled slot to render owner
+ * @param queue queue
+ * @param slot slot from _claim_slot
+ * @param position position from _claim_slot
+ */
+void _publish_slot(LCD_DrawQueue *queue, LCD_QueueSlot *slot, uint32_t position);
+
+/**
+ * @brief queues a command without payload
+ * @param queue queue
+ * @param producer id of producer
+ * @param command command
+ * @param x x of command
+ * @param y y of command
+ * @param image image address
+ * @param length image size
+ * @return HAL_ERROR for an invalid producer, HAL_BUSY if queue is full, otherwise HAL_OK
+ */
+HAL_StatusTypeDef _queue_command_slot(LCD_DrawQueue *queue, uint8_t producer, uint8_t command, uint8_t x,
+                                      uint8_t y, const uint8_t *image, uint32_t length);
+
+/**
+ * @brief draws one command
+ * @param hlcd LCD handle
+ * @param queue queue
+ * @param slot published slot
+ */
+void _draw_slot(LCD_HandleTypeDef *hlcd, LCD_DrawQueue *queue, LCD_QueueSlot *slot);
+
+#ifdef LCD_QUEUE_CLAIM_BY_EXCLUSIVE_ACCESS
+uint8_t _claim_position(volatile uint32_t *position, uint32_t expected) {
+    if (__LDREXW(position) != expected) {
+        __CLREX();
+        return 0;
+    }
+    return __STREXW(expected + 1, position) == 0;
+}
+#endif
+
+LCD_QueueSlot *_claim_slot(LCD_DrawQueue *queue, uint8_t producer, uint32_t *position) {
+    uint32_t claimed = queue->enqueue_position;
+    for (;;) {
+        LCD_QueueSlot *slot    = &queue->slots[claimed & (LCD_QUEUE_LENGTH - 1)];
+        uint32_t      sequence = slot->sequence;
+        LCD_QUEUE_BARRIER();
+        int32_t       distance = (int32_t) (sequence - claimed);
+        if (distance == 0) {
+            if (LCD_QUEUE_CLAIM(&queue->enqueue_position, claimed)) {
+                *position = claimed;
+                return slot;
+            }
+        } else if (distance < 0) {
+            //slot still holds a command of the previous lap
+            queue->stats[producer].dropped++;
+            return 0;
+        }
+        //another producer came first, try its successor
+        claimed = queue->enqueue_position;
+    }
+}
+
+void _publish_slot(LCD_DrawQueue *queue, LCD_QueueSlot *slot, uint32_t position) {
+    LCD_QUEUE_BARRIER();
+    slot->sequence = position + 1;
+    queue->stats[slot->producer].enqueued++;
+}
+
+HAL_StatusTypeDef _queue_command_slot(LCD_DrawQueue *queue, uint8_t producer, uint8_t command, uint8_t x,
+                                      uint8_t y, const uint8_t *image, uint32_t length) {
+    if (producer >= LCD_QUEUE_MAX_PRODUCERS)
+        return HAL_ERROR;
+
+    uint32_t      position;
+    LCD_QueueSlot *slot = _claim_slot(queue, producer, &position);
+    if (!slot)
+        return HAL_BUSY;
+    slot->command  = command;
+    slot->producer = producer;
+    slot->x        = x;
+    slot->y        = y;
+    slot->image    = image;
+    slot->length   = length;
+    _publish_slot(queue, slot, position);
+    return HAL_OK;
+}
+
+void _draw_slot(LCD_HandleTypeDef *hlcd, LCD_DrawQueue *queue, LCD_QueueSlot *slot) {
+    uint16_t *cursor = &queue->cursor[slot->producer];
+    switch (slot->command) {
+        case LCD_QUEUE_GOTO:
+            if (slot->x < LCD_WIDTH_IN_CHUNK / 6 && slot->y < LCD_HEIGHT_IN_CHUNK)
+                *cursor = slot->x * 6 + slot->y * LCD_WIDTH_IN_CHUNK;
+            break;
+        case LCD_QUEUE_STRING:
+        case LCD_QUEUE_GLYPH:
+            hlcd->cursor_in_line_update = *cursor;
+            for (uint32_t i = 0; i < slot->length; i++)
+                LCDx_write_char_8x6(hlcd, (uint8_t) slot->text[i]);
+            *cursor = hlcd->cursor_in_line_update;
+            break;
+        case LCD_QUEUE_IMAGE:
+            LCDx_decompress_image(hlcd, (uint8_t *) slot->image, slot->length, slot->x, slot->y);
+            break;
+        case LCD_QUEUE_CLEAR:
+            LCDx_clear(hlcd);
+            *cursor = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+void LCD_queue_init(LCD_DrawQueue *queue) {
+    memset(queue, 0, sizeof(*queue));
+    for (uint32_t i = 0; i < LCD_QUEUE_LENGTH; i++)
+        queue->slots[i].sequence = i;
+}
+
+HAL_StatusTypeDef LCD_queue_goto(LCD_DrawQueue *queue, uint8_t producer, uint8_t x, uint8_t y) {
+    return _queue_command_slot(queue, producer, LCD_QUEUE_GOTO, x, y, 0, 0);
+}
+
+HAL_StatusTypeDef LCD_queue_string(LCD_DrawQueue *queue, uint8_t producer, const char *str) {
+    if (producer >= LCD_QUEUE_MAX_PRODUCERS)
+        return HAL_ERROR;
+
+    while (*str) {
+        uint32_t      position;
+        LCD_QueueSlot *slot = _claim_slot(queue, producer, &position);
+        if (!slot)
+            return HAL_BUSY;
+        uint32_t length = 0;
+        while (length < LCD_QUEUE_TEXT_LENGTH && str[length]) {
+            slot->text[length] = str[length];
+            length++;
+        }
+        slot->command  = LCD_QUEUE_STRING;
+        slot->producer = producer;
+        slot->length   = length;
+        _publish_slot(queue, slot, position);
+        str += length;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef LCD_queue_glyph(LCD_DrawQueue *queue, uint8_t producer, char chr) {
+    if (producer >= LCD_QUEUE_MAX_PRODUCERS)
+        return HAL_ERROR;
+
+    uint32_t      position;
+    LCD_QueueSlot *slot = _claim_slot(queue, producer, &position);
+    if (!slot)
+        return HAL_BUSY;
+    slot->command  = LCD_QUEUE_GLYPH;
+    slot->producer = producer;
+    slot->text[0]  = chr;
+    slot->length   = 1;
+    _publish_slot(queue, slot, position);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef LCD_queue_image(LCD_DrawQueue *queue, uint8_t producer, const uint8_t *compressed_image,
+                                  uint32_t length, uint8_t x_start, uint8_t y_start) {
+    return _queue_command_slot(queue, producer, LCD_QUEUE_IMAGE, x_start, y_start, compressed_image, length);
+}
+
+HAL_StatusTypeDef LCD_queue_clear(LCD_DrawQueue *queue, uint8_t producer) {
+    return _queue_command_slot(queue, producer, LCD_QUEUE_CLEAR, 0, 0, 0, 0);
+}
+
+void LCD_queue_get_stats(LCD_DrawQueue *queue, uint8_t producer, LCD_QueueStats *stats) {
+    if (producer >= LCD_QUEUE_MAX_PRODUCERS) {
+        stats->enqueued = 0;
+        stats->dropped  = 0;
+        return;
+    }
+    stats->enqueued = queue->stats[producer].enqueued;
+    stats->dropped  = queue->stats[producer].dropped;
+}
+
+uint16_t LCDx_queue_drain(LCD_HandleTypeDef *hlcd, LCD_DrawQueue *queue) {
+    uint32_t waiting = queue->enqueue_position - queue->dequeue_position;
+    if (waiting > queue->high_water)
+        queue->high_water = (uint16_t) waiting;
+
+    //render owner's own text cursor is left where it was
+    uint16_t cursor = hlcd->cursor_in_line_update;
+    uint16_t drawn  = 0;
+    for (;;) {
+        uint32_t      position = queue->dequeue_position;
+        LCD_QueueSlot *slot    = &queue->slots[position & (LCD_QUEUE_LENGTH - 1)];
+        if (slot->sequence != position + 1)
+            break;
+        LCD_QUEUE_BARRIER();
+        _draw_slot(hlcd, queue, slot);
+        LCD_QUEUE_BARRIER();
+        slot->sequence          = position + LCD_QUEUE_LENGTH;
+        queue->dequeue_position = position + 1;
+        drawn++;
+    }
+    hlcd->cursor_in_line_update = cursor;
+    return drawn;
+}
+
+uint16_t LCDx_queue_render(LCD_HandleTypeDef *hlcd, LCD_DrawQueue *queue) {
+    uint16_t drawn = LCDx_queue_drain(hlcd, queue);
+    LCDx_update(hlcd);
+    return drawn;
+}
+
+//default instance wrappers
+
+uint16_t LCD_queue_drain(LCD_DrawQueue *queue) {
+    return LCDx_queue_drain(&hlcd1, queue);
+}
+
+uint16_t LCD_queue_render(LCD_DrawQueue *queue) {
+    return LCDx_queue_render(&hlcd1, queue);
+}
+
+#endif
@@ -0,0 +1,189 @@
+/**
+*  @file lcd_5110_queue.h
+*  @brief lock-free queue of draw commands for LCD 5110
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_QUEUE
+#define LCD_5110_QUEUE
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+#ifndef LCD_USE_PAGED_MODE
+
+//slots of a queue, a power of 2
+#ifndef LCD_QUEUE_LENGTH
+#define LCD_QUEUE_LENGTH                        16
+#endif
+
+//producers of a queue, each task or ISR needs its own id
+#ifndef LCD_QUEUE_MAX_PRODUCERS
+#define LCD_QUEUE_MAX_PRODUCERS                 4
+#endif
+
+//characters carried by one slot, longer strings take several slots
+#ifndef LCD_QUEUE_TEXT_LENGTH
+#define LCD_QUEUE_TEXT_LENGTH                   14
+#endif
+
+#if LCD_QUEUE_LENGTH < 2 || (LCD_QUEUE_LENGTH & (LCD_QUEUE_LENGTH - 1))
+#error "LCD_QUEUE_LENGTH must be a power of 2"
+#endif
+
+/**
+ * @brief kinds of draw command
+ */
+typedef enum {
+    LCD_QUEUE_GOTO,
+    LCD_QUEUE_STRING,
+    LCD_QUEUE_GLYPH,
+    LCD_QUEUE_IMAGE,
+    LCD_QUEUE_CLEAR,
+} LCD_QueueCommand;
+
+/**
+ * @brief one queued command, fields are private
+ */
+typedef struct {
+    volatile uint32_t sequence;//position the slot is ready for, see lcd_5110_queue.c
+    uint8_t           command;//LCD_QueueCommand
+    uint8_t           producer;
+    uint8_t           x;
+    uint8_t           y;
+    const uint8_t     *image;
+    uint32_t          length;//of image or text
+    char              text[LCD_QUEUE_TEXT_LENGTH];
+} LCD_QueueSlot;
+
+/**
+ * @brief counters of a producer
+ */
+typedef struct {
+    uint32_t enqueued;//commands put in queue
+    uint32_t dropped;//commands lost to a full queue
+} LCD_QueueStats;
+
+/**
+ * @brief bounded multi-producer, single-consumer queue of draw commands
+ * @note set it up with LCD_queue_init, fields are private
+ */
+typedef struct {
+    LCD_QueueSlot           slots[LCD_QUEUE_LENGTH];
+    volatile uint32_t       enqueue_position;//next position claimed by a producer
+    uint32_t                dequeue_position;//next position taken by render owner
+    uint16_t                cursor[LCD_QUEUE_MAX_PRODUCERS];//text cursor of each producer, in line format
+    volatile LCD_QueueStats stats[LCD_QUEUE_MAX_PRODUCERS];//each written only by its producer
+    uint16_t                high_water;//most commands found waiting by a drain
+} LCD_DrawQueue;
+
+/**
+ * @brief sets up an empty queue, cursors of all producers at top left
+ * @param queue queue to set up
+ * @note call it before any producer or render owner runs
+ */
+void LCD_queue_init(LCD_DrawQueue *queue);
+
+/**
+ * @brief queues a move of producer's text cursor
+ * @param queue queue
+ * @param producer id of calling task or ISR, 0 to LCD_QUEUE_MAX_PRODUCERS - 1
+ * @param x x of char, 0-13
+ * @param y y of char, 0-5
+ * @return HAL_ERROR for an invalid producer, HAL_BUSY if queue is full (command is dropped), otherwise HAL_OK
+ * @note every producer has its own cursor, so text of different producers never interleaves
+ */
+HAL_StatusTypeDef LCD_queue_goto(LCD_DrawQueue *queue, uint8_t producer, uint8_t x, uint8_t y);
+
+/**
+ * @brief queues a string at producer's cursor, the string is copied
+ * @param queue queue
+ * @param producer id of calling task or ISR
+ * @param str string
+ * @return HAL_ERROR for an invalid producer, HAL_BUSY if queue filled up (rest of string is dropped), otherwise HAL_OK
+ * @note strings longer than LCD_QUEUE_TEXT_LENGTH take a slot per LCD_QUEUE_TEXT_LENGTH characters
+ */
+HAL_StatusTypeDef LCD_queue_string(LCD_DrawQueue *queue, uint8_t producer, const char *str);
+
+/**
+ * @brief queues a character at producer's cursor
+ * @param queue queue
+ * @param producer id of calling task or ISR
+ * @param chr ' ' to '~', others are written as ' '
+ * @return HAL_ERROR for an invalid producer, HAL_BUSY if queue is full (command is dropped), otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_queue_glyph(LCD_DrawQueue *queue, uint8_t producer, char chr);
+
+/**
+ * @brief queues a compressed image, see LCDx_decompress_image
+ * @param queue queue
+ * @param producer id of calling task or ISR
+ * @param compressed_image image compressed by BICTES - only its address is queued, keep it alive until drawn
+ * @param length size of compressed image in bytes
+ * @param x_start x of image in chunks
+ * @param y_start y of image in banks
+ * @return HAL_ERROR for an invalid producer, HAL_BUSY if queue is full (command is dropped), otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_queue_image(LCD_DrawQueue *queue, uint8_t producer, const uint8_t *compressed_image,
+                                  uint32_t length, uint8_t x_start, uint8_t y_start);
+
+/**
+ * @brief queues a clear of whole buffer, producer's cursor goes to top left
+ * @param queue queue
+ * @param producer id of calling task or ISR
+ * @return HAL_ERROR for an invalid producer, HAL_BUSY if queue is full (command is dropped), otherwise HAL_OK
+ */
+HAL_StatusTypeDef LCD_queue_clear(LCD_DrawQueue *queue, uint8_t producer);
+
+/**
+ * @brief gets counters of a producer
+ * @param queue queue
+ * @param producer id of producer
+ * @param stats filled with counters, zeroed for an invalid producer
+ */
+void LCD_queue_get_stats(LCD_DrawQueue *queue, uint8_t producer, LCD_QueueStats *stats);
+
+/**
+ * @brief draws queued commands into buffer of an LCD - only render owner may call it
+ * @param hlcd LCD handle
+ * @param queue queue
+ * @return count of commands drawn
+ * @note stops at a slot a preempted producer has claimed but not filled yet, the next call goes on from there
+ * @note use it when LCD is refreshed by a scheduler, otherwise see LCDx_queue_render
+ */
+uint16_t LCDx_queue_drain(LCD_HandleTypeDef *hlcd, LCD_DrawQueue *queue);
+
+/**
+ * @brief draws queued commands into buffer of an LCD and updates it - only render owner may call it
+ * @param hlcd LCD handle
+ * @param queue queue
+ * @return count of commands drawn
+ */
+uint16_t LCDx_queue_render(LCD_HandleTypeDef *hlcd, LCD_DrawQueue *queue);
+
+/**
+ * @brief draws queued commands into buffer of default LCD, see LCDx_queue_drain
+ * @param queue queue
+ * @return count of commands drawn
+ */
+uint16_t LCD_queue_drain(LCD_DrawQueue *queue);
+
+/**
+ * @brief draws queued commands into buffer of default LCD and updates it, see LCDx_queue_render
+ * @param queue queue
+ * @return count of commands drawn
+ */
+uint16_t LCD_queue_render(LCD_DrawQueue *queue);
+
+#endif
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ *  @file lcd_5110_sched.c
+ *  @brief timer driven refresh of LCD 5110
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Drawing only marks the buffer; a timer tick decides when marks go out. A frame is sent once the dirty spans
+ *  stopped growing for a tick, so a burst of draws becomes one update, unless the oldest change waited max latency.
+ *  Frames are never closer than the max FPS period, and a tick with nothing dirty costs a few compares.
+ *  Ticks preempt drawing of the main loop, and interrupts above the timer priority may draw or request while a
+ *  tick sends. So the update takes and clears the dirty spans with interrupts masked before it sends, and drawing
+ *  marks them with interrupts masked; a mark is either in the frame being sent or left for the next one. A request
+ *  is cleared before sending for the same reason. A tick may still find a draw half done - the lock is what keeps
+ *  such a frame back, and a compositor holds frames back from a layer change until it has composited.
+ */
+
+#include <string.h>
+#include "userconf.h"
+#include "lcd_5110_sched.h"
+
+//schedulers ticked by LCD_TIM_PeriodElapsedCallback
+static LCD_Scheduler *volatile schedulers[LCD_MAX_SCHEDULERS];
+
+/*private in-lib functions*/
+
+/**
+ * @brief one timer tick of a scheduler - sends a frame when it is due
+ * @param scheduler scheduler
+ */
+void _scheduler_tick(LCD_Scheduler *scheduler);
+
+void _scheduler_tick(LCD_Scheduler *scheduler) {
+    LCD_HandleTypeDef *hlcd = scheduler->hlcd;
+
+    if (scheduler->since_frame < UINT16_MAX)
+        scheduler->since_frame++;
+    //an LCD started by LCDx_Init_async comes up here, its first frame carries everything drawn meanwhile
+    if (!LCDx_is_ready(hlcd)) {
+        if (LCDx_Init_step(hlcd) == HAL_OK)
+            scheduler->since_frame = 0;
+        return;
+    }
+    //a due effect or power down queues its command, which makes the frame below
+    LCDx_step_effects(hlcd);
+    if (!hlcd->flag.area_changed && !hlcd->command_queue_length && !scheduler->requested) {
+        //nothing to send, frame is skipped
+        scheduler->pending_age = 0;
+        return;
+    }
+    if (scheduler->pending_age < UINT16_MAX)
+        scheduler->pending_age++;
+    //buffer may be half drawn, or its marks may be waiting for layers to be composited into it
+    if (scheduler->lock || hlcd->composing)
+        return;
+
+    uint8_t quiet = !memcmp(scheduler->seen_low, hlcd->dirty_low, LCD_HEIGHT_IN_CHUNK) &&
+                    !memcmp(scheduler->seen_high, hlcd->dirty_high, LCD_HEIGHT_IN_CHUNK);
+    memcpy(scheduler->seen_low, hlcd->dirty_low, LCD_HEIGHT_IN_CHUNK);
+    memcpy(scheduler->seen_high, hlcd->dirty_high, LCD_HEIGHT_IN_CHUNK);
+
+    if (scheduler->since_frame < scheduler->min_period)
+        return;
+    if (!quiet && scheduler->pending_age < scheduler->max_latency)
+        return;
+
+    //request is cleared before sending - one made while this frame goes out asks for the next frame
+#ifdef LCD_USE_DMA
+    uint8_t requested = scheduler->requested;
+    scheduler->requested = 0;
+    //previous frame still in flight, try again next tick
+    if (LCDx_update_async(hlcd) != HAL_OK) {
+        if (requested)
+            scheduler->requested = 1;
+        return;
+    }
+#else
+    scheduler->requested = 0;
+    LCDx_update(hlcd);
+#endif
+    if (!quiet)
+        scheduler->late_frames++;
+    scheduler->frames++;
+    scheduler->since_frame = 0;
+    scheduler->pending_age = 0;
+    memcpy(scheduler->seen_low, hlcd->dirty_low, LCD_HEIGHT_IN_CHUNK);
+    memcpy(scheduler->seen_high, hlcd->dirty_high, LCD_HEIGHT_IN_CHUNK);
+}
+
+HAL_StatusTypeDef LCDx_scheduler_start(LCD_HandleTypeDef *hlcd, LCD_Scheduler *scheduler, TIM_HandleTypeDef *htim,
+                                       uint32_t tick_hz, uint16_t max_fps, uint16_t max_latency_ms) {
+    if (tick_hz == 0 || max_fps == 0)
+        return HAL_ERROR;
+
+    uint32_t min_period  = tick_hz / max_fps;
+    uint32_t max_latency = (uint32_t) max_latency_ms * tick_hz / 1000;
+    scheduler->hlcd        = hlcd;
+    scheduler->htim        = htim;
+    scheduler->min_period  = (uint16_t) (min_period == 0 ? 1 : min_period > UINT16_MAX ? UINT16_MAX : min_period);
+    scheduler->max_latency = (uint16_t) (max_latency > UINT16_MAX ? UINT16_MAX : max_latency);
+    //first frame may go out at once
+    scheduler->since_frame = scheduler->min_period;
+    scheduler->pending_age = 0;
+    scheduler->lock        = 0;
+    scheduler->requested   = 0;
+    scheduler->frames      = 0;
+    scheduler->late_frames = 0;
+    memcpy(scheduler->seen_low, hlcd->dirty_low, LCD_HEIGHT_IN_CHUNK);
+    memcpy(scheduler->seen_high, hlcd->dirty_high, LCD_HEIGHT_IN_CHUNK);
+
+    //published last, the interrupt may tick other schedulers meanwhile
+    for (uint8_t i = 0; i < LCD_MAX_SCHEDULERS; i++) {
+        if (schedulers[i] == scheduler)
+            return HAL_TIM_Base_Start_IT(htim);
+    }
+    for (uint8_t i = 0; i < LCD_MAX_SCHEDULERS; i++) {
+        if (schedulers[i] == 0) {
+            schedulers[i] = scheduler;
+            return HAL_TIM_Base_Start_IT(htim);
+        }
+    }
+    return HAL_ERROR;
+}
+
+void LCD_scheduler_stop(LCD_Scheduler *scheduler) {
+    uint8_t timer_used = 0;
+    for (uint8_t i = 0; i < LCD_MAX_SCHEDULERS; i++) {
+        if (schedulers[i] == scheduler)
+            schedulers[i] = 0;
+        else if (schedulers[i] && schedulers[i]->htim == scheduler->htim)
+            timer_used = 1;
+    }
+    if (!timer_used)
+        HAL_TIM_Base_Stop_IT(scheduler->htim);
+}
+
+void LCD_scheduler_lock(LCD_Scheduler *scheduler) {
+    scheduler->lock++;
+}
+
+void LCD_scheduler_unlock(LCD_Scheduler *scheduler) {
+    if (scheduler->lock)
+        scheduler->lock--;
+}
+
+void LCD_scheduler_request(LCD_Scheduler *scheduler) {
+    scheduler->requested = 1;
+}
+
+void LCD_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    for (uint8_t i = 0; i < LCD_MAX_SCHEDULERS; i++) {
+        LCD_Scheduler *scheduler = schedulers[i];
+        if (scheduler && scheduler->htim == htim)
+            _scheduler_tick(scheduler);
+    }
+}
+
+//default instance wrappers
+
+HAL_StatusTypeDef LCD_scheduler_start(LCD_Scheduler *scheduler, TIM_HandleTypeDef *htim, uint32_t tick_hz,
+                                      uint16_t max_fps, uint16_t max_latency_ms) {
+    return LCDx_scheduler_start(&hlcd1, scheduler, htim, tick_hz, max_fps, max_latency_ms);
+}
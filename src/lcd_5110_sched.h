@@ -0,0 +1,108 @@
+/**
+*  @file lcd_5110_sched.h
+*  @brief timer driven refresh of LCD 5110
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_SCHED
+#define LCD_5110_SCHED
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+
+//max count of schedulers served by LCD_TIM_PeriodElapsedCallback
+#ifndef LCD_MAX_SCHEDULERS
+#define LCD_MAX_SCHEDULERS                      4
+#endif
+
+/**
+ * @brief refreshes an LCD from a timer interrupt - draws of a frame period go out as one update
+ * @note set it up with LCDx_scheduler_start, fields are private
+ */
+typedef struct {
+    LCD_HandleTypeDef *hlcd;
+    TIM_HandleTypeDef *htim;
+    uint16_t          min_period;//ticks between frame starts, from max FPS
+    uint16_t          max_latency;//ticks a change may wait for drawing to settle
+    uint16_t          since_frame;//ticks since last frame started
+    uint16_t          pending_age;//ticks since a change was first seen, 0 when nothing is pending
+    uint8_t           seen_low[LCD_HEIGHT_IN_CHUNK];//dirty spans at previous tick
+    uint8_t           seen_high[LCD_HEIGHT_IN_CHUNK];
+    volatile uint8_t  lock;//nesting of LCD_scheduler_lock
+    volatile uint8_t  requested;//frame asked for by LCD_scheduler_request
+    volatile uint32_t frames;//updates started
+    volatile uint32_t late_frames;//updates started by max latency while drawing was still going on
+} LCD_Scheduler;
+
+/**
+ * @brief starts refreshing an LCD from a timer - from now on only the scheduler updates it
+ * @param hlcd LCD handle
+ * @param scheduler scheduler to set up, must stay alive until LCD_scheduler_stop
+ * @param htim timer whose update interrupt ticks scheduler, set up with a period of 1 / tick_hz
+ * @param tick_hz tick rate of timer, e.g. 1000
+ * @param max_fps max count of updates per second
+ * @param max_latency_ms max time a change waits for drawing to settle before it is sent anyway
+ * @return HAL_ERROR if arguments are invalid or LCD_MAX_SCHEDULERS schedulers run, otherwise status of timer start
+ * @note a frame is sent once drawing went quiet for a tick, at most max_fps times a second and with nothing dirty
+ *       no frame is sent at all
+ * @note with LCD_USE_DMA frames go out by LCDx_update_async, otherwise LCDx_update runs in the timer interrupt -
+ *       give the timer a priority below SysTick and SPI
+ * @note in LCD_USE_PAGED_MODE the draw callback runs in the timer interrupt, call LCD_scheduler_request to redraw
+ * @note an LCD started by LCDx_Init_async is stepped up by scheduler - it may start right after LCDx_Init_async
+ */
+HAL_StatusTypeDef LCDx_scheduler_start(LCD_HandleTypeDef *hlcd, LCD_Scheduler *scheduler, TIM_HandleTypeDef *htim,
+                                       uint32_t tick_hz, uint16_t max_fps, uint16_t max_latency_ms);
+
+/**
+ * @brief stops a scheduler, its timer is stopped too if no other scheduler uses it
+ * @param scheduler scheduler
+ */
+void LCD_scheduler_stop(LCD_Scheduler *scheduler);
+
+/**
+ * @brief holds frames back while buffer is being drawn - pair every call with LCD_scheduler_unlock, may nest
+ * @param scheduler scheduler
+ * @note a frame is never sent half drawn; ticks falling inside the lock are only counted towards max latency
+ */
+void LCD_scheduler_lock(LCD_Scheduler *scheduler);
+
+/**
+ * @brief lets frames go out again, see LCD_scheduler_lock
+ * @param scheduler scheduler
+ */
+void LCD_scheduler_unlock(LCD_Scheduler *scheduler);
+
+/**
+ * @brief asks for a frame even though no drawing function marked anything, e.g. to redraw in paged mode
+ * @param scheduler scheduler
+ */
+void LCD_scheduler_request(LCD_Scheduler *scheduler);
+
+/**
+ * @brief starts refreshing default LCD from a timer, see LCDx_scheduler_start
+ * @param scheduler scheduler to set up
+ * @param htim timer whose update interrupt ticks scheduler
+ * @param tick_hz tick rate of timer
+ * @param max_fps max count of updates per second
+ * @param max_latency_ms max time a change waits for drawing to settle
+ * @return HAL_ERROR if arguments are invalid or LCD_MAX_SCHEDULERS schedulers run, otherwise status of timer start
+ */
+HAL_StatusTypeDef LCD_scheduler_start(LCD_Scheduler *scheduler, TIM_HandleTypeDef *htim, uint32_t tick_hz,
+                                      uint16_t max_fps, uint16_t max_latency_ms);
+
+/**
+ * @brief ticks schedulers of a timer - MUST BE called from HAL_TIM_PeriodElapsedCallback
+ * @param htim timer handle passed to HAL_TIM_PeriodElapsedCallback
+ */
+void LCD_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ *  @file lcd_5110_text.c
+ *  @brief fonts and UTF-8 text on LCD 5110 buffer
+ *  @author Behzad Seyfi
+ *  COPYRIGHT (c) 2018
+ *
+ *  Code points are mapped to glyphs through a sorted table of runs, so sparse fonts (e.g. ASCII + Arabic block)
+ *  need neither a full table nor a linear search. Glyphs are drawn by LCDx_draw_bitmap, at any pixel position.
+ */
+
+#include "userconf.h"
+#include "lcd_5110_text.h"
+#include "lcd_5110_font.h"
+
+const LCD_FontRange font_en_8x5_ranges[] = {{LCD_FONT_FIRST_CHAR, LCD_FONT_GLYPH_COUNT, 0}};
+
+const LCD_Font lcd_font_en_8x5 = {
+        .bitmaps     = &font_en_8x5[0][0],
+        .glyphs      = 0,
+        .ranges      = font_en_8x5_ranges,
+        .range_count = 1,
+        .fallback    = 0,
+        .height      = 8,
+        .width       = 5,
+        .advance     = 6,
+};
+
+/*private in-lib functions*/
+
+/**
+ * @brief decodes next code point of a UTF-8 string
+ * @param str string, moved past decoded sequence
+ * @return code point, LCD_REPLACEMENT_CHAR for malformed or overlong sequences and UTF-16 surrogates
+ * @note never reads past terminating zero
+ */
+uint32_t _utf8_next(const char **str);
+
+/**
+ * @brief finds bitmap and metrics of a glyph
+ * @param font font of glyph
+ * @param glyph glyph index
+ * @param bitmap receives first byte of glyph
+ * @param width receives columns of glyph
+ * @return advance of glyph
+ */
+uint8_t _glyph_metrics(const LCD_Font *font, uint16_t glyph, const uint8_t **bitmap, uint8_t *width);
+
+uint32_t _utf8_next(const char **str) {
+    static const uint32_t smallest[4] = {0, 0x80, 0x800, 0x10000};
+    const uint8_t *s = (const uint8_t *) *str;
+    uint32_t code_point;
+    uint8_t  extra;
+
+    if (s[0] < 0x80) {
+        *str += 1;
+        return s[0];
+    } else if ((s[0] & 0xe0) == 0xc0) {
+        code_point = s[0] & 0x1f;
+        extra      = 1;
+    } else if ((s[0] & 0xf0) == 0xe0) {
+        code_point = s[0] & 0x0f;
+        extra      = 2;
+    } else if ((s[0] & 0xf8) == 0xf0) {
+        code_point = s[0] & 0x07;
+        extra      = 3;
+    } else {
+        *str += 1;
+        return LCD_REPLACEMENT_CHAR;
+    }
+
+    for (uint8_t i = 1; i <= extra; i++) {
+        //terminating zero is not a continuation byte either, so it is never skipped
+        if ((s[i] & 0xc0) != 0x80) {
+            *str += i;
+            return LCD_REPLACEMENT_CHAR;
+        }
+        code_point = code_point << 6 | (s[i] & 0x3f);
+    }
+    *str += extra + 1;
+    //U+D800 to U+DFFF are halves of UTF-16 pairs, never characters of their own
+    if (code_point < smallest[extra] || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF))
+        return LCD_REPLACEMENT_CHAR;
+    return code_point;
+}
+
+uint8_t _glyph_metrics(const LCD_Font *font, uint16_t glyph, const uint8_t **bitmap, uint8_t *width) {
+    if (!font->glyphs) {
+        *bitmap = font->bitmaps + (uint32_t) glyph * font->width * ((font->height + 7) / 8);
+        *width  = font->width;
+        return font->advance;
+    }
+    *bitmap = font->bitmaps + font->glyphs[glyph].offset;
+    *width  = font->glyphs[glyph].width;
+    return font->glyphs[glyph].advance;
+}
+
+uint16_t LCD_font_find_glyph(const LCD_Font *font, uint32_t code_point) {
+    uint16_t low = 0, high = font->range_count;
+
+    while (low < high) {
+        uint16_t middle = (uint16_t) ((low + high) / 2);
+        const LCD_FontRange *range = &font->ranges[middle];
+        if (code_point < range->first)
+            high = middle;
+        else if (code_point - range->first >= range->count)
+            low = (uint16_t) (middle + 1);
+        else
+            return (uint16_t) (range->glyph + (code_point - range->first));
+    }
+    return font->fallback;
+}
+
+int16_t LCD_text_width(const LCD_Font *font, const char *str) {
+    const uint8_t *bitmap;
+    uint8_t       width;
+    int16_t       total = 0;
+
+    while (*str)
+        total = (int16_t) (total + _glyph_metrics(font, LCD_font_find_glyph(font, _utf8_next(&str)), &bitmap, &width));
+    return total;
+}
+
+int16_t LCDx_draw_glyph(LCD_HandleTypeDef *hlcd, const LCD_Font *font, int16_t x, int16_t y, uint32_t code_point,
+                        LCD_DrawMode mode) {
+    LCD_PROFILE_BEGIN();
+    const uint8_t *bitmap;
+    uint8_t       width;
+    uint8_t       advance = _glyph_metrics(font, LCD_font_find_glyph(font, code_point), &bitmap, &width);
+
+    LCDx_draw_bitmap(hlcd, x, y, bitmap, width, font->height, mode);
+    if (mode == LCD_DRAW_COPY && advance > width)
+        LCDx_fill_rect(hlcd, (int16_t) (x + width), y, (int16_t) (advance - width), font->height, LCD_DRAW_CLEAR);
+    LCD_PROFILE_END(LCD_PROBE_GLYPH);
+    return (int16_t) (x + advance);
+}
+
+int16_t LCDx_draw_text(LCD_HandleTypeDef *hlcd, const LCD_Font *font, int16_t x, int16_t y, const char *str,
+                       LCD_DrawMode mode) {
+    while (*str && x < LCD_WIDTH_IN_PIXEL)
+        x = LCDx_draw_glyph(hlcd, font, x, y, _utf8_next(&str), mode);
+    return x;
+}
+
+void LCDx_write_text(LCD_HandleTypeDef *hlcd, const LCD_Font *font, const char *str) {
+    uint8_t bands = (uint8_t) ((font->height + 7) / 8);
+
+    while (*str) {
+        const uint8_t *bitmap;
+        uint8_t       width;
+        uint16_t      glyph   = LCD_font_find_glyph(font, _utf8_next(&str));
+        uint8_t       advance = _glyph_metrics(font, glyph, &bitmap, &width);
+        uint8_t       x       = (uint8_t) (hlcd->cursor_in_line_update % LCD_WIDTH_IN_CHUNK);
+        uint8_t       bank    = (uint8_t) (hlcd->cursor_in_line_update / LCD_WIDTH_IN_CHUNK);
+
+        if (x + width > LCD_WIDTH_IN_CHUNK) {
+            x = 0;
+            bank += bands;
+        }
+        // if a new glyph is entered but buffer is full then regret it.
+        if (bank + bands > LCD_HEIGHT_IN_CHUNK)
+            return;
+        LCDx_draw_bitmap(hlcd, x, (int16_t) (bank * 8), bitmap, width, font->height, LCD_DRAW_COPY);
+        if (advance > width)
+            LCDx_fill_rect(hlcd, (int16_t) (x + width), (int16_t) (bank * 8), (int16_t) (advance - width),
+                           (int16_t) (bands * 8), LCD_DRAW_CLEAR);
+        //a glyph reaching right edge sends cursor to the next line of text
+        hlcd->cursor_in_line_update = x + advance < LCD_WIDTH_IN_CHUNK ?
+                                      (uint16_t) (x + advance + bank * LCD_WIDTH_IN_CHUNK) :
+                                      (uint16_t) ((bank + bands) * LCD_WIDTH_IN_CHUNK);
+    }
+}
+
+//default instance wrappers
+
+int16_t LCD_draw_glyph(const LCD_Font *font, int16_t x, int16_t y, uint32_t code_point, LCD_DrawMode mode) {
+    return LCDx_draw_glyph(&hlcd1, font, x, y, code_point, mode);
+}
+
+int16_t LCD_draw_text(const LCD_Font *font, int16_t x, int16_t y, const char *str, LCD_DrawMode mode) {
+    return LCDx_draw_text(&hlcd1, font, x, y, str, mode);
+}
+
+void LCD_write_text(const LCD_Font *font, const char *str) {
+    LCDx_write_text(&hlcd1, font, str);
+}
@@ -0,0 +1,132 @@
+/**
+*  @file lcd_5110_text.h
+*  @brief fonts and UTF-8 text on LCD 5110 buffer
+*  @author Behzad Seyfi
+*  (c) 2018
+*/
+
+#ifndef LCD_5110_TEXT
+#define LCD_5110_TEXT
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "lcd_5110.h"
+#include "lcd_5110_gfx.h"
+
+//code point returned for malformed UTF-8
+#define LCD_REPLACEMENT_CHAR                    0xFFFD
+
+/**
+ * @brief a run of consecutive code points with consecutive glyphs
+ */
+typedef struct {
+    uint32_t first;//first code point of run
+    uint16_t count;//code points in run
+    uint16_t glyph;//glyph of first code point
+} LCD_FontRange;
+
+/**
+ * @brief place and size of a glyph of a proportional font
+ */
+typedef struct {
+    uint16_t offset;//first byte of glyph in bitmaps
+    uint8_t  width;//columns of bitmap
+    uint8_t  advance;//x step to next glyph
+} LCD_Glyph;
+
+/**
+ * @brief a bitmap font - build with tools/bdf2lcd.py
+ * @note glyphs are laid out like LCD buffer: (height + 7) / 8 bands of `width` bytes, LSB on top
+ */
+typedef struct {
+    const uint8_t       *bitmaps;
+    const LCD_Glyph     *glyphs;//0 for monospace fonts, glyph i is then at i * width * bands
+    const LCD_FontRange *ranges;//sorted by code point - glyphs are found by binary search
+    uint16_t            range_count;
+    uint16_t            fallback;//glyph drawn for code points missing from font
+    uint8_t             height;//in pixels, may span several banks
+    uint8_t             width;//monospace fonts only
+    uint8_t             advance;//monospace fonts only
+} LCD_Font;
+
+//!built-in 5x7 ASCII font as an LCD_Font
+extern const LCD_Font lcd_font_en_8x5;
+
+/**
+ * @brief finds glyph of a code point
+ * @param font font to search
+ * @param code_point Unicode code point
+ * @return glyph index, font->fallback if font has no glyph for code point
+ */
+uint16_t LCD_font_find_glyph(const LCD_Font *font, uint32_t code_point);
+
+/**
+ * @brief width of a UTF-8 string in pixels
+ * @param font font of string
+ * @param str UTF-8 string
+ * @return sum of advances of glyphs
+ */
+int16_t LCD_text_width(const LCD_Font *font, const char *str);
+
+/**
+ * @brief draws a code point at any pixel position
+ * @param hlcd LCD handle
+ * @param font font of glyph
+ * @param x left
+ * @param y top
+ * @param code_point Unicode code point
+ * @param mode LCD_DRAW_COPY also clears background up to the advance, other modes only act on glyph pixels
+ * @return x of next glyph
+ */
+int16_t LCDx_draw_glyph(LCD_HandleTypeDef *hlcd, const LCD_Font *font, int16_t x, int16_t y, uint32_t code_point,
+                        LCD_DrawMode mode);
+
+/**
+ * @brief draws a UTF-8 string at any pixel position, clipped at LCD edges
+ * @param hlcd LCD handle
+ * @param font font of string
+ * @param x left of first glyph
+ * @param y top of glyphs
+ * @param str UTF-8 string - malformed sequences are drawn as LCD_REPLACEMENT_CHAR
+ * @return x after last glyph
+ * @note glyphs are drawn left to right in string order - right-to-left text and joined forms must be prepared by caller
+ */
+int16_t LCDx_draw_text(LCD_HandleTypeDef *hlcd, const LCD_Font *font, int16_t x, int16_t y, const char *str,
+                       LCD_DrawMode mode);
+
+/**
+ * @brief writes a UTF-8 string at cursor of buffer, like LCDx_write_string, with any font (cursor also goes forward)
+ * @param hlcd LCD handle
+ * @param font font of string
+ * @param str UTF-8 string
+ * @note a glyph not fitting the line goes to the next line of text; glyphs not fitting the LCD are dropped
+ */
+void LCDx_write_text(LCD_HandleTypeDef *hlcd, const LCD_Font *font, const char *str);
+
+/**
+ * @brief draws a code point at any pixel position
+ * @return x of next glyph
+ */
+int16_t LCD_draw_glyph(const LCD_Font *font, int16_t x, int16_t y, uint32_t code_point, LCD_DrawMode mode);
+
+/**
+ * @brief draws a UTF-8 string at any pixel position, clipped at LCD edges
+ * @return x after last glyph
+ */
+int16_t LCD_draw_text(const LCD_Font *font, int16_t x, int16_t y, const char *str, LCD_DrawMode mode);
+
+/**
+ * @brief writes a UTF-8 string at cursor of buffer, like LCD_write_string, with any font (cursor also goes forward)
+ * @param font font of string
+ * @param str UTF-8 string
+ */
+void LCD_write_text(const LCD_Font *font, const char *str);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
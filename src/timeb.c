@@ -1,5 +1,8 @@
 #include "userconf.h"
 
+//one copy for all translation units, userconf.h only declares it
+uint_fast32_t SYSCLOCKFREQ;
+
 void initializeDWTtimer(void)
 {
 	//Initiaize DWT Timer  
@@ -12,9 +15,13 @@ void initializeDWTtimer(void)
 
 
 void delayUS_DWT(uint32_t  us) {
-	DWT->CYCCNT = 0;
-	uint_fast32_t cycles = DWT->CYCCNT+SYSCLOCKFREQ*us;
-	//cycles += 
-	do {} while (DWT->CYCCNT < cycles);
+	//counter is left running, other users of CYCCNT keep their marks
+	uint32_t start = DWT->CYCCNT;
+	do {} while (!elapsedUS_DWT(start, us));
+}
+
+//@brief checks whether `us` microseconds passed since DWT->CYCCNT was `start` - safe across counter wrap
+uint8_t elapsedUS_DWT(uint32_t start, uint32_t us) {
+	return DWT->CYCCNT - start >= SYSCLOCKFREQ * us;
 }
 
@@ -15,6 +15,7 @@ extern "C" {
     
     void initializeDWTtimer(void);
     void delayUS_DWT(uint32_t  us);
+    uint8_t elapsedUS_DWT(uint32_t start, uint32_t us);
 
 #ifdef __cplusplus
 }  /* extern "C" */
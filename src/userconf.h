@@ -20,17 +20,52 @@ extern "C"
 #include "tim.h"
 #include "gpio.h"
 
-#include "timeb.h"
-#include "lcd_5110.h"
-
 //!GLOBALS
-//@brief System Clock in MHz
-    static uint_fast32_t SYSCLOCKFREQ;
+//@brief System Clock in MHz - defined in timeb.c, set by initializeDWTtimer
+    extern uint_fast32_t SYSCLOCKFREQ;
 
     
 //!define which spi handle is dedicated to lcd
 #define LCD_SPI_Handler hspi1
 
+//!uncomment to keep a copy of the frame last sent to lcd and send only bytes which really differ (+504 bytes RAM)
+//#define LCD_USE_SHADOW_BUFFER
+
+//!uncomment to enable non-blocking LCD_update_async by SPI DMA (Tx DMA channel must be linked to LCD_SPI_Handler)
+//#define LCD_USE_DMA
+
+//!uncomment to render bank by bank through LCD_set_draw_callback with an 84-byte buffer instead of a 504-byte frame
+//#define LCD_USE_PAGED_MODE
+
+//!uncomment to draw pixel-positioned text from a compile-time table of glyphs pre-shifted by 0-7 pixels (+7.6 KB flash)
+//#define LCD_USE_PRESHIFTED_FONT
+
+//!uncomment to count SPI transactions and bytes per update (LCD_get_bus_stats)
+//#define LCD_USE_BUS_STATS
+
+//!uncomment to see every SPI transaction (LCD_set_bus_monitor), e.g. to mirror LCD into an LCD_Emulator for screenshots
+//#define LCD_USE_BUS_MONITOR
+
+//!uncomment to measure cycles of update, SPI, glyph and decompress calls by DWT->CYCCNT (LCD_get_profile)
+//#define LCD_USE_PROFILING
+//!host builds without DWT may count cycles from their own source
+//#define LCD_PROFILE_CYCLES()  host_cycles()
+
+//!fixed cost of an SPI transaction in ns used by LCD_wire_time_us, measure it on your MCU
+//#define LCD_TRANSACTION_OVERHEAD_NS  3000
+
+//!lcd_5110_queue.h claims slots by LDREX/STREX; Cortex-M0 or host builds give their own compare-and-swap and barrier
+//#define LCD_QUEUE_CLAIM(position, expected)  __sync_bool_compare_and_swap(position, expected, (expected) + 1)
+//#define LCD_QUEUE_BARRIER()                  __sync_synchronize()
+
+//!dirty spans are shared by drawing and updates run from interrupts under PRIMASK; give another critical section here
+//#define LCD_ENTER_CRITICAL()  taskENTER_CRITICAL()
+//#define LCD_EXIT_CRITICAL()   taskEXIT_CRITICAL()
+
+//!driver headers come after options so they see them
+#include "timeb.h"
+#include "lcd_5110.h"
+
 #ifdef __cplusplus
 }  /* extern "C" */
 #endif
@@ -0,0 +1,448 @@
+/**
+ *  @file bench.c
+ *  @brief bus cost and CPU time of typical screens, printed as JSON
+ *
+ *  Each workload starts on a freshly initialized panel, draws a number of frames through the public API and sends
+ *  each by an update. Bytes and transactions are what the emulated chip received, wire time is LCD_wire_time_us of
+ *  them. CPU time is host time of drawing and updating, only comparable between runs on the same machine.
+ *  Throughput entries time one routine alone, without the bus, as host nanoseconds per unit it works on.
+ *  bench_check.py compares the output with bench_baseline.json.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "harness.h"
+#include "lcd_5110_console.h"
+#include "lcd_5110_field.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_text.h"
+
+#ifndef HARNESS_BUILD
+#define HARNESS_BUILD                           "default"
+#endif
+
+//icons of decompression workloads
+#define BENCH_ICONS                             4
+
+//shapes drawn per round of a primitive
+#define BENCH_SHAPES                            64
+
+typedef struct {
+    const char *name;
+    uint16_t   frames;
+    void       (*setup)(void);//drawn and sent before measuring, may be 0
+    void       (*frame)(uint16_t n);//draws frame n, the runner updates
+} BenchWorkload;
+
+typedef struct {
+    const char *name;
+    const char *unit;//what a round counts, e.g. decoded bytes
+    uint32_t   rounds;
+    void       (*setup)(void);//may be 0
+    uint32_t   (*round)(void);//returns units done
+} BenchThroughput;
+
+typedef struct {
+    uint8_t  width;
+    uint8_t  height;
+    uint32_t length;
+    uint8_t  data[64];
+} BenchIcon;
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t width;
+    int16_t height;
+} BenchShape;
+
+static HAL_StubChip *chip;
+static LCD_Field    fields[4];
+static int32_t      values[4];
+static LCD_Console  console;
+static BenchIcon    icons[BENCH_ICONS];
+static uint16_t     icon_x;
+static uint16_t     icon_y;
+static uint8_t      icon_shown;
+static uint8_t      screen_image[4 + LCD_BUFFER_SIZE * 3 / 2];
+static uint8_t      scratch[LCD_BUFFER_SIZE];
+static BenchShape   shapes[BENCH_SHAPES];
+static uint8_t      sprite[16 * 2];
+
+/**
+ * @brief sends changes of default LCD, by DMA chain in DMA builds
+ */
+static void show(void) {
+#ifdef LCD_USE_DMA
+    LCD_update_async();
+    hal_stub_dma_finish(&hspi1);
+#else
+    LCD_update();
+#endif
+}
+
+static uint64_t cpu_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+static void text_screen(uint16_t seed) {
+    char line[LCD_CONSOLE_COLUMNS + 1];
+    for (uint8_t y = 0; y < LCD_HEIGHT_IN_CHUNK; y++) {
+        for (uint8_t i = 0; i < LCD_CONSOLE_COLUMNS; i++)
+            line[i] = (char) (' ' + 1 + (seed * 7 + y * 31 + i * 13) % 94);
+        line[LCD_CONSOLE_COLUMNS] = 0;
+        LCD_goto_x_y_char_8x6(0, y);
+        LCD_write_string(line);
+    }
+}
+
+static void glyph_setup(void) {
+    text_screen(0);
+}
+
+static void glyph_frame(uint16_t n) {
+    uint32_t place = harness_random() % (LCD_CONSOLE_COLUMNS * LCD_HEIGHT_IN_CHUNK);
+    LCD_goto_x_y_char_8x6((uint8_t) (place % LCD_CONSOLE_COLUMNS), (uint8_t) (place / LCD_CONSOLE_COLUMNS));
+    LCD_write_char_8x6((uint8_t) ('A' + (n + harness_random()) % 26));
+}
+
+static void text_frame(uint16_t n) {
+    text_screen((uint16_t) (n + 1));
+}
+
+static void dashboard_setup(void) {
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_string("rpm");
+    LCD_goto_x_y_char_8x6(0, 1);
+    LCD_write_string("km/h");
+    LCD_goto_x_y_char_8x6(0, 2);
+    LCD_write_string("temp");
+    LCD_goto_x_y_char_8x6(0, 3);
+    LCD_write_string("odo");
+    LCD_field_init(&fields[0], 48, 0, 6, LCD_FIELD_DECIMAL, 0, 0);
+    LCD_field_init(&fields[1], 48, 1, 6, LCD_FIELD_DECIMAL, 0, 0);
+    LCD_field_init(&fields[2], 48, 2, 6, LCD_FIELD_DECIMAL, 1, 0);
+    LCD_field_init(&fields[3], 36, 3, 8, LCD_FIELD_HEX, 0, 1);
+    values[0] = 3000;
+    values[1] = 80;
+    values[2] = 215;
+    values[3] = 0x1000;
+    for (uint8_t i = 0; i < 4; i++)
+        LCD_field_set(&fields[i], values[i]);
+}
+
+static void dashboard_frame(uint16_t n) {
+    //20 Hz - rpm moves every frame, speed and temperature now and then, odometer steadily
+    hal_stub.tick += 50;
+    values[0] += (int32_t) (harness_random() % 201) - 100;
+    if (n % 4 == 0)
+        values[1] += (int32_t) (harness_random() % 3) - 1;
+    if (n % 20 == 0)
+        values[2] += (int32_t) (harness_random() % 3) - 1;
+    values[3] += 3;
+    for (uint8_t i = 0; i < 4; i++)
+        LCD_field_set(&fields[i], values[i]);
+}
+
+static void full_pic_frame(uint16_t n) {
+    static uint8_t picture[LCD_BUFFER_SIZE];
+    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+        picture[i] = (uint8_t) (i * 37 + (i / LCD_WIDTH_IN_CHUNK) * 11 + n * 101);
+    LCD_write_full_pic(picture);
+}
+
+static void icons_setup(void) {
+    static const uint8_t sizes[BENCH_ICONS][2] = {{8, 1}, {16, 2}, {12, 2}, {20, 3}};
+    uint8_t              image[20 * 3];
+    for (uint8_t k = 0; k < BENCH_ICONS; k++) {
+        BenchIcon *icon = &icons[k];
+        icon->width  = sizes[k][0];
+        icon->height = sizes[k][1];
+        //outlined box with a sparse interior, like a typical status icon
+        for (uint8_t y = 0; y < icon->height; y++)
+            for (uint8_t x = 0; x < icon->width; x++) {
+                uint8_t edge = x == 0 || x == icon->width - 1;
+                uint8_t byte = edge ? 0xff : 0;
+                if (!edge && y == 0)
+                    byte |= 0x01;
+                if (!edge && y == icon->height - 1)
+                    byte |= 0x80;
+                if (!edge && (x + k) % 5 == 0)
+                    byte |= (uint8_t) (0x18 << (y & 1));
+                image[y * icon->width + x] = byte;
+            }
+        icon->length = harness_encode(image, icon->width, icon->height, 0, icon->data);
+    }
+    icon_shown = 0;
+}
+
+/**
+ * @brief erases last icon and picks place of icon n
+ * @param n frame
+ * @return icon to draw
+ */
+static BenchIcon *next_icon(uint16_t n) {
+    if (icon_shown) {
+        BenchIcon *last = &icons[(n - 1) % BENCH_ICONS];
+        LCD_fill_rect((int16_t) icon_x, (int16_t) (icon_y * 8), last->width, (int16_t) (last->height * 8),
+                      LCD_DRAW_CLEAR);
+    }
+    BenchIcon *icon = &icons[n % BENCH_ICONS];
+    icon_x     = (uint16_t) ((n * 13) % (LCD_WIDTH_IN_CHUNK - icon->width));
+    icon_y     = (uint16_t) (n % (LCD_HEIGHT_IN_CHUNK - icon->height + 1));
+    icon_shown = 1;
+    return icon;
+}
+
+static void into_buffer_frame(uint16_t n) {
+    BenchIcon *icon = next_icon(n);
+    decompress_into_buffer(icon->data, LCD_get_frame(), icon_x, icon_y);
+    LCD_mark_dirty(0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+}
+
+static void decompress_frame(uint16_t n) {
+    BenchIcon *icon = next_icon(n);
+    LCD_decompress_image(icon->data, icon->length, icon_x, icon_y);
+}
+
+static void console_setup(void) {
+    char line[24];
+    LCD_console_init(&console);
+    for (uint8_t i = 0; i < LCD_HEIGHT_IN_CHUNK; i++) {
+        snprintf(line, sizeof(line), "boot step %u\n", i);
+        LCD_console_write(&console, line);
+    }
+    LCD_console_render(&console);
+}
+
+static void console_frame(uint16_t n) {
+    char line[24];
+    snprintf(line, sizeof(line), "t=%u v=%lu\n", n, (unsigned long) (harness_random() % 100000));
+    LCD_console_write(&console, line);
+    LCD_console_render(&console);
+}
+
+static const BenchWorkload workloads[] = {
+        {"glyph",       240, glyph_setup,     glyph_frame},
+        {"text_screen", 60,  0,               text_frame},
+        {"dashboard",   200, dashboard_setup, dashboard_frame},
+        {"full_pic",    60,  0,               full_pic_frame},
+        {"into_buffer", 120, icons_setup,     into_buffer_frame},
+        {"decompress",  120, icons_setup,     decompress_frame},
+        {"console",     120, console_setup,   console_frame},
+};
+
+/**
+ * @brief compresses a full screen whose chunks are non-blank with a chance of density in 8
+ * @param density 0-8
+ */
+static void screen_setup_density(uint8_t density) {
+    uint8_t image[LCD_BUFFER_SIZE];
+    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+        image[i] = harness_random() % 8 < density ? (uint8_t) (1 + harness_random() % 255) : 0;
+    harness_encode(image, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK, 0, screen_image);
+}
+
+static void dense_screen_setup(void) {
+    screen_setup_density(7);
+}
+
+static void sparse_screen_setup(void) {
+    screen_setup_density(1);
+}
+
+static uint32_t decode_screen_round(void) {
+    decompress_into_buffer(screen_image, scratch, 0, 0);
+    return LCD_BUFFER_SIZE;
+}
+
+static uint32_t decode_icons_round(void) {
+    uint32_t bytes = 0;
+    for (uint8_t k = 0; k < BENCH_ICONS; k++) {
+        decompress_into_buffer(icons[k].data, scratch, (uint16_t) (k * 20), k);
+        bytes += (uint32_t) icons[k].width * icons[k].height;
+    }
+    return bytes;
+}
+
+/**
+ * @brief places shapes up to half a screen in size all over the LCD, some partly outside it so clipping is timed too
+ */
+static void shapes_setup(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++) {
+        shapes[i].x      = (int16_t) (harness_random() % (LCD_WIDTH_IN_PIXEL + 16)) - 8;
+        shapes[i].y      = (int16_t) (harness_random() % (LCD_HEIGHT_IN_PIXEL + 16)) - 8;
+        shapes[i].width  = (int16_t) (1 + harness_random() % (LCD_WIDTH_IN_PIXEL / 2));
+        shapes[i].height = (int16_t) (1 + harness_random() % (LCD_HEIGHT_IN_PIXEL / 2));
+    }
+    for (uint8_t i = 0; i < sizeof(sprite); i++)
+        sprite[i] = (uint8_t) harness_random();
+}
+
+static uint32_t pixel_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_pixel(shapes[i].x, shapes[i].y, LCD_DRAW_XOR);
+    return BENCH_SHAPES;
+}
+
+static uint32_t hline_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_hline(shapes[i].x, shapes[i].y, shapes[i].width, LCD_DRAW_XOR);
+    return BENCH_SHAPES;
+}
+
+static uint32_t vline_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_vline(shapes[i].x, shapes[i].y, shapes[i].height, LCD_DRAW_XOR);
+    return BENCH_SHAPES;
+}
+
+static uint32_t line_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_line(shapes[i].x, shapes[i].y, (int16_t) (shapes[i].x + shapes[i].width),
+                      (int16_t) (shapes[i].y + shapes[i].height), LCD_DRAW_XOR);
+    return BENCH_SHAPES;
+}
+
+static uint32_t rect_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_rect(shapes[i].x, shapes[i].y, shapes[i].width, shapes[i].height, LCD_DRAW_XOR);
+    return BENCH_SHAPES;
+}
+
+static uint32_t fill_rect_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_fill_rect(shapes[i].x, shapes[i].y, shapes[i].width, shapes[i].height, LCD_DRAW_XOR);
+    return BENCH_SHAPES;
+}
+
+static uint32_t bitmap_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_bitmap(shapes[i].x, shapes[i].y, sprite, 16, 16, LCD_DRAW_XOR);
+    return BENCH_SHAPES;
+}
+
+static uint32_t get_pixel_round(void) {
+    uint8_t on = 0;
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        on ^= LCD_get_pixel(shapes[i].x, shapes[i].y);
+    //keeps reads from being dropped
+    scratch[0] ^= on;
+    return BENCH_SHAPES;
+}
+
+/**
+ * @brief writes a screen of text at the cursor, 14 x 6 cells from ' ' on
+ */
+static uint32_t write_char_round(void) {
+    LCD_goto_x_y_char_8x6(0, 0);
+    for (uint8_t i = 0; i < 14 * 6; i++)
+        LCD_write_char_8x6((uint8_t) (' ' + i));
+    return 14 * 6;
+}
+
+static uint32_t draw_char_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_char(shapes[i].x, shapes[i].y, (char) (' ' + i), LCD_DRAW_COPY);
+    return BENCH_SHAPES;
+}
+
+static uint32_t draw_glyph_round(void) {
+    for (uint8_t i = 0; i < BENCH_SHAPES; i++)
+        LCD_draw_glyph(&lcd_font_en_8x5, shapes[i].x, shapes[i].y, (uint32_t) (' ' + i), LCD_DRAW_COPY);
+    return BENCH_SHAPES;
+}
+
+static const BenchThroughput throughputs[] = {
+        {"decode_dense_screen",  "byte",  20000, dense_screen_setup,  decode_screen_round},
+        {"decode_sparse_screen", "byte",  20000, sparse_screen_setup, decode_screen_round},
+        {"decode_icons",         "byte",  40000, icons_setup,         decode_icons_round},
+        {"gfx_pixel",            "call",  20000, shapes_setup,        pixel_round},
+        {"gfx_get_pixel",        "call",  20000, shapes_setup,        get_pixel_round},
+        {"gfx_hline",            "call",  10000, shapes_setup,        hline_round},
+        {"gfx_vline",            "call",  10000, shapes_setup,        vline_round},
+        {"gfx_line",             "call",  5000,  shapes_setup,        line_round},
+        {"gfx_rect",             "call",  5000,  shapes_setup,        rect_round},
+        {"gfx_fill_rect",        "call",  5000,  shapes_setup,        fill_rect_round},
+        {"gfx_bitmap",           "call",  5000,  shapes_setup,        bitmap_round},
+        {"glyph_write_char",     "glyph", 5000,  0,                   write_char_round},
+        {"glyph_draw_char",      "glyph", 5000,  shapes_setup,        draw_char_round},
+        {"glyph_font",           "glyph", 5000,  shapes_setup,        draw_glyph_round},
+};
+
+/**
+ * @brief runs a workload and prints its JSON object
+ * @param workload workload
+ * @param last 1 if no object follows
+ */
+static void run(const BenchWorkload *workload, uint8_t last) {
+    static const uint32_t clocks[] = {1000000, 2000000, 4000000};
+
+    chip = harness_start(&hlcd1);
+    harness_seed(0x5110u + workload->frames);
+    if (workload->setup)
+        workload->setup();
+    show();
+
+    HarnessTraffic mark  = harness_traffic_mark(chip);
+    uint64_t       start = cpu_ns();
+    for (uint16_t n = 0; n < workload->frames; n++) {
+        workload->frame(n);
+        show();
+    }
+    uint64_t       spent   = cpu_ns() - start;
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+
+    printf("    {\"name\": \"%s\", \"frames\": %u, \"bytes\": %lu, \"transactions\": %lu,\n", workload->name,
+           workload->frames, (unsigned long) traffic.bytes, (unsigned long) traffic.transactions);
+    printf("     \"bytes_per_frame\": %lu, \"transactions_per_frame\": %lu,\n",
+           (unsigned long) ((traffic.bytes + workload->frames / 2) / workload->frames),
+           (unsigned long) ((traffic.transactions + workload->frames / 2) / workload->frames));
+    for (uint8_t i = 0; i < sizeof(clocks) / sizeof(clocks[0]); i++)
+        printf("%s\"wire_us_%lumhz\": %lu, ", i ? "" : "     ", (unsigned long) (clocks[i] / 1000000),
+               (unsigned long) ((LCD_wire_time_us(traffic.bytes, traffic.transactions, clocks[i]) +
+                                 workload->frames / 2) / workload->frames));
+    printf("\"cpu_ns_per_frame\": %lu}%s\n", (unsigned long) (spent / workload->frames), last ? "" : ",");
+}
+
+/**
+ * @brief times a routine and prints its JSON object
+ * @param throughput routine
+ * @param last 1 if no object follows
+ */
+static void run_throughput(const BenchThroughput *throughput, uint8_t last) {
+    harness_seed(0x5110u + throughput->rounds);
+    if (throughput->setup)
+        throughput->setup();
+
+    uint64_t units = 0;
+    uint64_t start = cpu_ns();
+    for (uint32_t n = 0; n < throughput->rounds; n++)
+        units += throughput->round();
+    uint64_t spent = cpu_ns() - start;
+
+    double ns_per_unit = units ? (double) spent / (double) units : 0;
+    printf("    {\"name\": \"%s\", \"unit\": \"%s\", \"units\": %llu, \"ns_per_unit\": %.3f, "
+           "\"units_per_s\": %.0f}%s\n", throughput->name, throughput->unit, (unsigned long long) units, ns_per_unit,
+           ns_per_unit > 0 ? 1e9 / ns_per_unit : 0, last ? "" : ",");
+}
+
+int main(void) {
+    uint8_t count = sizeof(workloads) / sizeof(workloads[0]);
+    printf("{\"build\": \"%s\", \"workloads\": [\n", HARNESS_BUILD);
+    for (uint8_t i = 0; i < count; i++)
+        run(&workloads[i], i == count - 1);
+    count = sizeof(throughputs) / sizeof(throughputs[0]);
+    printf("], \"throughput\": [\n");
+    for (uint8_t i = 0; i < count; i++)
+        run_throughput(&throughputs[i], i == count - 1);
+    printf("]}\n");
+    //a clean run prints nothing but JSON
+    return harness_failed() ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Compares bench output with the committed baseline.
+
+    bench_check.py BASELINE RESULT... [--cpu-slack=F] [--write-baseline] [--table]
+
+Each RESULT is the JSON printed by bench in one build. Bytes, transactions and modelled wire time must not exceed
+the baseline of the same build and workload. CPU time depends on the host, it is only checked with --cpu-slack,
+against F times the baseline - CPU time per frame of workloads and time per unit of throughput entries. --write-baseline stores the results as new baseline, --table prints the bus cost
+table of README.md from them.
+"""
+
+import json
+import sys
+
+# metrics which are exact on every host
+GATED = ("bytes", "transactions", "wire_us_1mhz", "wire_us_2mhz", "wire_us_4mhz")
+
+# host time of workloads and of throughput entries
+CPU = ("cpu_ns_per_frame", "ns_per_unit")
+
+# README rows, in order
+TITLES = (
+    ("glyph", "one glyph changed on a full text screen"),
+    ("text_screen", "whole text screen rewritten"),
+    ("dashboard", "four numeric fields at 20 Hz"),
+    ("full_pic", "`LCD_write_full_pic()`"),
+    ("into_buffer", "sparse icon by `decompress_into_buffer()` with the whole screen marked"),
+    ("decompress", "same icons by `LCD_decompress_image()`"),
+    ("console", "one line added to a scrolling `LCD_Console`"),
+)
+
+
+def load(path):
+    with open(path) as file:
+        return json.load(file)
+
+
+def by_name(result):
+    entries = result["workloads"] + result.get("throughput", [])
+    return {entry["name"]: entry for entry in entries}
+
+
+def check(baseline, results, cpu_slack):
+    failures = 0
+    for result in results:
+        build = result["build"]
+        known = baseline.get(build, {})
+        for name, workload in by_name(result).items():
+            if name not in known:
+                print(f"{build}/{name}: not in baseline, run make bench-baseline")
+                failures += 1
+                continue
+            base = known[name]
+            for metric in (metric for metric in GATED if metric in workload):
+                if workload[metric] > base[metric]:
+                    print(f"{build}/{name}: {metric} {workload[metric]} exceeds baseline {base[metric]}")
+                    failures += 1
+                elif workload[metric] < base[metric]:
+                    print(f"{build}/{name}: {metric} {workload[metric]} below baseline {base[metric]}, "
+                          f"run make bench-baseline to keep the gain")
+            for metric in (metric for metric in CPU if metric in workload):
+                if cpu_slack and workload[metric] > base[metric] * cpu_slack:
+                    print(f"{build}/{name}: {metric} {workload[metric]} exceeds {cpu_slack} x baseline {base[metric]}")
+                    failures += 1
+    print(f"bench: {failures} regressions" if failures else f"bench: {len(results)} builds within baseline")
+    return 1 if failures else 0
+
+
+def write_baseline(path, baseline, results):
+    for result in results:
+        baseline[result["build"]] = by_name(result)
+    with open(path, "w") as file:
+        json.dump(baseline, file, indent=1, sort_keys=True)
+        file.write("\n")
+    print(f"{path}: written")
+    return 0
+
+
+def table(results):
+    builds = {result["build"]: by_name(result) for result in results}
+    plain, shadow = builds["default"], builds["shadow"]
+    columns = (("Bytes", "bytes_per_frame"), ("Transactions", "transactions_per_frame"),
+               ("1 MHz (µs)", "wire_us_1mhz"), ("2 MHz (µs)", "wire_us_2mhz"), ("4 MHz (µs)", "wire_us_4mhz"))
+    print("| Workload | " + " | ".join(title for title, _ in columns) + " |")
+    print("|---" * (len(columns) + 1) + "|")
+    for name, title in TITLES:
+        cells = (f"{plain[name][metric]} / {shadow[name][metric]}" for _, metric in columns)
+        print(f"| {title} | " + " | ".join(cells) + " |")
+    return 0
+
+
+def main(argv):
+    options = [arg for arg in argv if arg.startswith("--")]
+    paths = [arg for arg in argv if not arg.startswith("--")]
+    if len(paths) < 2:
+        print(__doc__)
+        return 2
+    try:
+        baseline = load(paths[0])
+    except FileNotFoundError:
+        baseline = {}
+    results = [load(path) for path in paths[1:]]
+
+    if "--table" in options:
+        return table(results)
+    if "--write-baseline" in options:
+        return write_baseline(paths[0], baseline, results)
+    cpu_slack = 0.0
+    for option in options:
+        if option.startswith("--cpu-slack="):
+            cpu_slack = float(option.split("=", 1)[1])
+    return check(baseline, results, cpu_slack)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,196 @@
+/**
+ *  @file fuzz_decompress.c
+ *  @brief malformed compressed images - reads stay inside the given length, writes inside the marked rectangle
+ *
+ *  An input is x and y of the image in chunks, then the compressed image. Each input is decompressed into a frame
+ *  holding a pattern and streamed to a panel holding the same pattern, and checked that:
+ *  - decoding is the same whatever bytes follow the image, so nothing beyond length is read
+ *  - no byte outside the dirty spans changed
+ *  - the streamed panel shows what the frame holds, and both report the same status
+ *
+ *  Run by make check as a plain program, which mutates images of harness_encode with a fixed seed. Built with
+ *  -DHARNESS_LIBFUZZER (make fuzz) the main is left out and LLVMFuzzerTestOneInput is driven by libFuzzer.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "harness.h"
+
+#define TEST_NAME                               "fuzz_decompress"
+
+//largest input, and its copy followed by padding
+#define FUZZ_MAX_INPUT                          2048
+#define FUZZ_PADDING                            512
+
+//mutated inputs per corpus image
+#define FUZZ_MUTATIONS                          24
+
+static HAL_StubChip *chip;
+static uint8_t      pattern[LCD_BUFFER_SIZE];
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/**
+ * @brief decompresses an image followed by padding into a frame holding the pattern
+ * @param image compressed image
+ * @param length size of image
+ * @param padding byte put after image
+ * @param x x in chunks
+ * @param y y in banks
+ * @return status of LCD_decompress_image
+ */
+static HAL_StatusTypeDef decompress_padded(const uint8_t *image, uint32_t length, uint8_t padding, uint8_t x, uint8_t y) {
+    static uint8_t padded[FUZZ_MAX_INPUT + FUZZ_PADDING];
+    memcpy(padded, image, length);
+    memset(padded + length, padding, FUZZ_PADDING);
+    memcpy(LCD_get_frame(), pattern, LCD_BUFFER_SIZE);
+    return LCD_decompress_image(padded, length, x, y);
+}
+
+/**
+ * @brief checks that bytes outside dirty spans still hold the pattern
+ */
+static void check_outside_dirty(void) {
+    const uint8_t *frame   = LCD_get_frame();
+    uint16_t      changed = 0;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        for (uint8_t x = 0; x < LCD_WIDTH_IN_CHUNK; x++) {
+            uint16_t index = x + bank * LCD_WIDTH_IN_CHUNK;
+            if ((x < hlcd1.dirty_low[bank] || x >= hlcd1.dirty_high[bank]) && frame[index] != pattern[index])
+                changed++;
+        }
+    CHECK_EQUAL(changed, 0);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static uint8_t decoded[LCD_BUFFER_SIZE];
+    if (size < 2 || size - 2 > FUZZ_MAX_INPUT)
+        return 0;
+    if (!chip) {
+        chip = harness_start(&hlcd1);
+        for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+            pattern[i] = (uint8_t) (0x5a ^ (i * 7));
+    }
+    uint8_t  x      = data[0];
+    uint8_t  y      = data[1];
+    uint32_t length = (uint32_t) (size - 2);
+
+    //panel and frame start from the pattern with nothing dirty
+    memcpy(LCD_get_frame(), pattern, LCD_BUFFER_SIZE);
+    LCD_mark_dirty(0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    LCD_update();
+    CHECK(harness_ram_is(chip, pattern));
+
+    HAL_StatusTypeDef status = decompress_padded(data + 2, length, 0xff, x, y);
+    memcpy(decoded, LCD_get_frame(), LCD_BUFFER_SIZE);
+    check_outside_dirty();
+    CHECK_EQUAL(decompress_padded(data + 2, length, 0x00, x, y), status);
+    CHECK(memcmp(decoded, LCD_get_frame(), LCD_BUFFER_SIZE) == 0);
+
+    //exact copy, so a sanitizer catches a read past the end
+    uint8_t *exact = malloc(length ? length : 1);
+    memcpy(exact, data + 2, length);
+    CHECK_EQUAL(LCD_stream_compressed_image(exact, length, x, y), status);
+    free(exact);
+    CHECK(harness_ram_is(chip, decoded));
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+
+#ifdef HARNESS_LIBFUZZER
+    if (harness_failed())
+        abort();
+#endif
+    return 0;
+}
+
+#ifndef HARNESS_LIBFUZZER
+/**
+ * @brief an image of random size and density, up to larger than LCD - full screens of one kind need split counts
+ * @param n corpus index
+ * @param image receives width * height chunks
+ * @param width receives width in chunks
+ * @param height receives height in banks
+ */
+static void corpus_image(uint16_t n, uint8_t *image, uint16_t *width, uint16_t *height) {
+    *width  = (uint16_t) (1 + harness_random() % 100);
+    *height = (uint16_t) (1 + harness_random() % 8);
+    if (n % 8 == 0) {
+        *width  = LCD_WIDTH_IN_CHUNK;
+        *height = LCD_HEIGHT_IN_CHUNK;
+    }
+    uint32_t density = harness_random() % 5;
+    for (uint32_t i = 0; i < (uint32_t) *width * *height; i++)
+        image[i] = harness_random() % 4 < density ? (uint8_t) harness_random() : 0;
+    if (n % 16 == 0)
+        memset(image, n % 32 ? 0xa5 : 0, (size_t) *width * *height);
+}
+
+/**
+ * @brief changes an input the way a bad transfer or a broken encoder would
+ * @param input input, x and y then image
+ * @param size size of input
+ * @return new size
+ */
+static uint32_t mutate(uint8_t *input, uint32_t size) {
+    uint32_t at = 2 + harness_random() % (size - 2);
+    switch (harness_random() % 6) {
+        case 0:
+            //cut short
+            return at;
+        case 1:
+            input[at] ^= (uint8_t) (1 << harness_random() % 8);
+            break;
+        case 2:
+            //a count gets its second byte
+            input[at] |= 0x80;
+            break;
+        case 3:
+            input[at] = (uint8_t) harness_random();
+            break;
+        case 4:
+            //trailing garbage
+            while (size < FUZZ_MAX_INPUT && harness_random() % 8)
+                input[size++] = (uint8_t) harness_random();
+            break;
+        default:
+            input[0] = (uint8_t) harness_random();
+            input[1] = (uint8_t) harness_random();
+            break;
+    }
+    return size;
+}
+
+int main(void) {
+    static uint8_t image[100 * 8];
+    static uint8_t input[FUZZ_MAX_INPUT + 2];
+    static uint8_t mutated[FUZZ_MAX_INPUT + 2];
+    harness_seed(0xf022u);
+
+    for (uint16_t n = 0; n < 160; n++) {
+        uint16_t width;
+        uint16_t height;
+        corpus_image(n, image, &width, &height);
+        input[0]      = (uint8_t) (harness_random() % LCD_WIDTH_IN_CHUNK);
+        input[1]      = (uint8_t) (harness_random() % LCD_HEIGHT_IN_CHUNK);
+        uint32_t size = 2 + harness_encode(image, width, height, n % 5 == 1, input + 2);
+        LLVMFuzzerTestOneInput(input, size);
+
+        //an intact image fitting the LCD is shown as it is
+        if (width <= LCD_WIDTH_IN_CHUNK && height <= LCD_HEIGHT_IN_CHUNK) {
+            uint16_t x = input[0] + width > LCD_WIDTH_IN_CHUNK ? LCD_WIDTH_IN_CHUNK - width : input[0];
+            uint16_t y = input[1] + height > LCD_HEIGHT_IN_CHUNK ? LCD_HEIGHT_IN_CHUNK - height : input[1];
+            for (uint16_t row = 0; row < height; row++)
+                CHECK(memcmp(LCD_get_frame() + x + (y + row) * LCD_WIDTH_IN_CHUNK, image + row * width, width) == 0);
+        }
+
+        for (uint8_t k = 0; k < FUZZ_MUTATIONS; k++) {
+            memcpy(mutated, input, size);
+            uint32_t mutated_size = size;
+            for (uint32_t changes = 1 + harness_random() % 3; changes && mutated_size > 2; changes--)
+                mutated_size = mutate(mutated, mutated_size);
+            LLVMFuzzerTestOneInput(mutated, mutated_size);
+        }
+    }
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
+#endif
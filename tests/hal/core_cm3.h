@@ -0,0 +1,56 @@
+/**
+ *  @file core_cm3.h
+ *  @brief host stand-in of CMSIS core intrinsics used by the driver
+ */
+
+#ifndef CORE_CM3_STUB
+#define CORE_CM3_STUB
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+//interrupt mask of host, 1 while driver holds interrupts off
+extern volatile uint32_t hal_stub_primask;
+
+static inline uint32_t __get_PRIMASK(void) {
+    return hal_stub_primask;
+}
+
+static inline void __set_PRIMASK(uint32_t primask) {
+    hal_stub_primask = primask & 1;
+}
+
+static inline void __disable_irq(void) {
+    hal_stub_primask = 1;
+}
+
+static inline void __enable_irq(void) {
+    hal_stub_primask = 0;
+}
+
+static inline void __DMB(void) {
+    __sync_synchronize();
+}
+
+//single-threaded model of exclusive access - threaded tests define LCD_QUEUE_CLAIM instead
+static inline uint32_t __LDREXW(volatile uint32_t *address) {
+    return *address;
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *address) {
+    *address = value;
+    return 0;
+}
+
+static inline void __CLREX(void) {
+}
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
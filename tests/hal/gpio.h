@@ -0,0 +1,11 @@
+/**
+ *  @file gpio.h
+ *  @brief GPIO setup of host test board - nothing the driver uses
+ */
+
+#ifndef GPIO_STUB
+#define GPIO_STUB
+
+#include "stm32f1xx_hal.h"
+
+#endif
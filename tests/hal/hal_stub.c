@@ -0,0 +1,245 @@
+/**
+ *  @file hal_stub.c
+ *  @brief host stand-in of the STM32 board the driver runs on
+ *
+ *  Pins are bits of GPIO_TypeDef ODR. A transaction goes to every chip of its bus which is out of reset and
+ *  selected, fed with the DC level at that moment. A DMA transfer latches DC and CE levels at start, so a driver
+ *  toggling pins of a bus under a running transfer is caught as a glitch.
+ */
+
+#include <string.h>
+#include "userconf.h"
+#include "hal_stub.h"
+
+HAL_Stub          hal_stub;
+GPIO_TypeDef      hal_stub_gpioa;
+GPIO_TypeDef      hal_stub_gpiob;
+GPIO_TypeDef      hal_stub_gpioc;
+CoreDebug_Type    hal_stub_core_debug;
+volatile uint32_t hal_stub_primask;
+SPI_HandleTypeDef hspi1 = {1};
+SPI_HandleTypeDef hspi2 = {2};
+TIM_HandleTypeDef htim2 = {2, 0};
+
+static DWT_Type hal_stub_dwt_registers;
+
+/*private in-lib functions*/
+
+/**
+ * @brief reads a pin
+ * @param port port, 0 reads as low
+ * @param pin pin mask
+ * @return level of pin
+ */
+uint8_t _pin_level(GPIO_TypeDef *port, uint16_t pin);
+
+/**
+ * @brief DC and CE levels of all chips, DC in bits 0-7 and CE in bits 8-15
+ * @return levels
+ */
+uint32_t _chip_levels(void);
+
+/**
+ * @brief hands one transaction to selected chips of a bus
+ * @param hspi SPI handle
+ * @param data bytes
+ * @param length count of bytes
+ */
+void _deliver(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t length);
+
+/**
+ * @brief finds DMA slot of a bus
+ * @param hspi SPI handle
+ * @return slot
+ */
+HAL_StubTransfer *_transfer_of(SPI_HandleTypeDef *hspi);
+
+/**
+ * @brief ends a DMA transfer and calls HAL_SPI_TxCpltCallback
+ * @param transfer transfer in flight
+ */
+void _end_transfer(HAL_StubTransfer *transfer);
+
+uint8_t _pin_level(GPIO_TypeDef *port, uint16_t pin) {
+    return port && (port->ODR & pin) ? 1 : 0;
+}
+
+uint32_t _chip_levels(void) {
+    uint32_t levels = 0;
+    for (uint8_t i = 0; i < hal_stub.chip_count; i++) {
+        HAL_StubChip *chip = &hal_stub.chips[i];
+        levels |= (uint32_t) _pin_level(chip->dc_port, chip->dc_pin) << i;
+        levels |= (uint32_t) _pin_level(chip->ce_port, chip->ce_pin) << (i + 8);
+    }
+    return levels;
+}
+
+void _deliver(SPI_HandleTypeDef *hspi, const uint8_t *data, uint16_t length) {
+    uint8_t selected = 0;
+    uint8_t is_data  = 0;
+    for (uint8_t i = 0; i < hal_stub.chip_count; i++) {
+        HAL_StubChip *chip = &hal_stub.chips[i];
+        if (chip->hspi != hspi || !_pin_level(chip->reset_port, chip->reset_pin))
+            continue;
+        if (chip->ce_port && _pin_level(chip->ce_port, chip->ce_pin))
+            continue;
+        is_data = _pin_level(chip->dc_port, chip->dc_pin);
+        LCD_emu_feed(&chip->emulator, is_data, data, length);
+        selected++;
+    }
+    if (selected > 1)
+        hal_stub.ce_conflicts++;
+    if (hal_stub.on_transmit)
+        hal_stub.on_transmit(hspi, is_data, data, length);
+}
+
+HAL_StubTransfer *_transfer_of(SPI_HandleTypeDef *hspi) {
+    return &hal_stub.dma[hspi == &hspi2 ? 1 : 0];
+}
+
+void _end_transfer(HAL_StubTransfer *transfer) {
+    SPI_HandleTypeDef *hspi = transfer->hspi;
+    if (_chip_levels() != transfer->levels)
+        hal_stub.pin_glitches++;
+    transfer->hspi = 0;
+    _deliver(hspi, transfer->data, transfer->length);
+    HAL_SPI_TxCpltCallback(hspi);
+}
+
+void hal_stub_reset(void) {
+    memset(&hal_stub, 0, sizeof(hal_stub));
+    hal_stub.cycles_per_access    = 64;
+    hal_stub.host_cycles_per_read = 1;
+    hal_stub_gpioa.ODR            = 0;
+    hal_stub_gpiob.ODR            = 0;
+    hal_stub_gpioc.ODR            = 0;
+    hal_stub_primask              = 0;
+    htim2.running                 = 0;
+}
+
+HAL_StubChip *hal_stub_add_chip(LCD_HandleTypeDef *hlcd) {
+    if (hal_stub.chip_count == HAL_STUB_MAX_CHIPS)
+        return 0;
+    HAL_StubChip *chip = &hal_stub.chips[hal_stub.chip_count++];
+    chip->hspi       = hlcd->hspi;
+    chip->dc_port    = hlcd->dc_port;
+    chip->dc_pin     = hlcd->dc_pin;
+    chip->reset_port = hlcd->reset_port;
+    chip->reset_pin  = hlcd->reset_pin;
+    chip->ce_port    = hlcd->ce_port;
+    chip->ce_pin     = hlcd->ce_pin;
+    LCD_emu_init(&chip->emulator);
+    return chip;
+}
+
+uint8_t hal_stub_dma_pending(SPI_HandleTypeDef *hspi) {
+    return _transfer_of(hspi)->hspi != 0;
+}
+
+uint16_t hal_stub_dma_finish(SPI_HandleTypeDef *hspi) {
+    HAL_StubTransfer *transfer = _transfer_of(hspi);
+    uint16_t         ended     = 0;
+    //callback of each end may start the next segment of a chain
+    while (transfer->hspi) {
+        _end_transfer(transfer);
+        ended++;
+    }
+    return ended;
+}
+
+DWT_Type *hal_stub_dwt(void) {
+    hal_stub_dwt_registers.CYCCNT += hal_stub.cycles_per_access;
+    return &hal_stub_dwt_registers;
+}
+
+uint32_t host_cycles(void) {
+    static uint32_t cycles;
+    hal_stub.host_cycles_reads++;
+    cycles += hal_stub.host_cycles_per_read;
+    return cycles;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state) {
+    if (!port)
+        return;
+    uint8_t was = _pin_level(port, pin);
+    if (state)
+        port->ODR |= pin;
+    else
+        port->ODR &= ~(uint32_t) pin;
+
+    //falling edge of RESET clears a chip
+    if (was && !state)
+        for (uint8_t i = 0; i < hal_stub.chip_count; i++)
+            if (hal_stub.chips[i].reset_port == port && hal_stub.chips[i].reset_pin == pin)
+                LCD_emu_init(&hal_stub.chips[i].emulator);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout) {
+    (void) timeout;
+    if (hal_stub_dma_pending(hspi)) {
+        hal_stub.busy_returns++;
+        return HAL_BUSY;
+    }
+    if (hal_stub.fail_count) {
+        hal_stub.fail_count--;
+        return hal_stub.fail_status;
+    }
+    hal_stub.transmits++;
+    _deliver(hspi, data, size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size) {
+    HAL_StubTransfer *transfer = _transfer_of(hspi);
+    if (transfer->hspi) {
+        hal_stub.busy_returns++;
+        return HAL_BUSY;
+    }
+    if (hal_stub.fail_count) {
+        hal_stub.fail_count--;
+        return hal_stub.fail_status;
+    }
+    hal_stub.dma_transfers++;
+    transfer->hspi       = hspi;
+    transfer->data       = data;
+    transfer->length     = size;
+    transfer->polls_left = hal_stub.dma_polls;
+    transfer->levels     = _chip_levels();
+    if (hal_stub.dma_polls == 0)
+        _end_transfer(transfer);
+    return HAL_OK;
+}
+
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi) {
+    HAL_StubTransfer *transfer = _transfer_of(hspi);
+    if (transfer->hspi && --transfer->polls_left == 0)
+        _end_transfer(transfer);
+    return transfer->hspi ? HAL_SPI_STATE_BUSY_TX : HAL_SPI_STATE_READY;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim) {
+    htim->running = 1;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim) {
+    htim->running = 0;
+    return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetSysClockFreq(void) {
+    return 72000000;
+}
+
+uint32_t HAL_GetTick(void) {
+    return hal_stub.tick;
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+#ifdef LCD_USE_DMA
+    LCD_SPI_TxCpltCallback(hspi);
+#else
+    (void) hspi;
+#endif
+}
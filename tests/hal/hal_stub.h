@@ -0,0 +1,113 @@
+/**
+ *  @file hal_stub.h
+ *  @brief host stand-in of the STM32 board the driver runs on - SPI buses wired to emulated PCD8544 chips
+ *
+ *  Every SPI transaction, blocking or DMA, reaches the LCD_Emulator of each chip on its bus whose CE is low, with
+ *  the level of the chip's DC pin, so tests see exactly what a panel would show. Driving a RESET pin low resets its
+ *  chip. DMA transfers end at once, or after a number of HAL_SPI_GetState polls to keep them in flight for a while,
+ *  and end by HAL_SPI_TxCpltCallback like on the MCU.
+ */
+
+#ifndef HAL_STUB
+#define HAL_STUB
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "stm32f1xx_hal.h"
+#include "lcd_5110_emu.h"
+
+//chips wired on host board
+#define HAL_STUB_MAX_CHIPS                      4
+
+//SPI buses of host board, hspi1 and hspi2
+#define HAL_STUB_MAX_BUSES                      2
+
+/**
+ * @brief an emulated PCD8544 and the pins it is wired to
+ */
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    GPIO_TypeDef      *dc_port;
+    uint16_t          dc_pin;
+    GPIO_TypeDef      *reset_port;
+    uint16_t          reset_pin;
+    GPIO_TypeDef      *ce_port;//0 if CE is tied low
+    uint16_t          ce_pin;
+    LCD_Emulator      emulator;
+} HAL_StubChip;
+
+/**
+ * @brief a DMA transfer in flight
+ */
+typedef struct {
+    SPI_HandleTypeDef *hspi;//0 if bus is idle
+    uint8_t           *data;
+    uint16_t          length;
+    uint16_t          polls_left;//HAL_SPI_GetState calls before it ends
+    uint32_t          levels;//DC and CE levels of chips at start, one bit each
+} HAL_StubTransfer;
+
+/**
+ * @brief state of host board - set the knobs after hal_stub_reset, read the counters after a test step
+ */
+typedef struct {
+    HAL_StubChip     chips[HAL_STUB_MAX_CHIPS];
+    uint8_t          chip_count;
+    HAL_StubTransfer dma[HAL_STUB_MAX_BUSES];
+
+    //knobs
+    uint32_t          tick;//returned by HAL_GetTick
+    uint32_t          cycles_per_access;//DWT->CYCCNT step per access, 0 freezes time
+    uint32_t          host_cycles_per_read;//host_cycles step per call, 0 freezes it
+    uint16_t          dma_polls;//HAL_SPI_GetState calls a DMA transfer stays in flight, 0 ends it at once
+    uint16_t          fail_count;//transmits, blocking or DMA, to fail before sending
+    HAL_StatusTypeDef fail_status;//status they return
+    //called after every transaction reached the chips, e.g. to play an interrupt in the middle of an update
+    void (*on_transmit)(SPI_HandleTypeDef *hspi, uint8_t is_data, const uint8_t *data, uint16_t length);
+
+    //counters
+    uint32_t transmits;//blocking transactions sent
+    uint32_t host_cycles_reads;//calls of host_cycles
+    uint32_t dma_transfers;//DMA transactions started
+    uint32_t busy_returns;//calls refused with HAL_BUSY because a DMA transfer ran on the bus
+    uint32_t ce_conflicts;//transactions seen by more than one chip
+    uint32_t pin_glitches;//DC or CE changes on a bus while its DMA transfer ran
+} HAL_Stub;
+
+//!host board
+extern HAL_Stub hal_stub;
+
+/**
+ * @brief removes all chips, clears pins, counters and transfers, sets knobs to defaults
+ */
+void hal_stub_reset(void);
+
+/**
+ * @brief wires a new chip to the bus and pins of an LCD handle
+ * @param hlcd LCD handle, its pins must be set
+ * @return chip, in reset state
+ */
+HAL_StubChip *hal_stub_add_chip(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief checks whether a DMA transfer is in flight on a bus
+ * @param hspi SPI handle
+ * @return 1 if a transfer runs
+ */
+uint8_t hal_stub_dma_pending(SPI_HandleTypeDef *hspi);
+
+/**
+ * @brief ends DMA transfers of a bus until it is idle, each end calls HAL_SPI_TxCpltCallback
+ * @param hspi SPI handle
+ * @return count of transfers ended
+ */
+uint16_t hal_stub_dma_finish(SPI_HandleTypeDef *hspi);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
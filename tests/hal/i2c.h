@@ -0,0 +1,11 @@
+/**
+ *  @file i2c.h
+ *  @brief I2C setup of host test board - nothing the driver uses
+ */
+
+#ifndef I2C_STUB
+#define I2C_STUB
+
+#include "stm32f1xx_hal.h"
+
+#endif
@@ -0,0 +1,29 @@
+/**
+ *  @file main.h
+ *  @brief pins of host test board, as CubeMX would name them
+ */
+
+#ifndef MAIN_STUB
+#define MAIN_STUB
+
+#include "stm32f1xx_hal.h"
+
+#define LCD_DC_GPIO_Port                        GPIOA
+#define LCD_DC_Pin                              GPIO_PIN_1
+#define LCD_RESET_GPIO_Port                     GPIOA
+#define LCD_RESET_Pin                           GPIO_PIN_2
+#define LCD_CE_GPIO_Port                        GPIOA
+#define LCD_CE_Pin                              GPIO_PIN_3
+
+//second panel, shares SPI1 with the first one
+#define LCD2_DC_GPIO_Port                       GPIOB
+#define LCD2_DC_Pin                             GPIO_PIN_1
+#define LCD2_RESET_GPIO_Port                    GPIOB
+#define LCD2_RESET_Pin                          GPIO_PIN_2
+#define LCD2_CE_GPIO_Port                       GPIOB
+#define LCD2_CE_Pin                             GPIO_PIN_3
+
+//cycle source of profiling builds (LCD_PROFILE_CYCLES()=host_cycles()), steps by hal_stub.host_cycles_per_read
+uint32_t host_cycles(void);
+
+#endif
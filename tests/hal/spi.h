@@ -0,0 +1,14 @@
+/**
+ *  @file spi.h
+ *  @brief SPI handles of host test board
+ */
+
+#ifndef SPI_STUB
+#define SPI_STUB
+
+#include "stm32f1xx_hal.h"
+
+extern SPI_HandleTypeDef hspi1;
+extern SPI_HandleTypeDef hspi2;
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ *  @file stm32f103xb.h
+ *  @brief host stand-in of STM32F103xB device header - GPIO ports and DWT cycle counter, see hal_stub.h
+ */
+
+#ifndef STM32F103XB_STUB
+#define STM32F103XB_STUB
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t ODR;//output levels, one bit per pin
+} GPIO_TypeDef;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk                  (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk              (1UL << 24)
+
+extern GPIO_TypeDef   hal_stub_gpioa;
+extern GPIO_TypeDef   hal_stub_gpiob;
+extern GPIO_TypeDef   hal_stub_gpioc;
+extern CoreDebug_Type hal_stub_core_debug;
+
+/**
+ * @brief DWT of host - every access moves CYCCNT on by hal_stub.cycles_per_access, so timed waits progress
+ * @return DWT registers
+ */
+DWT_Type *hal_stub_dwt(void);
+
+#define GPIOA                                   (&hal_stub_gpioa)
+#define GPIOB                                   (&hal_stub_gpiob)
+#define GPIOC                                   (&hal_stub_gpioc)
+#define DWT                                     (hal_stub_dwt())
+#define CoreDebug                               (&hal_stub_core_debug)
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ *  @file stm32f1xx_hal.h
+ *  @brief host stand-in of STM32F1 HAL - the calls the driver makes, backed by hal_stub.c
+ */
+
+#ifndef STM32F1XX_HAL_STUB
+#define STM32F1XX_HAL_STUB
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stm32f103xb.h"
+
+typedef enum {
+    HAL_OK = 0x00,
+    HAL_ERROR = 0x01,
+    HAL_BUSY = 0x02,
+    HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+typedef enum {
+    HAL_SPI_STATE_RESET = 0x00,
+    HAL_SPI_STATE_READY = 0x01,
+    HAL_SPI_STATE_BUSY = 0x02,
+    HAL_SPI_STATE_BUSY_TX = 0x03
+} HAL_SPI_StateTypeDef;
+
+typedef enum {
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+    uint32_t id;
+} SPI_HandleTypeDef;
+
+typedef struct {
+    uint32_t id;
+    uint8_t  running;//update interrupt enabled
+} TIM_HandleTypeDef;
+
+#define GPIO_PIN_0                              ((uint16_t) 0x0001)
+#define GPIO_PIN_1                              ((uint16_t) 0x0002)
+#define GPIO_PIN_2                              ((uint16_t) 0x0004)
+#define GPIO_PIN_3                              ((uint16_t) 0x0008)
+#define GPIO_PIN_4                              ((uint16_t) 0x0010)
+#define GPIO_PIN_5                              ((uint16_t) 0x0020)
+#define GPIO_PIN_6                              ((uint16_t) 0x0040)
+#define GPIO_PIN_7                              ((uint16_t) 0x0080)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, uint8_t *data, uint16_t size);
+HAL_SPI_StateTypeDef HAL_SPI_GetState(SPI_HandleTypeDef *hspi);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+uint32_t HAL_RCC_GetSysClockFreq(void);
+uint32_t HAL_GetTick(void);
+
+//!called when a DMA transfer ends, like the weak callback of the real HAL
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,13 @@
+/**
+ *  @file tim.h
+ *  @brief timer handles of host test board
+ */
+
+#ifndef TIM_STUB
+#define TIM_STUB
+
+#include "stm32f1xx_hal.h"
+
+extern TIM_HandleTypeDef htim2;
+
+#endif
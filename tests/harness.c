@@ -0,0 +1,219 @@
+/**
+ *  @file harness.c
+ *  @brief checks, golden frames and traffic reports shared by host tests
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "harness.h"
+
+#ifndef HARNESS_GOLDEN_DIR
+#define HARNESS_GOLDEN_DIR                      "golden"
+#endif
+#ifndef HARNESS_IMAGES_DIR
+#define HARNESS_IMAGES_DIR                      "images"
+#endif
+
+//P4 header and 11 bytes per row of 48 rows
+#define HARNESS_PBM_SIZE                        (9 + 11 * 48)
+
+static int      harness_checks;
+static int      harness_failures;
+static uint32_t harness_state = 2463534242u;
+
+static uint8_t  harness_pbm[HARNESS_PBM_SIZE];
+static uint16_t harness_pbm_length;
+
+/*private in-lib functions*/
+
+/**
+ * @brief collects pieces of a PBM image written by LCD_emu_write_pbm
+ * @param data piece
+ * @param length size of piece
+ */
+void _collect_pbm(const uint8_t *data, uint16_t length);
+
+/**
+ * @brief writes a count of BICTES
+ * @param out compressed image
+ * @param size bytes written so far
+ * @param count 0-382
+ * @return bytes written so far
+ */
+uint32_t _put_count(uint8_t *out, uint32_t size, uint16_t count);
+
+void _collect_pbm(const uint8_t *data, uint16_t length) {
+    if (harness_pbm_length + length > HARNESS_PBM_SIZE)
+        length = HARNESS_PBM_SIZE - harness_pbm_length;
+    memcpy(harness_pbm + harness_pbm_length, data, length);
+    harness_pbm_length += length;
+}
+
+uint32_t _put_count(uint8_t *out, uint32_t size, uint16_t count) {
+    //counts above 127 take a second byte, (first & 127) + second
+    if (count <= 127) {
+        out[size++] = (uint8_t) count;
+    } else {
+        out[size++] = 0x80 | 127;
+        out[size++] = (uint8_t) (count - 127);
+    }
+    return size;
+}
+
+int harness_check(int passed, const char *text, const char *file, int line) {
+    harness_checks++;
+    if (!passed) {
+        harness_failures++;
+        printf("%s:%d: check failed: %s\n", file, line, text);
+    }
+    return passed;
+}
+
+int harness_check_equal(long long actual, long long expected, const char *text, const char *file, int line) {
+    harness_checks++;
+    if (actual != expected) {
+        harness_failures++;
+        printf("%s:%d: check failed: %s is %lld, expected %lld\n", file, line, text, actual, expected);
+        return 0;
+    }
+    return 1;
+}
+
+int harness_done(const char *test) {
+    if (harness_failures) {
+        printf("%s: %d of %d checks failed\n", test, harness_failures, harness_checks);
+        return 1;
+    }
+    printf("%s: %d checks passed\n", test, harness_checks);
+    return 0;
+}
+
+int harness_failed(void) {
+    return harness_failures;
+}
+
+HAL_StubChip *harness_start(LCD_HandleTypeDef *hlcd) {
+    hal_stub_reset();
+    HAL_StubChip *chip = hal_stub_add_chip(hlcd);
+    initializeDWTtimer();
+    LCDx_Init(hlcd, 60);
+    return chip;
+}
+
+uint8_t harness_ram_is(const HAL_StubChip *chip, const uint8_t *frame) {
+    return memcmp(chip->emulator.ram, frame, LCD_BUFFER_SIZE) == 0;
+}
+
+int harness_golden(const HAL_StubChip *chip, const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.pbm", HARNESS_GOLDEN_DIR, name);
+    harness_pbm_length = 0;
+    LCD_emu_write_pbm(&chip->emulator, _collect_pbm);
+
+    const char *update = getenv("UPDATE_GOLDEN");
+    if (update && *update == '1') {
+        FILE *file = fopen(path, "wb");
+        if (!file || fwrite(harness_pbm, 1, harness_pbm_length, file) != harness_pbm_length) {
+            printf("%s: cannot write\n", path);
+            if (file)
+                fclose(file);
+            return harness_check(0, path, __FILE__, __LINE__);
+        }
+        fclose(file);
+        return 1;
+    }
+
+    uint8_t golden[HARNESS_PBM_SIZE + 1];
+    FILE    *file  = fopen(path, "rb");
+    size_t  length = file ? fread(golden, 1, sizeof(golden), file) : 0;
+    if (file)
+        fclose(file);
+    if (length != harness_pbm_length || memcmp(golden, harness_pbm, length) != 0) {
+        printf("%s: glass differs from golden frame, run with UPDATE_GOLDEN=1 if the change is intended\n", path);
+        return harness_check(0, name, __FILE__, __LINE__);
+    }
+    return harness_check(1, name, __FILE__, __LINE__);
+}
+
+int harness_image(const char *name, uint8_t *frame) {
+    static const char header[] = "P4\n84 48\n";
+    char              path[256];
+    uint8_t           image[HARNESS_PBM_SIZE + 1];
+    snprintf(path, sizeof(path), "%s/%s.pbm", HARNESS_IMAGES_DIR, name);
+    FILE   *file  = fopen(path, "rb");
+    size_t length = file ? fread(image, 1, sizeof(image), file) : 0;
+    if (file)
+        fclose(file);
+    if (length != HARNESS_PBM_SIZE || memcmp(image, header, sizeof(header) - 1) != 0) {
+        printf("%s: not an 84x48 P4 image\n", path);
+        return harness_check(0, name, __FILE__, __LINE__);
+    }
+
+    //rows of 11 bytes, MSB left, into banks of LSB-on-top columns
+    const uint8_t *rows = image + sizeof(header) - 1;
+    memset(frame, 0, LCD_BUFFER_SIZE);
+    for (uint16_t y = 0; y < 48; y++)
+        for (uint16_t x = 0; x < LCD_WIDTH_IN_CHUNK; x++)
+            if (rows[y * 11 + x / 8] & (0x80 >> (x % 8)))
+                frame[y / 8 * LCD_WIDTH_IN_CHUNK + x] |= (uint8_t) (1 << (y % 8));
+    return 1;
+}
+
+HarnessTraffic harness_traffic_mark(const HAL_StubChip *chip) {
+    HarnessTraffic mark = {chip->emulator.transactions, chip->emulator.command_bytes + chip->emulator.data_bytes};
+    return mark;
+}
+
+HarnessTraffic harness_traffic_since(const HAL_StubChip *chip, HarnessTraffic mark) {
+    HarnessTraffic now = harness_traffic_mark(chip);
+    now.transactions -= mark.transactions;
+    now.bytes -= mark.bytes;
+    return now;
+}
+
+void harness_report(const char *test, const char *scenario, HarnessTraffic traffic) {
+    printf("traffic %s/%s: %lu transactions, %lu bytes\n", test, scenario, (unsigned long) traffic.transactions,
+           (unsigned long) traffic.bytes);
+}
+
+uint32_t harness_encode(const uint8_t *image, uint16_t width, uint16_t height, uint8_t inverted, uint8_t *out) {
+    uint8_t  blank = inverted ? 0xff : 0x00;
+    uint32_t total = (uint32_t) width * height;
+    uint32_t i     = 0;
+    uint32_t size  = 0;
+
+    out[size++] = inverted ? 1 : 0;
+    size = _put_count(out, size, width);
+    size = _put_count(out, size, height);
+    //offset, then fragments of non-blank count, chunks and blank count - longer runs are split
+    uint32_t start = i;
+    while (i < total && image[i] == blank && i - start < 382)
+        i++;
+    size = _put_count(out, size, (uint16_t) (i - start));
+    while (i < total) {
+        start = i;
+        while (i < total && image[i] != blank && i - start < 382)
+            i++;
+        size = _put_count(out, size, (uint16_t) (i - start));
+        memcpy(out + size, image + start, i - start);
+        size += i - start;
+        start = i;
+        while (i < total && image[i] == blank && i - start < 382)
+            i++;
+        size = _put_count(out, size, (uint16_t) (i - start));
+    }
+    return size;
+}
+
+uint32_t harness_random(void) {
+    //xorshift32
+    harness_state ^= harness_state << 13;
+    harness_state ^= harness_state >> 17;
+    harness_state ^= harness_state << 5;
+    return harness_state;
+}
+
+void harness_seed(uint32_t seed) {
+    harness_state = seed ? seed : 2463534242u;
+}
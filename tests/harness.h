@@ -0,0 +1,143 @@
+/**
+ *  @file harness.h
+ *  @brief checks, golden frames and traffic reports shared by host tests
+ */
+
+#ifndef HARNESS
+#define HARNESS
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "userconf.h"
+#include "hal_stub.h"
+
+//checks go on after a failure, harness_done reports them all
+#define CHECK(condition)                        harness_check((condition) != 0, #condition, __FILE__, __LINE__)
+#define CHECK_EQUAL(actual, expected)           harness_check_equal((long long) (actual), (long long) (expected), \
+                                                                    #actual, __FILE__, __LINE__)
+
+//bus traffic of a chip since a mark
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+} HarnessTraffic;
+
+/**
+ * @brief records a check
+ * @param passed nonzero if check passed
+ * @param text checked expression
+ * @param file source file
+ * @param line source line
+ * @return passed
+ */
+int harness_check(int passed, const char *text, const char *file, int line);
+
+/**
+ * @brief records a check of a value
+ * @param actual value found
+ * @param expected value wanted
+ * @param text checked expression
+ * @param file source file
+ * @param line source line
+ * @return 1 if values are equal
+ */
+int harness_check_equal(long long actual, long long expected, const char *text, const char *file, int line);
+
+/**
+ * @brief prints result of a test
+ * @param test name of test
+ * @return exit code of test, 0 if all checks passed
+ */
+int harness_done(const char *test);
+
+/**
+ * @brief count of failed checks, for tests whose output must stay machine readable
+ * @return failed checks so far
+ */
+int harness_failed(void);
+
+/**
+ * @brief resets host board, wires a chip to an LCD handle and initializes it
+ * @param hlcd LCD handle, pins set
+ * @return chip of LCD, showing a blank frame
+ */
+HAL_StubChip *harness_start(LCD_HandleTypeDef *hlcd);
+
+/**
+ * @brief checks whether RAM of a chip holds a frame
+ * @param chip chip
+ * @param frame LCD_BUFFER_SIZE bytes
+ * @return 1 if every byte matches
+ */
+uint8_t harness_ram_is(const HAL_StubChip *chip, const uint8_t *frame);
+
+/**
+ * @brief compares glass of a chip, as a PBM image, with tests/golden/<name>.pbm
+ * @param chip chip
+ * @param name name of golden frame
+ * @return 1 if they match - with UPDATE_GOLDEN=1 in environment the golden frame is written instead
+ */
+int harness_golden(const HAL_StubChip *chip, const char *name);
+
+/**
+ * @brief reads tests/images/<name>.pbm, an 84x48 P4 image as the emulator writes them, into a frame
+ * @param name name of image
+ * @param frame LCD_BUFFER_SIZE bytes, laid out like LCD buffer
+ * @return 1 if image was read
+ */
+int harness_image(const char *name, uint8_t *frame);
+
+/**
+ * @brief marks traffic of a chip
+ * @param chip chip
+ * @return mark to pass to harness_traffic_since
+ */
+HarnessTraffic harness_traffic_mark(const HAL_StubChip *chip);
+
+/**
+ * @brief traffic of a chip since a mark
+ * @param chip chip
+ * @param mark from harness_traffic_mark
+ * @return transactions and bytes since mark
+ */
+HarnessTraffic harness_traffic_since(const HAL_StubChip *chip, HarnessTraffic mark);
+
+/**
+ * @brief prints traffic of a scenario, e.g. "traffic golden/text: 3 transactions, 92 bytes"
+ * @param test name of test
+ * @param scenario name of scenario
+ * @param traffic traffic from harness_traffic_since
+ */
+void harness_report(const char *test, const char *scenario, HarnessTraffic traffic);
+
+/**
+ * @brief compresses an image by BICTES
+ * @param image width * height chunks, row by row
+ * @param width width in chunks
+ * @param height height in banks
+ * @param inverted 1 if blank chunks are 0xff
+ * @param out compressed image, room for 4 + width * height * 3 / 2 bytes
+ * @return size of compressed image
+ */
+uint32_t harness_encode(const uint8_t *image, uint16_t width, uint16_t height, uint8_t inverted, uint8_t *out);
+
+/**
+ * @brief deterministic pseudo random numbers, same sequence on every host
+ * @return next number
+ */
+uint32_t harness_random(void);
+
+/**
+ * @brief restarts harness_random
+ * @param seed nonzero seed
+ */
+void harness_seed(uint32_t seed);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ *  @file test_anim.c
+ *  @brief delta-frame animations - tests/images/bounce_*.pbm through tools/anim2lcd.py, played by LCD_animation_next
+ *
+ *  The Makefile encodes the frames of a 9x9 ball bouncing over a static background, looping, with anim2lcd.py and
+ *  this test includes the result. Played frame by frame, LCD RAM after each update must equal the source image,
+ *  the closing frame must lead back to frame 0, and a frame may send no more than the span from its first to its
+ *  last changed column in each bank. Truncated and corrupt records must return HAL_ERROR and end the animation.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_anim.h"
+#include "bounce_anim.c"
+
+#define TEST_NAME                               "anim"
+
+#ifndef LCD_USE_PAGED_MODE
+
+#define BOUNCE_FRAMES                           8
+
+static HAL_StubChip  *chip;
+static LCD_Animation animation;
+static uint8_t       frames[BOUNCE_FRAMES][LCD_BUFFER_SIZE];
+
+static void show(void) {
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+}
+
+/**
+ * @brief most bytes a frame change may send - address and span from first to last changed column of each bank,
+ *        and a mode byte should it go out vertically
+ */
+static uint32_t changed_bytes(const uint8_t *from, const uint8_t *to) {
+    uint32_t bytes = 1;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        int16_t low  = -1;
+        int16_t high = -1;
+        for (uint8_t x = 0; x < LCD_WIDTH_IN_CHUNK; x++)
+            if (from[bank * LCD_WIDTH_IN_CHUNK + x] != to[bank * LCD_WIDTH_IN_CHUNK + x]) {
+                low  = low < 0 ? x : low;
+                high = (int16_t) (x + 1);
+            }
+        if (low >= 0)
+            bytes += (uint32_t) (2 + high - low);
+    }
+    return bytes;
+}
+
+static void scenario_play(void) {
+    for (uint8_t n = 0; n < BOUNCE_FRAMES; n++) {
+        char name[16];
+        snprintf(name, sizeof(name), "bounce_%u", n);
+        if (!harness_image(name, frames[n]))
+            return;
+    }
+    CHECK_EQUAL(LCD_animation_open(&animation, bounce_anim, sizeof(bounce_anim)), HAL_OK);
+    CHECK_EQUAL(animation.frame_count, BOUNCE_FRAMES);
+    CHECK(animation.loops);
+    LCD_clear();
+    show();
+
+    //twice round the loop - after frame 7 the closing frame shows frame 0 again, then it goes on with frame 1
+    HarnessTraffic moving = {0};
+    for (uint8_t call = 0; call < 2 * BOUNCE_FRAMES + 1; call++) {
+        const uint8_t  *from = call ? frames[(call - 1) % BOUNCE_FRAMES] : 0;
+        const uint8_t  *to   = frames[call % BOUNCE_FRAMES];
+        HarnessTraffic mark  = harness_traffic_mark(chip);
+        CHECK_EQUAL(LCD_animation_next(&animation), HAL_OK);
+        show();
+        HarnessTraffic traffic = harness_traffic_since(chip, mark);
+        if (!CHECK(harness_ram_is(chip, to)))
+            return;
+        CHECK_EQUAL(animation.delay_ms, 80);
+        CHECK(!animation.ended);
+        if (!from)
+            continue;
+        CHECK(traffic.bytes <= changed_bytes(from, to));
+        //frames where only the ball moves, the closing jump back and frame 0 itself left out
+        if (call % BOUNCE_FRAMES) {
+            moving.transactions += traffic.transactions;
+            moving.bytes += traffic.bytes;
+        }
+        if (call == BOUNCE_FRAMES)
+            CHECK_EQUAL(animation.frame, 1);
+    }
+
+    HarnessTraffic frame = {moving.transactions / (2 * (BOUNCE_FRAMES - 1)), moving.bytes / (2 * (BOUNCE_FRAMES - 1))};
+    harness_report(TEST_NAME, "ball_frame", frame);
+    //README: about 39 bytes of SPI per frame, where a full frame takes 506
+    CHECK(frame.bytes >= 37 && frame.bytes <= 41);
+}
+
+/**
+ * @brief plays a broken animation - a frame must fail, end the animation and leave it ended
+ * @param data animation bytes
+ * @param length length of data
+ * @param frames frames to play at most
+ * @return 1 if it failed as it should
+ */
+static int check_broken(const uint8_t *data, uint32_t length, uint16_t frames) {
+    if (LCD_animation_open(&animation, data, length) != HAL_OK)
+        return CHECK(animation.ended) && CHECK_EQUAL(LCD_animation_next(&animation), HAL_OK);
+
+    HAL_StatusTypeDef status = HAL_OK;
+    while (frames-- && status == HAL_OK)
+        status = LCD_animation_next(&animation);
+    if (!CHECK_EQUAL(status, HAL_ERROR) || !CHECK(animation.ended))
+        return 0;
+
+    //an ended animation is not read again
+    static uint8_t kept[LCD_BUFFER_SIZE];
+    memcpy(kept, LCD_get_frame(), LCD_BUFFER_SIZE);
+    show();
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    CHECK_EQUAL(LCD_animation_next(&animation), HAL_OK);
+    show();
+    return CHECK(memcmp(kept, LCD_get_frame(), LCD_BUFFER_SIZE) == 0) &&
+           CHECK_EQUAL(harness_traffic_since(chip, mark).bytes, 0);
+}
+
+static void scenario_broken(void) {
+    //single-frame animations of 80 ms, header {flags, count low, count high}
+    static const uint8_t bank_6[]       = {0, 1, 0, 8, 6, 0, 1, 0xaa, 0xff};
+    static const uint8_t past_edge[]    = {0, 1, 0, 8, 0, 80, 5, 1, 2, 3, 4, 5, 0xff};
+    static const uint8_t short_bytes[]  = {0, 1, 0, 8, 2, 10, 4, 1, 2};
+    static const uint8_t empty_record[] = {0, 1, 0, 8, 2, 10, 0, 0xff};
+    static const uint8_t no_end[]       = {0, 1, 0, 8, 2, 10, 2, 1, 2};
+    static const uint8_t cut_record[]   = {0, 1, 0, 8, 2, 10};
+    static const uint8_t no_delay[]     = {0, 1, 0};
+    static const uint8_t cut_header[]   = {0, 1};
+    CHECK(check_broken(bank_6, sizeof(bank_6), 1));
+    CHECK(check_broken(past_edge, sizeof(past_edge), 1));
+    CHECK(check_broken(short_bytes, sizeof(short_bytes), 1));
+    CHECK(check_broken(empty_record, sizeof(empty_record), 1));
+    CHECK(check_broken(no_end, sizeof(no_end), 1));
+    CHECK(check_broken(cut_record, sizeof(cut_record), 1));
+    CHECK(check_broken(no_delay, sizeof(no_delay), 1));
+    CHECK(check_broken(cut_header, sizeof(cut_header), 1));
+
+    //the generated animation cut anywhere fails before its closing frame is through
+    for (uint32_t length = 0; length < sizeof(bounce_anim); length++)
+        if (!check_broken(bounce_anim, length, BOUNCE_FRAMES + 1))
+            return;
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+
+    scenario_play();
+    scenario_broken();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
+
+#else
+
+int main(void) {
+    return harness_done(TEST_NAME);
+}
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ *  @file test_attach.c
+ *  @brief attached frames - flipping between caller-owned frames and the own buffer leaves LCD RAM on the frame shown
+ *
+ *  Random flips between three frames and the own buffer, with pokes into whichever frame is attached reported by
+ *  LCD_mark_dirty and drawing through the API in between. After every update RAM must equal the attached frame, in
+ *  every build: blocking, shadow, and DMA where runs of an attached frame are sent in place.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+
+#define TEST_NAME                               "attach"
+
+#define ATTACH_FRAMES                           3
+
+static HAL_StubChip *chip;
+static uint8_t      frames[ATTACH_FRAMES][LCD_BUFFER_SIZE];
+
+static void show(void) {
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+}
+
+static void scenario_get_frame(void) {
+    uint8_t *own = LCD_get_frame();
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_string("own");
+    show();
+    static uint8_t kept[LCD_BUFFER_SIZE];
+    memcpy(kept, own, LCD_BUFFER_SIZE);
+
+    LCD_attach_frame(frames[0]);
+    CHECK(LCD_get_frame() == frames[0]);
+    show();
+    CHECK(harness_ram_is(chip, frames[0]));
+
+    //own buffer was left alone and comes back whole
+    LCD_attach_frame(0);
+    CHECK(LCD_get_frame() == own);
+    CHECK(memcmp(own, kept, LCD_BUFFER_SIZE) == 0);
+    show();
+    CHECK(harness_ram_is(chip, own));
+}
+
+static void scenario_flips(void) {
+    harness_seed(0xf11b);
+    for (uint16_t n = 0; n < 600; n++) {
+        uint8_t pick = (uint8_t) (harness_random() % (ATTACH_FRAMES + 1));
+        if (harness_random() % 2)
+            LCD_attach_frame(pick < ATTACH_FRAMES ? frames[pick] : 0);
+
+        //pokes into the frame shown, reported as a rectangle
+        uint8_t *frame = LCD_get_frame();
+        uint8_t x      = (uint8_t) (harness_random() % LCD_WIDTH_IN_CHUNK);
+        uint8_t y      = (uint8_t) (harness_random() % LCD_HEIGHT_IN_CHUNK);
+        uint8_t width  = (uint8_t) (1 + harness_random() % 20);
+        uint8_t height = (uint8_t) (1 + harness_random() % 3);
+        for (uint8_t bank = y; bank < y + height && bank < LCD_HEIGHT_IN_CHUNK; bank++)
+            for (uint8_t column = x; column < x + width && column < LCD_WIDTH_IN_CHUNK; column++)
+                frame[bank * LCD_WIDTH_IN_CHUNK + column] = (uint8_t) harness_random();
+        LCD_mark_dirty(x, y, width, height);
+        if (harness_random() % 4 == 0)
+            LCD_draw_line((int16_t) (harness_random() % 84), (int16_t) (harness_random() % 48),
+                          (int16_t) (harness_random() % 84), (int16_t) (harness_random() % 48), LCD_DRAW_XOR);
+
+        show();
+        if (!CHECK(harness_ram_is(chip, LCD_get_frame())))
+            return;
+    }
+}
+
+static void scenario_costs(void) {
+    //flipping to a frame that differs in one byte sends the whole frame, or one byte with the shadow buffer
+    memcpy(frames[1], frames[0], LCD_BUFFER_SIZE);
+    frames[1][200] ^= 0x3c;
+    LCD_attach_frame(frames[0]);
+    show();
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_attach_frame(frames[1]);
+    show();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    CHECK(harness_ram_is(chip, frames[1]));
+#ifdef LCD_USE_SHADOW_BUFFER
+    CHECK(traffic.bytes <= 1 + 2);
+#else
+    CHECK(traffic.bytes >= LCD_BUFFER_SIZE);
+#endif
+    harness_report(TEST_NAME, "flip_one_byte", traffic);
+}
+
+#ifdef LCD_USE_DMA
+static void scenario_in_place(void) {
+    //own buffer is copied, so drawing during the transfer waits for the next frame
+    LCD_attach_frame(0);
+    LCD_clear();
+    show();
+    LCD_fill_rect(0, 0, 84, 8, LCD_DRAW_SET);
+    static uint8_t sent[LCD_BUFFER_SIZE];
+    memcpy(sent, LCD_get_frame(), LCD_BUFFER_SIZE);
+    hal_stub.dma_polls = 2;
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    LCD_fill_rect(0, 0, 84, 8, LCD_DRAW_CLEAR);
+    hal_stub_dma_finish(&hspi1);
+    hal_stub.dma_polls = 0;
+    CHECK(harness_ram_is(chip, sent));
+    show();
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+#ifndef LCD_USE_SHADOW_BUFFER
+    //an attached frame is not copied - the chain reads it as the transfer goes
+    hal_stub.dma_polls = 2;
+    LCD_attach_frame(frames[2]);
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    frames[2][LCD_BUFFER_SIZE - 1] ^= 0xff;
+    hal_stub_dma_finish(&hspi1);
+    hal_stub.dma_polls = 0;
+    CHECK(harness_ram_is(chip, frames[2]));
+#endif
+}
+#endif
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    for (uint8_t k = 0; k < ATTACH_FRAMES; k++)
+        for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+            frames[k][i] = (uint8_t) (i * (7 + 2 * k) + k * 51);
+
+    scenario_get_frame();
+    scenario_flips();
+    scenario_costs();
+#ifdef LCD_USE_DMA
+    scenario_in_place();
+#endif
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,236 @@
+/**
+ *  @file test_console.c
+ *  @brief text console - LCD RAM after each render is the window of a reference terminal model
+ *
+ *  Random writes, control characters, scrolls by pixel and by line and follows go to the console and to a model
+ *  keeping every line ever written. After a render and update, RAM must show the model's window drawn pixel by
+ *  pixel with the font as LCD_write_char_8x6 puts it. In the paged build the console is rendered from the draw
+ *  callback, once per bank.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_console.h"
+
+#define TEST_NAME                               "console"
+
+//lines the model keeps, far more than the ring
+#define MODEL_LINES                             4096
+
+typedef struct {
+    char     text[MODEL_LINES][LCD_CONSOLE_COLUMNS];
+    uint16_t count;
+    uint8_t  column;
+    uint16_t view;
+} ConsoleModel;
+
+static HAL_StubChip *chip;
+static LCD_Console  console;
+static ConsoleModel terminal;
+static uint8_t      glyphs[256][6];
+
+#ifdef LCD_USE_PAGED_MODE
+static uint16_t first_glyph;
+
+static void draw_glyphs(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    LCD_goto_x_y_char_8x6(0, bank);
+    for (uint8_t column = 0; column < LCD_CONSOLE_COLUMNS; column++)
+        LCD_write_char_8x6((uint8_t) (first_glyph + bank * LCD_CONSOLE_COLUMNS + column));
+}
+
+static void draw_console(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    LCD_console_render(&console);
+}
+#endif
+
+/**
+ * @brief reads the font as the core writes it into a bank - from the frame, or from the glass in paged mode
+ */
+static void capture_glyphs(void) {
+#ifdef LCD_USE_PAGED_MODE
+    LCD_set_draw_callback(draw_glyphs);
+    for (first_glyph = 0; first_glyph < 256; first_glyph += LCD_HEIGHT_IN_CHUNK * LCD_CONSOLE_COLUMNS) {
+        LCD_update();
+        for (uint16_t chr = first_glyph; chr < 256 && chr < first_glyph + LCD_HEIGHT_IN_CHUNK * LCD_CONSOLE_COLUMNS;
+             chr++) {
+            uint16_t cell = chr - first_glyph;
+            memcpy(glyphs[chr], &chip->emulator.ram[cell / LCD_CONSOLE_COLUMNS][cell % LCD_CONSOLE_COLUMNS * 6], 6);
+        }
+    }
+    LCD_set_draw_callback(draw_console);
+#else
+    for (uint16_t chr = 0; chr < 256; chr++) {
+        LCD_goto_x_y_char_8x6(0, 0);
+        LCD_write_char_8x6((uint8_t) chr);
+        memcpy(glyphs[chr], LCD_get_frame(), 6);
+    }
+    LCD_clear();
+#endif
+}
+
+/**
+ * @brief renders console and sends it
+ */
+static void show(void) {
+#ifdef LCD_USE_PAGED_MODE
+    LCD_update();
+#else
+    LCD_console_render(&console);
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+#endif
+}
+
+static uint16_t model_kept(void) {
+    return terminal.count < LCD_CONSOLE_LINES ? terminal.count : LCD_CONSOLE_LINES;
+}
+
+static uint16_t model_max_view(void) {
+    uint16_t content = (uint16_t) (model_kept() * 8);
+    return content > 48 ? (uint16_t) (content - 48) : 0;
+}
+
+static void model_new_line(void) {
+    memset(terminal.text[terminal.count++ % MODEL_LINES], ' ', LCD_CONSOLE_COLUMNS);
+    terminal.column = 0;
+    if (terminal.view)
+        terminal.view = (uint16_t) (terminal.view + 8);
+    if (terminal.view > model_max_view())
+        terminal.view = model_max_view();
+}
+
+static void model_putc(char chr) {
+    if (chr == '\n') {
+        model_new_line();
+    } else if (chr == '\r') {
+        terminal.column = 0;
+    } else {
+        if (terminal.column == LCD_CONSOLE_COLUMNS)
+            model_new_line();
+        terminal.text[(terminal.count - 1) % MODEL_LINES][terminal.column++] = chr;
+    }
+}
+
+static void model_scroll(int16_t pixels) {
+    int32_t view = (int32_t) terminal.view + pixels;
+    view = view < 0 ? 0 : view;
+    view = view > model_max_view() ? model_max_view() : view;
+    terminal.view = (uint16_t) view;
+}
+
+/**
+ * @brief draws the model's window, the newest kept lines at the bottom unless scrolled back
+ * @param frame LCD_BUFFER_SIZE bytes
+ */
+static void model_frame(uint8_t *frame) {
+    uint16_t kept    = model_kept();
+    uint16_t first   = (uint16_t) (terminal.count - kept);
+    uint16_t content = (uint16_t) (kept * 8);
+    uint16_t top     = content > 48 + terminal.view ? (uint16_t) (content - 48 - terminal.view) : 0;
+    memset(frame, 0, LCD_BUFFER_SIZE);
+    for (uint16_t py = 0; py < 48; py++) {
+        uint16_t line = (uint16_t) ((top + py) / 8);
+        if (line >= kept)
+            break;
+        const char *text = terminal.text[(first + line) % MODEL_LINES];
+        for (uint16_t px = 0; px < LCD_WIDTH_IN_CHUNK; px++)
+            if ((glyphs[(uint8_t) text[px / 6]][px % 6] >> ((top + py) % 8)) & 1)
+                frame[(py / 8) * LCD_WIDTH_IN_CHUNK + px] |= (uint8_t) (1 << (py % 8));
+    }
+}
+
+/**
+ * @brief shows console and compares RAM with the model
+ * @return 1 if they match
+ */
+static int check_window(void) {
+    static uint8_t expected[LCD_BUFFER_SIZE];
+    show();
+    model_frame(expected);
+    return CHECK(harness_ram_is(chip, expected));
+}
+
+static void scenario_random(void) {
+    harness_seed(0xc0de);
+    for (uint16_t n = 0; n < 3000; n++) {
+        uint32_t pick = harness_random() % 16;
+        if (pick < 8) {
+            //printable text, and now and then a byte the font lacks
+            char chr = harness_random() % 32 ? (char) (' ' + harness_random() % 95) : (char) 0x07;
+            LCD_console_putc(&console, chr);
+            model_putc(chr);
+        } else if (pick < 10) {
+            LCD_console_putc(&console, '\n');
+            model_putc('\n');
+        } else if (pick < 11) {
+            LCD_console_putc(&console, '\r');
+            model_putc('\r');
+        } else if (pick < 13) {
+            int16_t pixels = (int16_t) (harness_random() % 41) - 20;
+            LCD_console_scroll(&console, pixels);
+            model_scroll(pixels);
+        } else if (pick < 14) {
+            int16_t lines = (int16_t) (harness_random() % 7) - 3;
+            LCD_console_scroll_lines(&console, lines);
+            model_scroll((int16_t) (lines * 8));
+        } else if (pick < 15) {
+            LCD_console_follow(&console);
+            terminal.view = 0;
+        } else if (!check_window()) {
+            return;
+        }
+    }
+    check_window();
+}
+
+static void scenario_costs(void) {
+    LCD_console_follow(&console);
+    terminal.view = 0;
+    LCD_console_write(&console, "\nlog");
+    model_putc('\n');
+    model_putc('l');
+    model_putc('o');
+    model_putc('g');
+    check_window();
+
+    //one character while following redraws one line
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_console_putc(&console, '!');
+    model_putc('!');
+    check_window();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "one_char", traffic);
+#ifdef LCD_USE_PAGED_MODE
+    CHECK_EQUAL(traffic.bytes, 2 + LCD_BUFFER_SIZE);
+#elif defined(LCD_USE_SHADOW_BUFFER)
+    CHECK(traffic.bytes <= 2 + 6);
+#else
+    CHECK(traffic.bytes <= 2 + LCD_WIDTH_IN_CHUNK);
+#endif
+
+#ifndef LCD_USE_PAGED_MODE
+    //drawing over console needs an invalidate
+    LCD_clear();
+    LCD_console_invalidate(&console);
+    check_window();
+#endif
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    capture_glyphs();
+    LCD_console_init(&console);
+    memset(terminal.text[0], ' ', LCD_CONSOLE_COLUMNS);
+    terminal.count = 1;
+
+    scenario_random();
+    scenario_costs();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,150 @@
+/**
+ *  @file test_dma.c
+ *  @brief DMA chains - handle registry, a chain running while drawing goes on, bus stats and failed segments
+ *
+ *  Built in LCD_USE_DMA builds only. Transfers end after a few polls of HAL_SPI_GetState, as a real transfer ends
+ *  some time after it started, or at once inside HAL_SPI_Transmit_DMA when the host board is told so.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+
+#define TEST_NAME                               "dma"
+
+static HAL_StubChip *chip;
+static uint8_t      completions;
+
+static void on_complete(LCD_HandleTypeDef *hlcd) {
+    completions++;
+}
+
+/**
+ * @brief polls bus until chain of default LCD ends, as a caller waiting on LCD_is_busy would
+ */
+static void wait_chain(void) {
+    for (uint16_t polls = 0; LCD_is_busy() && polls < 1000; polls++)
+        HAL_SPI_GetState(&hspi1);
+    CHECK(!LCD_is_busy());
+}
+
+static void scenario_registry(void) {
+    //default LCD holds one slot, three more fit and a fifth LCD is refused before anything is touched
+    static LCD_HandleTypeDef extra[LCD_MAX_INSTANCES] = {
+            LCD_HANDLE_INIT(&hspi2, GPIOC, GPIO_PIN_0, GPIOC, GPIO_PIN_1, 0, 0),
+            LCD_HANDLE_INIT(&hspi2, GPIOC, GPIO_PIN_0, GPIOC, GPIO_PIN_2, 0, 0),
+            LCD_HANDLE_INIT(&hspi2, GPIOC, GPIO_PIN_0, GPIOC, GPIO_PIN_3, 0, 0),
+            LCD_HANDLE_INIT(&hspi2, GPIOC, GPIO_PIN_0, GPIOC, GPIO_PIN_4, 0, 0)};
+
+    CHECK_EQUAL(LCDx_update_async(&extra[0]), HAL_ERROR);
+    for (uint8_t i = 0; i < LCD_MAX_INSTANCES - 1; i++)
+        CHECK_EQUAL(LCDx_Init(&extra[i], 60), HAL_OK);
+    uint32_t pins = GPIOC->ODR;
+    CHECK_EQUAL(LCDx_Init_async(&extra[LCD_MAX_INSTANCES - 1], 60), HAL_ERROR);
+    CHECK_EQUAL(LCDx_Init(&extra[LCD_MAX_INSTANCES - 1], 60), HAL_ERROR);
+    CHECK(extra[LCD_MAX_INSTANCES - 1].frame == 0);
+    CHECK_EQUAL(GPIOC->ODR, pins);
+    CHECK_EQUAL(LCDx_update_async(&extra[LCD_MAX_INSTANCES - 1]), HAL_ERROR);
+
+    //a registered LCD may be set up again without taking another slot
+    CHECK_EQUAL(LCDx_Init(&extra[0], 60), HAL_OK);
+    CHECK_EQUAL(LCD_Init(60), HAL_OK);
+    CHECK_EQUAL(LCDx_update_async(&extra[0]), HAL_OK);
+}
+
+static void scenario_deferred(void) {
+    LCD_set_update_callback(on_complete);
+    hal_stub.dma_polls = 3;
+    LCD_draw_string(0, 0, "left", LCD_DRAW_SET);
+    LCD_draw_string(60, 20, "right", LCD_DRAW_SET);
+    LCD_fill_rect(10, 40, 64, 8, LCD_DRAW_XOR);
+
+    static uint8_t sent[LCD_BUFFER_SIZE];
+    memcpy(sent, LCD_get_frame(), LCD_BUFFER_SIZE);
+    completions = 0;
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    CHECK(LCD_is_busy());
+    CHECK_EQUAL(LCD_update_async(), HAL_BUSY);
+
+    //drawing goes on during transfer, glass gets the frame as it was at start
+    LCD_fill_rect(0, 0, 84, 48, LCD_DRAW_XOR);
+    wait_chain();
+    CHECK_EQUAL(completions, 1);
+    CHECK(harness_ram_is(chip, sent));
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    wait_chain();
+    CHECK_EQUAL(completions, 2);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    hal_stub.dma_polls = 0;
+    LCD_set_update_callback(0);
+}
+
+static void scenario_stats(void) {
+#ifdef LCD_USE_BUS_STATS
+    //a chain completing inside HAL_SPI_Transmit_DMA is still counted whole in its frame
+    LCD_BusStats   before;
+    LCD_BusStats   after;
+    LCD_get_bus_stats(&before);
+    LCD_draw_string(5, 9, "stats", LCD_DRAW_XOR);
+    LCD_draw_hline(0, 45, 84, LCD_DRAW_XOR);
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    CHECK(!LCD_is_busy());
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    LCD_get_bus_stats(&after);
+    CHECK_EQUAL(after.frames, before.frames + 1);
+    CHECK_EQUAL(after.last_frame_transactions, traffic.transactions);
+    CHECK_EQUAL(after.last_frame_bytes, traffic.bytes);
+    CHECK_EQUAL(after.bytes - before.bytes, traffic.bytes);
+    harness_report(TEST_NAME, "stats", traffic);
+#endif
+}
+
+static void scenario_failed_segment(void) {
+    //a chain whose first segment cannot start reports an error and leaves bus free
+    LCD_draw_string(30, 30, "fail", LCD_DRAW_XOR);
+    hal_stub.fail_count  = 1;
+    hal_stub.fail_status = HAL_ERROR;
+    CHECK_EQUAL(LCD_update_async(), HAL_ERROR);
+    CHECK(!LCD_is_busy());
+    CHECK(hlcd1.bus_error);
+
+    //one failing in the middle ends chain - no completion, next update resends whole frame
+    LCD_set_update_callback(on_complete);
+    completions        = 0;
+    hal_stub.dma_polls = 2;
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub.fail_count = 1;
+    wait_chain();
+    CHECK_EQUAL(completions, 0);
+    CHECK(hlcd1.bus_error);
+    CHECK(!harness_ram_is(chip, LCD_get_frame()));
+
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    wait_chain();
+    harness_report(TEST_NAME, "recovery", harness_traffic_since(chip, mark));
+    CHECK_EQUAL(completions, 1);
+    CHECK(!hlcd1.bus_error);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+#ifdef LCD_USE_BUS_STATS
+    LCD_BusStats stats;
+    LCD_get_bus_stats(&stats);
+    CHECK_EQUAL(stats.errors, 2);
+#endif
+    hal_stub.dma_polls = 0;
+    LCD_set_update_callback(0);
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    scenario_registry();
+    scenario_deferred();
+    scenario_stats();
+    scenario_failed_segment();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,168 @@
+/**
+ *  @file test_effects.c
+ *  @brief display effects and idle power down - each costs its command bytes and leaves LCD RAM alone
+ *
+ *  Time is HAL_GetTick of the host board, moved on a millisecond per update. Invert, blank, flash and blink must show
+ *  on the emulated panel's display mode with one command byte per change, idle power down must come after its time
+ *  with one byte, and waking must take one function set byte besides what was drawn. The scheduler then runs a
+ *  flash on its own ticks through LCDx_step_effects.
+ */
+
+#include "harness.h"
+#include "lcd_5110_sched.h"
+
+#define TEST_NAME                               "effects"
+
+static HAL_StubChip  *chip;
+static LCD_Scheduler scheduler;
+
+/**
+ * @brief runs updates 1 ms apart
+ * @param ms updates
+ * @return bytes they sent
+ */
+static uint32_t run(uint16_t ms) {
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    while (ms--) {
+        hal_stub.tick++;
+        LCD_update();
+    }
+    return harness_traffic_since(chip, mark).bytes;
+}
+
+static void scenario_modes(void) {
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_string("effects");
+    run(1);
+
+    //invert and back is a one-byte frame each, RAM is left as it was
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_invert(1);
+    LCD_update();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "invert", traffic);
+    CHECK_EQUAL(traffic.bytes, 1);
+    CHECK_EQUAL(traffic.transactions, 1);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_INVERTED);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    CHECK_EQUAL(run(10), 0);
+    LCD_invert(0);
+    CHECK_EQUAL(run(1), 1);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_NORMAL);
+
+    //blank keeps content, unblank shows it without resending
+    LCD_blank(1);
+    CHECK_EQUAL(run(1), 1);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_BLANK);
+    LCD_blank(0);
+    CHECK_EQUAL(run(1), 1);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_NORMAL);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+static void scenario_flash(void) {
+#ifdef LCD_USE_BUS_STATS
+    uint32_t mode_commands = hlcd1.bus_stats.mode_commands;
+#endif
+    //100 ms flash over 300 ms: on and off three times, then normal which is what panel shows already
+    LCD_flash(100, 300);
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    uint16_t       on   = 0;
+    for (uint16_t ms = 0; ms < 400; ms++) {
+        LCD_update();
+        on += chip->emulator.display == LCD_EMU_DISPLAY_ALL_ON;
+        hal_stub.tick++;
+    }
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "flash_300ms", traffic);
+    CHECK_EQUAL(traffic.bytes, 6);
+    CHECK_EQUAL(on, 150);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_NORMAL);
+#ifdef LCD_USE_BUS_STATS
+    CHECK_EQUAL(hlcd1.bus_stats.mode_commands - mode_commands, 6);
+#endif
+
+    //blink until stopped is blank first half of each period
+    LCD_blink(20, 0);
+    run(1);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_BLANK);
+    run(10);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_NORMAL);
+    run(10);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_BLANK);
+    LCD_stop_effect();
+    CHECK_EQUAL(run(1), 1);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_NORMAL);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+static void scenario_idle(void) {
+    LCD_set_idle_power_down(500);
+    CHECK_EQUAL(run(499), 0);
+    CHECK(!LCD_is_powered_down());
+    CHECK_EQUAL(run(1), 1);
+    CHECK(LCD_is_powered_down());
+    CHECK(chip->emulator.power_down);
+    CHECK_EQUAL(run(1000), 0);
+
+    //a glyph wakes panel with a function set byte, then its address and 6 columns - RAM kept the rest
+    LCD_goto_x_y_char_8x6(3, 4);
+    LCD_write_char_8x6('Z');
+    CHECK_EQUAL(hlcd1.dirty_high[4] - hlcd1.dirty_low[4], 6);
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    run(1);
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "resume_glyph", traffic);
+#ifdef LCD_USE_SHADOW_BUFFER
+    //columns equal to what panel holds are left out
+    CHECK(traffic.bytes > 1 + 2 && traffic.bytes <= 1 + 2 + 6);
+#else
+    CHECK_EQUAL(traffic.bytes, 1 + 2 + 6);
+#endif
+    CHECK(!LCD_is_powered_down());
+    CHECK(!chip->emulator.power_down);
+    CHECK(!chip->emulator.vertical);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+
+    //nothing powers down while an effect runs
+    LCD_flash(100, 0);
+    run(1000);
+    CHECK(!LCD_is_powered_down());
+    LCD_stop_effect();
+    run(1);
+    LCD_set_idle_power_down(0);
+    CHECK_EQUAL(run(1000), 0);
+    CHECK(!LCD_is_powered_down());
+}
+
+static void scenario_scheduler(void) {
+    CHECK_EQUAL(LCD_scheduler_start(&scheduler, &htim2, 1000, 50, 100), HAL_OK);
+    LCD_flash(100, 200);
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    uint16_t       on   = 0;
+    for (uint16_t ms = 0; ms < 300; ms++) {
+        hal_stub.tick++;
+        LCD_TIM_PeriodElapsedCallback(&htim2);
+#ifdef LCD_USE_DMA
+        hal_stub_dma_finish(&hspi1);
+#endif
+        on += chip->emulator.display == LCD_EMU_DISPLAY_ALL_ON;
+    }
+    CHECK_EQUAL(harness_traffic_since(chip, mark).bytes, 4);
+    CHECK(on >= 90 && on <= 110);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_NORMAL);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    LCD_scheduler_stop(&scheduler);
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+
+    scenario_modes();
+    scenario_flash();
+    scenario_idle();
+    scenario_scheduler();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
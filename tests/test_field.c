@@ -0,0 +1,173 @@
+/**
+ *  @file test_field.c
+ *  @brief numeric fields - LCD_field_set shows what snprintf formats, and marks only the cells that changed
+ *
+ *  Random fields of every format, width, padding and decimals get random values, extremes included. The text is
+ *  formatted independently with snprintf and drawn into a model with the font as LCD_write_char_8x6 puts it, and
+ *  the frame must equal the model. After each value the dirty span of the field's bank must cover exactly the
+ *  cells whose character changed.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_field.h"
+
+#define TEST_NAME                               "field"
+
+static HAL_StubChip *chip;
+static uint8_t      glyphs['~' - ' ' + 1][6];
+static uint8_t      model[LCD_BUFFER_SIZE];
+
+/**
+ * @brief formats a value as a field should show it
+ * @param text receives field->width characters and a terminator
+ */
+static void reference(const LCD_Field *field, int32_t value, char *text) {
+    char     digits[32];
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+    if (field->format == LCD_FIELD_HEX) {
+        snprintf(digits, sizeof(digits), "%lX", (unsigned long) (uint32_t) value);
+    } else {
+        uint32_t scale = 1;
+        for (uint8_t i = 0; i < field->decimals; i++)
+            scale *= 10;
+        //a 32-bit value has at most 10 digits
+        int places = field->decimals > 10 ? 10 : field->decimals;
+        if (places)
+            snprintf(digits, sizeof(digits), "%lu.%0*lu", (unsigned long) (magnitude / scale), places,
+                     (unsigned long) (magnitude % scale));
+        else
+            snprintf(digits, sizeof(digits), "%lu", (unsigned long) magnitude);
+    }
+    uint8_t negative = field->format == LCD_FIELD_DECIMAL && value < 0;
+    size_t  length   = strlen(digits) + negative;
+    if (length > field->width) {
+        memset(text, '#', field->width);
+    } else {
+        size_t pad = field->width - length;
+        if (field->zero_pad)
+            snprintf(text, (size_t) field->width + 1, "%s%.*s%s", negative ? "-" : "", (int) pad,
+                     "000000000000", digits);
+        else
+            snprintf(text, (size_t) field->width + 1, "%*s%s%s", (int) pad, "", negative ? "-" : "", digits);
+    }
+    text[field->width] = 0;
+}
+
+/**
+ * @brief draws a text into the model at a chunk position, clipped at right edge
+ */
+static void model_text(uint8_t x, uint8_t y, const char *text) {
+    for (uint16_t column = x; *text; text++)
+        for (uint8_t n = 0; n < 6; n++, column++)
+            if (column < LCD_WIDTH_IN_CHUNK)
+                model[y * LCD_WIDTH_IN_CHUNK + column] = glyphs[*text - ' '][n];
+}
+
+static int32_t random_value(void) {
+    static const int32_t extremes[] = {0, 1, -1, 9, 10, -10, 99, 100, INT32_MAX, INT32_MIN, 255, 4096};
+    switch (harness_random() % 4) {
+        case 0:
+            return extremes[harness_random() % (sizeof(extremes) / sizeof(extremes[0]))];
+        case 1:
+            return (int32_t) (harness_random() % 2000) - 1000;
+        default:
+            return (int32_t) harness_random();
+    }
+}
+
+static void scenario_random(void) {
+    harness_seed(0xf1e1d);
+    for (uint16_t n = 0; n < 2000; n++) {
+        LCD_Field field;
+        uint8_t   width  = (uint8_t) (1 + harness_random() % LCD_FIELD_MAX_WIDTH);
+        uint8_t   hex    = harness_random() % 4 == 0;
+        uint8_t   x      = (uint8_t) (harness_random() % LCD_WIDTH_IN_CHUNK);
+        uint8_t   y      = (uint8_t) (harness_random() % LCD_HEIGHT_IN_CHUNK);
+        LCD_field_init(&field, x, y, width, hex ? LCD_FIELD_HEX : LCD_FIELD_DECIMAL,
+                       hex ? 0 : (uint8_t) (harness_random() % 4), harness_random() % 2);
+
+        //a field starts unknown, each value then redraws what changed
+        LCD_clear();
+        LCD_update();
+        memset(model, 0, sizeof(model));
+        char shown[LCD_FIELD_MAX_WIDTH + 1];
+        memset(shown, 0, sizeof(shown));
+        for (uint8_t k = 0; k < 10; k++) {
+            char    text[LCD_FIELD_MAX_WIDTH + 1];
+            int32_t value = k % 3 ? (int32_t) (random_value() % 100) : random_value();
+            reference(&field, value, text);
+            LCD_field_set(&field, value);
+            model_text(x, y, text);
+            if (!CHECK(memcmp(LCD_get_frame(), model, LCD_BUFFER_SIZE) == 0)) {
+                printf("%u chars at %u,%u, decimals %u, %s, value %ld: \"%s\"\n", width, x, y, field.decimals,
+                       hex ? "hex" : field.zero_pad ? "zero padded" : "space padded", (long) value, text);
+                return;
+            }
+
+            //dirty span is first to last changed cell, clipped at right edge
+            int16_t low  = -1;
+            int16_t high = -1;
+            for (uint8_t i = 0; i < width && x + i * 6 < LCD_WIDTH_IN_CHUNK; i++)
+                if (shown[i] != text[i]) {
+                    low  = low < 0 ? (int16_t) (x + i * 6) : low;
+                    high = (int16_t) (x + i * 6 + 6 > LCD_WIDTH_IN_CHUNK ? LCD_WIDTH_IN_CHUNK : x + i * 6 + 6);
+                }
+            memcpy(shown, text, sizeof(shown));
+            if (low < 0)
+                CHECK(hlcd1.dirty_low[y] >= hlcd1.dirty_high[y]);
+            else if (!CHECK_EQUAL(hlcd1.dirty_low[y], low) || !CHECK_EQUAL(hlcd1.dirty_high[y], high))
+                return;
+            LCD_update();
+        }
+        if (!CHECK(harness_ram_is(chip, model)))
+            return;
+    }
+}
+
+static void scenario_invalidate(void) {
+    LCD_Field field;
+    LCD_field_init(&field, 10, 2, 6, LCD_FIELD_DECIMAL, 2, 0);
+    LCD_field_set(&field, -1234);
+    LCD_update();
+    //same value again sends nothing
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_field_set(&field, -1234);
+    LCD_update();
+    CHECK_EQUAL(harness_traffic_since(chip, mark).bytes, 0);
+
+    //after a clear the field is redrawn whole once invalidated
+    LCD_clear();
+    LCD_field_invalidate(&field);
+    LCD_field_set(&field, -1234);
+    memset(model, 0, sizeof(model));
+    model_text(10, 2, "-12.34");
+    CHECK(memcmp(LCD_get_frame(), model, LCD_BUFFER_SIZE) == 0);
+    LCD_update();
+    CHECK(harness_ram_is(chip, model));
+
+    //one digit changing costs one cell
+    mark = harness_traffic_mark(chip);
+    LCD_field_set(&field, -1235);
+    LCD_update();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "one_digit", traffic);
+    CHECK(traffic.bytes <= 6 + 2);
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    for (uint8_t i = 0; i <= '~' - ' '; i++) {
+        LCD_goto_x_y_char_8x6(0, 0);
+        LCD_write_char_8x6((uint8_t) (' ' + i));
+        memcpy(glyphs[i], LCD_get_frame(), 6);
+    }
+    LCD_clear();
+
+    scenario_random();
+    scenario_invalidate();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,158 @@
+/**
+ *  @file test_font.c
+ *  @brief BDF fonts - tests/fonts/tiny.bdf through tools/bdf2lcd.py, drawn by the text engine
+ *
+ *  The Makefile generates tiny_font.c from the BDF with bdf2lcd.py and this test includes it. The glyphs below are
+ *  the same font drawn by hand as whole 10-pixel cells, so BBX offsets, descenders, glyphs wider than a byte and the
+ *  run table of the generator are all checked against pixels on the LCD - at pixel Y crossing banks and clipped at
+ *  the edges.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_text.h"
+#include "tiny_font.c"
+
+#define TEST_NAME                               "font"
+
+//height of tiny.bdf, ascent 8 + descent 2
+#define FONT_HEIGHT                             10
+
+typedef struct {
+    uint32_t   code_point;
+    uint8_t    advance;
+    const char *rows[FONT_HEIGHT];//'#' is on, columns up to the last one of the bitmap
+} FontArt;
+
+static const FontArt art[] = {
+        {'?', 5, {".##.", "#..#", "...#", "..#.", ".#..", "....", ".#..", "....", "....", "...."}},
+        {'A', 6, {"..#..", ".#.#.", "#...#", "#...#", "#####", "#...#", "#...#", "#...#", ".....", "....."}},
+        {'B', 6, {".###.", ".#..#", ".#..#", ".###.", ".#..#", ".#..#", ".#..#", ".###.", ".....", "....."}},
+        {'g', 5, {"....", "....", "....", ".###", "#..#", "#..#", ".###", "...#", "#..#", ".##."}},
+        {'i', 3, {"..", ".#", "..", ".#", ".#", ".#", ".#", ".#", "..", ".."}},
+        {0xE9, 5, {"..#.", ".#..", "....", ".##.", "#..#", "####", "#...", ".###", "....", "...."}},
+        {0x2190, 10, {".........", "..#......", ".#.......", "#########", ".#.......", "..#......", ".........",
+                      ".........", ".........", "........."}},
+};
+
+#define ART_COUNT                               (sizeof(art) / sizeof(art[0]))
+
+static HAL_StubChip *chip;
+
+/**
+ * @brief whether a pixel of a glyph drawn at (x, y) is on
+ * @return 1 if (px, py) is an on pixel of glyph
+ */
+static uint8_t art_pixel(const FontArt *glyph, int16_t x, int16_t y, int16_t px, int16_t py) {
+    int16_t column = (int16_t) (px - x);
+    int16_t row    = (int16_t) (py - y);
+    if (row < 0 || row >= FONT_HEIGHT || column < 0 || column >= (int16_t) strlen(glyph->rows[row]))
+        return 0;
+    return glyph->rows[row][column] == '#';
+}
+
+/**
+ * @brief checks the whole frame against one glyph drawn on a blank frame
+ * @return 1 if every pixel matches
+ */
+static int frame_is_glyph(const FontArt *glyph, int16_t x, int16_t y) {
+    for (int16_t py = 0; py < LCD_HEIGHT_IN_PIXEL; py++)
+        for (int16_t px = 0; px < LCD_WIDTH_IN_PIXEL; px++)
+            if (LCD_get_pixel(px, py) != art_pixel(glyph, x, y, px, py))
+                return CHECK_EQUAL(LCD_get_pixel(px, py), art_pixel(glyph, x, y, px, py));
+    return 1;
+}
+
+static void scenario_generated(void) {
+    //one glyph per run, 0x41-0x42 share one
+    CHECK_EQUAL(tiny_font.height, FONT_HEIGHT);
+    CHECK_EQUAL(tiny_font.range_count, 6);
+    CHECK_EQUAL(tiny_font.fallback, LCD_font_find_glyph(&tiny_font, '?'));
+    for (uint16_t i = 0; i < ART_COUNT; i++)
+        CHECK_EQUAL(LCD_font_find_glyph(&tiny_font, art[i].code_point), i);
+    CHECK_EQUAL(LCD_font_find_glyph(&tiny_font, 'C'), tiny_font.fallback);
+    CHECK_EQUAL(LCD_font_find_glyph(&tiny_font, 0x10FFFF), tiny_font.fallback);
+}
+
+static void scenario_glyphs(void) {
+    //aligned, crossing banks, clipped at each edge
+    static const int16_t places[][2] = {{0, 0}, {10, 3}, {37, 13}, {-2, 20}, {80, 29}, {50, 41}, {20, -4}};
+    for (uint16_t i = 0; i < ART_COUNT; i++)
+        for (uint8_t p = 0; p < sizeof(places) / sizeof(places[0]); p++) {
+            int16_t x = places[p][0];
+            int16_t y = places[p][1];
+            LCD_clear();
+            CHECK_EQUAL(LCD_draw_glyph(&tiny_font, x, y, art[i].code_point, LCD_DRAW_SET), x + art[i].advance);
+            if (!frame_is_glyph(&art[i], x, y))
+                return;
+        }
+    LCD_update();
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+
+    //missing code points are drawn as '?'
+    LCD_clear();
+    CHECK_EQUAL(LCD_draw_glyph(&tiny_font, 5, 7, 'Z', LCD_DRAW_SET), 5 + art[0].advance);
+    frame_is_glyph(&art[0], 5, 7);
+}
+
+static void scenario_text(void) {
+    //"AgiBé←" - each glyph starts at the advance of the one before
+    static const char text[] = "Agi" "B\xc3\xa9" "\xe2\x86\x90";
+    static const uint8_t order[] = {1, 3, 4, 2, 5, 6};
+    int16_t              width   = 0;
+    for (uint8_t k = 0; k < sizeof(order); k++)
+        width = (int16_t) (width + art[order[k]].advance);
+    CHECK_EQUAL(LCD_text_width(&tiny_font, text), width);
+
+    LCD_clear();
+    CHECK_EQUAL(LCD_draw_text(&tiny_font, 4, 19, text, LCD_DRAW_SET), 4 + width);
+    int16_t x = 4;
+    for (uint8_t k = 0; k < sizeof(order); k++) {
+        const FontArt *glyph = &art[order[k]];
+        for (int16_t py = 19; py < 19 + FONT_HEIGHT; py++)
+            for (int16_t px = x; px < x + glyph->advance; px++)
+                CHECK_EQUAL(LCD_get_pixel(px, py), art_pixel(glyph, x, 19, px, py));
+        x = (int16_t) (x + glyph->advance);
+    }
+
+    //copy mode clears the cell up to the advance and nothing else
+    memset(LCD_get_frame(), 0xff, LCD_BUFFER_SIZE);
+    LCD_draw_glyph(&tiny_font, 30, 5, 'i', LCD_DRAW_COPY);
+    for (int16_t py = 0; py < LCD_HEIGHT_IN_PIXEL; py++)
+        for (int16_t px = 0; px < LCD_WIDTH_IN_PIXEL; px++) {
+            uint8_t inside = px >= 30 && px < 30 + art[4].advance && py >= 5 && py < 5 + FONT_HEIGHT;
+            if (LCD_get_pixel(px, py) != (inside ? art_pixel(&art[4], 30, 5, px, py) : 1))
+                CHECK_EQUAL(LCD_get_pixel(px, py), inside ? art_pixel(&art[4], 30, 5, px, py) : 1);
+        }
+    LCD_mark_dirty(0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    LCD_update();
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+static void scenario_surrogates(void) {
+    //a font that has glyph 0 for the surrogates would show them if they were decoded, 1 is fallback, 2 their neighbours
+    static const uint8_t       bitmaps[] = {0x0f, 0xf0, 0x3c};
+    static const LCD_FontRange ranges[]  = {{0xD7FF, 1, 2}, {0xD800, 1, 0}, {0xDFFF, 1, 0}, {0xE000, 1, 2}};
+    static const LCD_Font      font      = {bitmaps, 0, ranges, 4, 1, 8, 1, 1};
+
+    //U+D7FF, U+D800, U+DFFF, U+E000 - each is one glyph and text goes on after a malformed one
+    static const char text[] = "\xed\x9f\xbf" "\xed\xa0\x80" "\xed\xbf\xbf" "\xee\x80\x80";
+    static const uint8_t expected[] = {0x3c, 0xf0, 0xf0, 0x3c, 0x00};
+    LCD_clear();
+    CHECK_EQUAL(LCD_text_width(&font, text), 4);
+    CHECK_EQUAL(LCD_draw_text(&font, 0, 0, text, LCD_DRAW_SET), 4);
+    for (uint8_t x = 0; x < sizeof(expected); x++)
+        CHECK_EQUAL(LCD_get_frame()[x], expected[x]);
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+
+    scenario_generated();
+    scenario_glyphs();
+    scenario_text();
+    scenario_surrogates();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,251 @@
+/**
+ *  @file test_golden.c
+ *  @brief golden frames of update, text, graphics and image functions, as shown by the emulated panel
+ *
+ *  Each scenario draws through the public API, updates and compares the glass with a committed PBM image. After
+ *  every update RAM of the chip must also equal the frame, so a wrong golden frame cannot hide a wrong update.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_text.h"
+
+#define TEST_NAME                               "golden"
+
+//function set with basic instructions and horizontal addressing, LCD_VERTICAL_DISABLE of the driver
+#define FUNCTION_SET_HORIZONTAL                 0x20
+
+static HAL_StubChip *chip;
+static uint16_t     vertical_disables;
+
+/**
+ * @brief counts function set commands leaving vertical addressing
+ */
+static void count_vertical_disables(SPI_HandleTypeDef *hspi, uint8_t is_data, const uint8_t *data, uint16_t length) {
+    for (uint16_t i = 0; i < length && !is_data; i++)
+        vertical_disables += data[i] == FUNCTION_SET_HORIZONTAL;
+}
+
+/**
+ * @brief sends changes of default LCD - by DMA chain in DMA builds - and checks RAM against frame
+ */
+static void show(void) {
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+static void scenario_update(void) {
+    static uint8_t picture[LCD_BUFFER_SIZE];
+    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+        picture[i] = (uint8_t) (i * 37 + (i / LCD_WIDTH_IN_CHUNK) * 11);
+
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_write_full_pic(picture);
+    show();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "full_pic", traffic);
+    CHECK_EQUAL(traffic.transactions, 2);
+#ifdef LCD_USE_SHADOW_BUFFER
+    //bytes already on the cleared panel are left out
+    CHECK(traffic.bytes <= 2 + LCD_BUFFER_SIZE);
+#else
+    CHECK_EQUAL(traffic.bytes, 2 + LCD_BUFFER_SIZE);
+#endif
+
+    //single byte, a column through all banks (vertical addressing) and a span crossing a bank end
+    uint8_t *frame = LCD_get_frame();
+    frame[3 * LCD_WIDTH_IN_CHUNK + 40] ^= 0xff;
+    LCD_mark_dirty(40, 3, 1, 1);
+    mark = harness_traffic_mark(chip);
+    show();
+    traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "one_byte", traffic);
+    CHECK_EQUAL(traffic.transactions, 2);
+    CHECK_EQUAL(traffic.bytes, 2 + 1);
+
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        frame[bank * LCD_WIDTH_IN_CHUNK + 7] = 0x55;
+    LCD_mark_dirty(7, 0, 1, LCD_HEIGHT_IN_CHUNK);
+    mark = harness_traffic_mark(chip);
+    show();
+    traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "column", traffic);
+#ifdef LCD_USE_DMA
+    //DMA chain sends from row-major snapshot, an address pair and a byte per bank
+    CHECK_EQUAL(traffic.transactions, 2 * LCD_HEIGHT_IN_CHUNK);
+    CHECK_EQUAL(traffic.bytes, 3 * LCD_HEIGHT_IN_CHUNK);
+#else
+    //vertical mode switch and an address pair, then the column in one burst
+    CHECK_EQUAL(traffic.transactions, 2);
+    CHECK_EQUAL(traffic.bytes, 1 + 2 + LCD_HEIGHT_IN_CHUNK);
+#endif
+#ifdef LCD_USE_DMA
+    CHECK(!chip->emulator.vertical);
+#else
+    CHECK(chip->emulator.vertical);
+#endif
+
+    for (uint16_t i = 80; i < 90; i++)
+        frame[LCD_WIDTH_IN_CHUNK + i] = 0x81;
+    LCD_mark_dirty(80, 1, 4, 1);
+    LCD_mark_dirty(0, 2, 6, 1);
+    mark                 = harness_traffic_mark(chip);
+    vertical_disables    = 0;
+    hal_stub.on_transmit = count_vertical_disables;
+    show();
+    traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, "bank_end", traffic);
+    CHECK_EQUAL(traffic.transactions, 2);
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(traffic.bytes, 2 + 10);
+#else
+    //one run wrapping from bank 1 into bank 2, after the switch back to horizontal mode
+    CHECK_EQUAL(traffic.bytes, 1 + 2 + 10);
+#endif
+    //wide update goes out horizontally, leaving vertical mode once
+    CHECK(!chip->emulator.vertical);
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(vertical_disables, 0);
+#else
+    CHECK_EQUAL(vertical_disables, 1);
+#endif
+
+    harness_golden(chip, "update");
+
+    //mode is tracked, the next update does not leave vertical mode again
+    frame[5 * LCD_WIDTH_IN_CHUNK + 60] ^= 0x0f;
+    LCD_mark_dirty(60, 5, 1, 1);
+    uint16_t disables = vertical_disables;
+    mark              = harness_traffic_mark(chip);
+    show();
+    CHECK_EQUAL(harness_traffic_since(chip, mark).bytes, 2 + 1);
+    CHECK_EQUAL(vertical_disables, disables);
+    hal_stub.on_transmit = 0;
+}
+
+static void scenario_text(void) {
+    LCD_clear();
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_string("Nokia 5110");
+    LCD_goto_x_y_char_8x6(2, 1);
+    LCD_write_string("0123456789ABCD");
+    LCD_goto_x_y_char_8x6(0, 3);
+    LCD_write_char_8x6('~');
+    LCD_write_char_8x6(0x7f);
+    LCD_draw_string(3, 37, "y=37", LCD_DRAW_SET);
+    LCD_draw_text(&lcd_font_en_8x5, 40, 28, "\xc3\xa9t\xc3\xa9", LCD_DRAW_COPY);
+    show();
+    harness_report(TEST_NAME, "text", harness_traffic_since(chip, mark));
+    harness_golden(chip, "text");
+}
+
+static void scenario_gfx(void) {
+    static const uint8_t sprite[] = {
+            0x3c, 0x42, 0x81, 0xa5, 0x81, 0x99, 0x42, 0x3c,
+            0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00};
+
+    LCD_clear();
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_draw_rect(0, 0, 84, 48, LCD_DRAW_SET);
+    LCD_fill_rect(10, 13, 30, 5, LCD_DRAW_XOR);
+    LCD_fill_rect(20, 5, 10, 30, LCD_DRAW_XOR);
+    LCD_draw_line(0, 47, 83, 0, LCD_DRAW_SET);
+    LCD_draw_line(-10, 5, 100, 30, LCD_DRAW_XOR);
+    LCD_draw_hline(50, 40, 30, LCD_DRAW_SET);
+    LCD_draw_vline(70, -5, 20, LCD_DRAW_SET);
+    LCD_draw_bitmap(60, 21, sprite, 8, 9, LCD_DRAW_COPY);
+    LCD_draw_bitmap(78, 43, sprite, 8, 9, LCD_DRAW_XOR);
+    LCD_draw_pixel(2, 2, LCD_DRAW_SET);
+    LCD_draw_pixel(0, 0, LCD_DRAW_CLEAR);
+    show();
+    harness_report(TEST_NAME, "gfx", harness_traffic_since(chip, mark));
+    CHECK(LCD_get_pixel(2, 2));
+    CHECK(!LCD_get_pixel(0, 0));
+    harness_golden(chip, "gfx");
+}
+
+static void scenario_decompress(void) {
+    static uint8_t icon[16 * 2];
+    static uint8_t wide[100 * 3];
+    static uint8_t compressed[sizeof(wide) * 2];
+    for (uint8_t i = 0; i < sizeof(icon); i++)
+        icon[i] = (uint8_t) (i % 16 < 4 || i % 16 > 11 ? 0 : 0x18 << (i / 16));
+    for (uint16_t i = 0; i < sizeof(wide); i++)
+        wide[i] = (uint8_t) (i % 7 ? 0xff : (i % 100) | 0x81);
+
+    LCD_clear();
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    uint32_t length = harness_encode(icon, 16, 2, 0, compressed);
+    CHECK_EQUAL(LCD_decompress_image(compressed, length, 4, 0), HAL_OK);
+    //moved inside LCD border
+    CHECK_EQUAL(LCD_decompress_image(compressed, length, 80, 5), HAL_OK);
+    //inverted image wider than LCD is clipped at right edge
+    length = harness_encode(wide, 100, 3, 1, compressed);
+    CHECK_EQUAL(LCD_decompress_image(compressed, length, 0, 2), HAL_OK);
+    //truncated image keeps its decoded part
+    length = harness_encode(icon, 16, 2, 0, compressed);
+    CHECK_EQUAL(LCD_decompress_image(compressed, length - 9, 30, 0), HAL_ERROR);
+    show();
+    harness_report(TEST_NAME, "decompress", harness_traffic_since(chip, mark));
+    harness_golden(chip, "decompress");
+}
+
+static void scenario_pbm(void) {
+    //PBM rows are MSB first - known pixels land on known bits
+    LCD_clear();
+    LCD_draw_pixel(0, 0, LCD_DRAW_SET);
+    LCD_draw_pixel(83, 47, LCD_DRAW_SET);
+    LCD_draw_pixel(9, 8, LCD_DRAW_SET);
+    show();
+    CHECK(LCD_emu_pixel(&chip->emulator, 0, 0));
+    CHECK(LCD_emu_pixel(&chip->emulator, 9, 8));
+    CHECK(!LCD_emu_pixel(&chip->emulator, 9, 9));
+    CHECK(harness_golden(chip, "pbm"));
+
+    FILE    *file = 0;
+    char    path[256];
+    uint8_t image[9 + 11 * 48];
+    snprintf(path, sizeof(path), "%s/pbm.pbm", HARNESS_GOLDEN_DIR);
+    file = fopen(path, "rb");
+    CHECK(file != 0);
+    if (file) {
+        CHECK_EQUAL(fread(image, 1, sizeof(image), file), sizeof(image));
+        fclose(file);
+        CHECK(memcmp(image, "P4\n84 48\n", 9) == 0);
+        CHECK_EQUAL(image[9], 0x80);
+        CHECK_EQUAL(image[9 + 8 * 11 + 1], 0x40);
+        CHECK_EQUAL(image[9 + 47 * 11 + 10], 0x10);
+    }
+
+    //display modes are applied to glass, not RAM
+    LCD_invert(1);
+    show();
+    harness_golden(chip, "pbm_inverted");
+    LCD_invert(0);
+    show();
+    CHECK(harness_golden(chip, "pbm"));
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    CHECK(chip->emulator.display == LCD_EMU_DISPLAY_NORMAL);
+    CHECK(!chip->emulator.power_down);
+
+    scenario_update();
+    scenario_text();
+    scenario_gfx();
+    scenario_decompress();
+    scenario_pbm();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,128 @@
+/**
+ *  @file test_gray.c
+ *  @brief grayscale planes - tests/images/ramp.pgm through tools/gray2lcd.py, cycled by LCD_gray_next
+ *
+ *  The Makefile generates ramp_gray.c, 3 planes of a black to white ramp, with gray2lcd.py and this test includes
+ *  it. The planes must give each pixel a level, dark in the planes that turn with x + y, darkening along the ramp.
+ *  Cycled on the LCD, RAM must equal each plane after its call, which sends no more than the changed span of each
+ *  bank, and the measured refresh rate must match the call cadence.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_gray.h"
+#include "ramp_gray.c"
+
+#define TEST_NAME                               "gray"
+
+#define GRAY_PLANES                             3
+
+static HAL_StubChip  *chip;
+static LCD_Grayscale gray;
+
+static uint8_t plane_pixel(uint8_t plane, uint8_t x, uint8_t y) {
+    return (ramp_gray[plane * LCD_BUFFER_SIZE + y / 8 * LCD_WIDTH_IN_CHUNK + x] >> (y % 8)) & 1;
+}
+
+static void scenario_planes(void) {
+    for (uint8_t x = 0; x < LCD_WIDTH_IN_PIXEL; x++) {
+        uint16_t darkness = 0;
+        for (uint8_t y = 0; y < LCD_HEIGHT_IN_PIXEL; y++) {
+            uint8_t level = 0;
+            for (uint8_t plane = 0; plane < GRAY_PLANES; plane++)
+                level += plane_pixel(plane, x, y);
+            //a pixel of level l is dark in the l planes that follow x + y
+            for (uint8_t plane = 0; plane < GRAY_PLANES; plane++)
+                if (!CHECK_EQUAL(plane_pixel(plane, x, y), (plane + 2 * GRAY_PLANES - x % GRAY_PLANES -
+                                                            y % GRAY_PLANES) % GRAY_PLANES < level))
+                    return;
+            darkness += level;
+        }
+        //ramp is black on the left and lightens linearly along x, dithering wobbles by a few pixels of a column
+        int32_t linear = GRAY_PLANES * LCD_HEIGHT_IN_PIXEL * (LCD_WIDTH_IN_PIXEL - 1 - x);
+        int32_t error  = (int32_t) darkness * (LCD_WIDTH_IN_PIXEL - 1) - linear;
+        CHECK(error >= -8 * (LCD_WIDTH_IN_PIXEL - 1) && error <= 8 * (LCD_WIDTH_IN_PIXEL - 1));
+        if (x == 0)
+            CHECK_EQUAL(darkness, GRAY_PLANES * LCD_HEIGHT_IN_PIXEL);
+        if (x == LCD_WIDTH_IN_PIXEL - 1)
+            CHECK_EQUAL(darkness, 0);
+    }
+}
+
+/**
+ * @brief most bytes a plane change may send - address and changed span of each bank
+ */
+static uint32_t changed_bytes(const uint8_t *from, const uint8_t *to) {
+    uint32_t bytes = 0;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++) {
+        int16_t low  = -1;
+        int16_t high = -1;
+        for (uint8_t x = 0; x < LCD_WIDTH_IN_CHUNK; x++)
+            if (from[bank * LCD_WIDTH_IN_CHUNK + x] != to[bank * LCD_WIDTH_IN_CHUNK + x]) {
+                low  = low < 0 ? x : low;
+                high = (int16_t) (x + 1);
+            }
+        if (low >= 0)
+            bytes += (uint32_t) (2 + high - low);
+    }
+    return bytes;
+}
+
+static void scenario_cycle(void) {
+    CHECK_EQUAL(LCD_gray_start(&gray, ramp_gray, 0), HAL_ERROR);
+    CHECK_EQUAL(LCD_gray_start(&gray, ramp_gray, GRAY_PLANES), HAL_OK);
+    CHECK(harness_ram_is(chip, ramp_gray));
+
+    HarnessTraffic total = {0};
+    for (uint8_t n = 1; n <= 2 * GRAY_PLANES; n++) {
+        const uint8_t  *from = ramp_gray + (n - 1) % GRAY_PLANES * LCD_BUFFER_SIZE;
+        const uint8_t  *to   = ramp_gray + n % GRAY_PLANES * LCD_BUFFER_SIZE;
+        HarnessTraffic mark  = harness_traffic_mark(chip);
+        CHECK_EQUAL(LCD_gray_next(&gray), HAL_OK);
+        HarnessTraffic traffic = harness_traffic_since(chip, mark);
+        if (!CHECK(harness_ram_is(chip, to)) || !CHECK(traffic.bytes <= changed_bytes(from, to)))
+            return;
+        total.transactions += traffic.transactions;
+        total.bytes += traffic.bytes;
+    }
+    HarnessTraffic plane = {total.transactions / (2 * GRAY_PLANES), total.bytes / (2 * GRAY_PLANES)};
+    harness_report(TEST_NAME, "plane_average", plane);
+    CHECK(plane.bytes < 2 + LCD_BUFFER_SIZE);
+    CHECK_EQUAL(gray.planes_shown, 2 * GRAY_PLANES);
+}
+
+static void scenario_rate(void) {
+    //a plane every 10 ms is a whole gray image 33.3 times a second
+    LCD_gray_start(&gray, ramp_gray, GRAY_PLANES);
+    for (uint16_t n = 0; n < 300; n++) {
+        if (n < 100)
+            CHECK_EQUAL(LCD_gray_refresh_mhz(&gray), 0);
+        hal_stub.tick += 10;
+        LCD_gray_next(&gray);
+    }
+    CHECK_EQUAL(LCD_gray_refresh_mhz(&gray), 100 * 1000000u / 1000 / GRAY_PLANES);
+    CHECK_EQUAL(gray.planes_missed, 0);
+
+#ifdef LCD_USE_DMA
+    //a plane still in flight is missed, not queued
+    hal_stub.dma_polls = 2;
+    CHECK_EQUAL(LCD_gray_next(&gray), HAL_OK);
+    CHECK_EQUAL(LCD_gray_next(&gray), HAL_BUSY);
+    CHECK_EQUAL(gray.planes_missed, 1);
+    hal_stub_dma_finish(&hspi1);
+    hal_stub.dma_polls = 0;
+    CHECK(harness_ram_is(chip, ramp_gray + gray.plane * LCD_BUFFER_SIZE));
+#endif
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+
+    scenario_planes();
+    scenario_cycle();
+    scenario_rate();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,136 @@
+/**
+ *  @file test_init.c
+ *  @brief non-blocking start-up - LCD_Init_async steps through the reset pulse by DWT time and never waits
+ *
+ *  Time is frozen and moved on by hand, one microsecond at a time, across a wrap of DWT->CYCCNT. Each step of the
+ *  sequence must come exactly when its time is up, the panel must see the reset pulse and no byte before it, and
+ *  whatever was drawn meanwhile must be on the glass with the first frame. The scheduler then brings up an LCD
+ *  started by LCD_Init_async on its own ticks.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_sched.h"
+
+#define TEST_NAME                               "init"
+
+//DWT cycles of a microsecond on the 72 MHz host board
+#define CYCLES_PER_US                           72
+
+static HAL_StubChip  *chip;
+static LCD_Scheduler scheduler;
+
+static uint32_t bytes_sent(void) {
+    return chip->emulator.command_bytes + chip->emulator.data_bytes;
+}
+
+static uint8_t reset_level(void) {
+    return hlcd1.reset_port->ODR & hlcd1.reset_pin ? 1 : 0;
+}
+
+static void scenario_steps(void) {
+    //a frame shown before restart is wiped by the reset pulse
+    LCD_fill_rect(0, 0, 84, 48, LCD_DRAW_SET);
+    LCD_update();
+
+    hal_stub.cycles_per_access = 0;
+    DWT->CYCCNT = 0u - 300 * CYCLES_PER_US;
+    CHECK_EQUAL(LCD_Init_async(60), HAL_OK);
+    CHECK(!LCD_is_ready());
+    CHECK(!reset_level());
+
+    //drawing and updates are fine meanwhile, nothing reaches the panel
+    uint32_t sent = bytes_sent();
+    LCD_goto_x_y_char_8x6(1, 2);
+    LCD_write_string("early");
+    LCD_draw_line(0, 47, 83, 40, LCD_DRAW_SET);
+    LCD_update();
+    CHECK_EQUAL(bytes_sent(), sent);
+
+    //microseconds at which reset goes high, low and high again, then commands and first frame go out
+    static const uint16_t expected[] = {100, 200, 1200};
+    uint16_t              seen[3]    = {0};
+    uint8_t               steps      = 0;
+    uint8_t               state      = hlcd1.init_state;
+    uint8_t               wiped      = 0;
+    uint16_t              us         = 0;
+    while (LCD_Init_step() != HAL_OK && us < 2000) {
+        if (hlcd1.init_state != state) {
+            if (steps < 3)
+                seen[steps] = us;
+            steps++;
+            state = hlcd1.init_state;
+        }
+        if (!CHECK_EQUAL(bytes_sent(), sent))
+            return;
+        if (hlcd1.init_state == LCD_INIT_SETTLE) {
+            static const uint8_t blank[LCD_BUFFER_SIZE];
+            wiped |= chip->emulator.power_down && harness_ram_is(chip, blank);
+        }
+        DWT->CYCCNT = DWT->CYCCNT + CYCLES_PER_US;
+        us++;
+    }
+    CHECK_EQUAL(steps, 3);
+    for (uint8_t i = 0; i < 3; i++)
+        CHECK_EQUAL(seen[i], expected[i]);
+    CHECK_EQUAL(us, 1210);
+    CHECK(wiped);
+    CHECK(reset_level());
+
+    //first frame carries everything drawn while in reset
+#ifdef LCD_USE_DMA
+    hal_stub_dma_finish(&hspi1);
+#endif
+    CHECK(LCD_is_ready());
+    CHECK(!chip->emulator.power_down);
+    CHECK_EQUAL(chip->emulator.display, LCD_EMU_DISPLAY_NORMAL);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    CHECK(bytes_sent() > sent);
+    hal_stub.cycles_per_access = 64;
+}
+
+static void scenario_scheduler(void) {
+    hal_stub.cycles_per_access = 0;
+    CHECK_EQUAL(LCD_Init_async(60), HAL_OK);
+    CHECK_EQUAL(LCD_scheduler_start(&scheduler, &htim2, 1000, 50, 100), HAL_OK);
+    LCD_goto_x_y_char_8x6(0, 5);
+    LCD_write_string("scheduled");
+
+    //ticks of 1 ms: reset low, reset high, reset pulse, then settled and first frame
+    uint16_t ticks = 0;
+    while (!LCD_is_ready() && ticks < 10) {
+        DWT->CYCCNT = DWT->CYCCNT + 1000 * CYCLES_PER_US;
+        hal_stub.tick++;
+        LCD_TIM_PeriodElapsedCallback(&htim2);
+        ticks++;
+    }
+    CHECK_EQUAL(ticks, 4);
+#ifdef LCD_USE_DMA
+    hal_stub_dma_finish(&hspi1);
+#endif
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+
+    //then it runs frames as usual
+    LCD_write_string("!");
+    for (uint8_t i = 0; i < 30; i++) {
+        hal_stub.tick++;
+        LCD_TIM_PeriodElapsedCallback(&htim2);
+    }
+#ifdef LCD_USE_DMA
+    hal_stub_dma_finish(&hspi1);
+#endif
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    LCD_scheduler_stop(&scheduler);
+    hal_stub.cycles_per_access = 64;
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+
+    scenario_steps();
+    scenario_scheduler();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,220 @@
+/**
+ *  @file test_layer.c
+ *  @brief layer compositing - after each composite and update, LCD RAM is the visible layers blended from blank
+ *
+ *  Random drawing, visibility changes and clears over four layers, one per blend mode, each followed by a composite
+ *  and an update. The reference blends all visible layers over the whole frame, so a span the compositor missed
+ *  or composited wrongly shows up in RAM. Scheduler ticks between a layer change and its composite must send
+ *  nothing. Layers need whole frames, so there is nothing to test in paged builds.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_layer.h"
+#include "lcd_5110_sched.h"
+
+#define TEST_NAME                               "layer"
+
+#ifndef LCD_USE_PAGED_MODE
+
+#define LAYER_COUNT                             4
+
+static HAL_StubChip   *chip;
+static uint8_t        pixels[LAYER_COUNT][LCD_BUFFER_SIZE];
+static LCD_Layer      layers[LAYER_COUNT];
+static LCD_Compositor screen;
+static LCD_Scheduler  scheduler;
+
+static void show(void) {
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+}
+
+/**
+ * @brief blends all visible layers over a whole blank frame
+ * @param frame LCD_BUFFER_SIZE bytes
+ */
+static void reference(uint8_t *frame) {
+    memset(frame, 0, LCD_BUFFER_SIZE);
+    for (uint8_t n = 0; n < LAYER_COUNT; n++) {
+        if (!layers[n].visible)
+            continue;
+        for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+            switch (layers[n].blend) {
+                case LCD_BLEND_COPY:
+                    frame[i] = layers[n].pixels[i];
+                    break;
+                case LCD_BLEND_OR:
+                    frame[i] |= layers[n].pixels[i];
+                    break;
+                case LCD_BLEND_AND:
+                    frame[i] &= layers[n].pixels[i];
+                    break;
+                default:
+                    frame[i] ^= layers[n].pixels[i];
+                    break;
+            }
+    }
+}
+
+/**
+ * @brief composites, updates and compares RAM with the reference
+ * @return 1 if they match
+ */
+static int check_composite(void) {
+    static uint8_t expected[LCD_BUFFER_SIZE];
+    LCD_composite(&screen);
+    show();
+    reference(expected);
+    return CHECK(harness_ram_is(chip, expected));
+}
+
+static void draw_random(void) {
+    int16_t x = (int16_t) (harness_random() % 90) - 3;
+    int16_t y = (int16_t) (harness_random() % 52) - 2;
+    switch (harness_random() % 4) {
+        case 0:
+            LCD_fill_rect(x, y, (int16_t) (1 + harness_random() % 30), (int16_t) (1 + harness_random() % 20),
+                          (LCD_DrawMode) (harness_random() % 3));
+            break;
+        case 1:
+            LCD_draw_line(x, y, (int16_t) (harness_random() % 84), (int16_t) (harness_random() % 48),
+                          LCD_DRAW_XOR);
+            break;
+        case 2:
+            LCD_draw_string(x, y, "Ab1", LCD_DRAW_COPY);
+            break;
+        default:
+            LCD_draw_pixel(x, y, LCD_DRAW_SET);
+            break;
+    }
+}
+
+static void scenario_random(void) {
+    harness_seed(0x1a7e);
+    for (uint16_t n = 0; n < 2000; n++) {
+        uint8_t index = (uint8_t) (harness_random() % LAYER_COUNT);
+        switch (harness_random() % 8) {
+            case 0:
+                LCD_layer_set_visible(&screen, index, !layers[index].visible);
+                break;
+            case 1:
+                LCD_layer_clear(&screen, index);
+                break;
+            default:
+                LCD_layer_begin(&screen, index);
+                for (uint8_t k = (uint8_t) (1 + harness_random() % 3); k; k--)
+                    draw_random();
+                //a begin of the next operation may end this one
+                if (harness_random() % 2)
+                    LCD_layer_end(&screen);
+                break;
+        }
+        if (harness_random() % 3 == 0 && !check_composite())
+            return;
+    }
+    check_composite();
+}
+
+static void scenario_frame_is_output(void) {
+    //drawing into the frame itself is overwritten where the layers are composited, kept elsewhere
+    for (uint8_t n = 0; n < LAYER_COUNT; n++) {
+        LCD_layer_clear(&screen, n);
+        LCD_layer_set_visible(&screen, n, n != 2);
+    }
+    check_composite();
+    LCD_fill_rect(0, 0, 84, 48, LCD_DRAW_SET);
+    LCD_layer_begin(&screen, 1);
+    LCD_draw_pixel(10, 10, LCD_DRAW_SET);
+    LCD_layer_end(&screen);
+    LCD_composite(&screen);
+    CHECK(!LCD_get_pixel(0, 0));
+    CHECK(LCD_get_pixel(10, 10));
+    CHECK(!LCD_get_pixel(11, 10));
+
+    //a blinking cursor only recomposites and sends its extent
+    LCD_layer_begin(&screen, 3);
+    LCD_fill_rect(30, 16, 6, 8, LCD_DRAW_SET);
+    LCD_layer_end(&screen);
+    check_composite();
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_layer_set_visible(&screen, 3, 0);
+    check_composite();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    CHECK(traffic.bytes <= 6 + 8);
+}
+
+/**
+ * @brief runs scheduler ticks 1 ms apart, DMA chains end within their tick
+ * @param ticks ticks
+ */
+static void run_ticks(uint16_t ticks) {
+    while (ticks--) {
+        hal_stub.tick++;
+        LCD_TIM_PeriodElapsedCallback(&htim2);
+#ifdef LCD_USE_DMA
+        hal_stub_dma_finish(&hspi1);
+#endif
+    }
+}
+
+static void scenario_scheduler(void) {
+    static uint8_t expected[LCD_BUFFER_SIZE];
+    CHECK_EQUAL(LCD_scheduler_start(&scheduler, &htim2, 1000, 50, 100), HAL_OK);
+    run_ticks(10);
+
+    //frame points at the layer between begin and end, and the marks are not composited until composite - ticks
+    //past max latency in both must not send a byte
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_layer_begin(&screen, 1);
+    LCD_fill_rect(50, 20, 20, 12, LCD_DRAW_SET);
+    run_ticks(200);
+    LCD_layer_end(&screen);
+    run_ticks(200);
+    LCD_layer_set_visible(&screen, 3, 1);
+    LCD_layer_clear(&screen, 0);
+    run_ticks(200);
+    CHECK_EQUAL(harness_traffic_since(chip, mark).bytes, 0);
+    CHECK_EQUAL(scheduler.frames, 0);
+
+    //composited, the next tick sends it all
+    LCD_composite(&screen);
+    run_ticks(1);
+    reference(expected);
+    CHECK(harness_ram_is(chip, expected));
+    CHECK_EQUAL(scheduler.frames, 1);
+    CHECK_EQUAL(scheduler.late_frames, 1);
+    LCD_scheduler_stop(&scheduler);
+}
+
+int main(void) {
+    static const LCD_BlendMode blends[LAYER_COUNT] = {LCD_BLEND_COPY, LCD_BLEND_OR, LCD_BLEND_AND, LCD_BLEND_XOR};
+    chip = harness_start(&hlcd1);
+    for (uint8_t n = 0; n < LAYER_COUNT; n++)
+        LCD_layer_init(&layers[n], pixels[n], blends[n]);
+    //a mask layer of all off pixels would hide everything below it
+    memset(pixels[2], 0xff, LCD_BUFFER_SIZE);
+    LCD_compositor_init(&screen, layers, LAYER_COUNT);
+    check_composite();
+
+    scenario_random();
+    scenario_frame_is_output();
+    scenario_scheduler();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
+
+#else
+
+int main(void) {
+    return harness_done(TEST_NAME);
+}
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ *  @file test_paged.c
+ *  @brief paged mode - a screen drawn bank by bank by the draw callback shows what full-buffer builds show
+ *
+ *  Built in the paged build only, which holds one bank instead of a frame. Each scenario draws in its callback what
+ *  test_golden draws into the full buffer, and the glass is compared with the same golden frames, so paged and
+ *  full-buffer output are one set of images. Every update sends the whole frame as one horizontal run.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_text.h"
+
+#define TEST_NAME                               "paged"
+
+//one address command pair and every byte of the frame
+#define PAGED_FRAME_BYTES                       (2 + LCD_BUFFER_SIZE)
+
+static HAL_StubChip *chip;
+static uint8_t      banks_drawn;
+static uint8_t      next_bank;
+static uint8_t      out_of_order;
+
+/**
+ * @brief counts a callback and checks banks come in order, each with only its page in buffer
+ */
+static void count_bank(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    out_of_order |= bank != next_bank || hlcd->page != bank;
+    next_bank = (uint8_t) ((bank + 1) % LCD_HEIGHT_IN_CHUNK);
+    banks_drawn++;
+}
+
+static void draw_text(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    count_bank(hlcd, bank);
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_string("Nokia 5110");
+    LCD_goto_x_y_char_8x6(2, 1);
+    LCD_write_string("0123456789ABCD");
+    LCD_goto_x_y_char_8x6(0, 3);
+    LCD_write_char_8x6('~');
+    LCD_write_char_8x6(0x7f);
+    LCD_draw_string(3, 37, "y=37", LCD_DRAW_SET);
+    LCD_draw_text(&lcd_font_en_8x5, 40, 28, "\xc3\xa9t\xc3\xa9", LCD_DRAW_COPY);
+}
+
+static void draw_gfx(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    static const uint8_t sprite[] = {
+            0x3c, 0x42, 0x81, 0xa5, 0x81, 0x99, 0x42, 0x3c,
+            0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00};
+
+    count_bank(hlcd, bank);
+    LCD_draw_rect(0, 0, 84, 48, LCD_DRAW_SET);
+    LCD_fill_rect(10, 13, 30, 5, LCD_DRAW_XOR);
+    LCD_fill_rect(20, 5, 10, 30, LCD_DRAW_XOR);
+    LCD_draw_line(0, 47, 83, 0, LCD_DRAW_SET);
+    LCD_draw_line(-10, 5, 100, 30, LCD_DRAW_XOR);
+    LCD_draw_hline(50, 40, 30, LCD_DRAW_SET);
+    LCD_draw_vline(70, -5, 20, LCD_DRAW_SET);
+    LCD_draw_bitmap(60, 21, sprite, 8, 9, LCD_DRAW_COPY);
+    LCD_draw_bitmap(78, 43, sprite, 8, 9, LCD_DRAW_XOR);
+    LCD_draw_pixel(2, 2, LCD_DRAW_SET);
+    LCD_draw_pixel(0, 0, LCD_DRAW_CLEAR);
+}
+
+static uint8_t  icon[16 * 2];
+static uint8_t  wide[100 * 3];
+static uint8_t  icon_compressed[sizeof(icon) * 2];
+static uint8_t  wide_compressed[sizeof(wide) * 2];
+static uint32_t icon_length;
+static uint32_t wide_length;
+static uint8_t  decompress_failed;
+
+static void draw_decompress(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    count_bank(hlcd, bank);
+    decompress_failed |= LCD_decompress_image(icon_compressed, icon_length, 4, 0) != HAL_OK;
+    decompress_failed |= LCD_decompress_image(icon_compressed, icon_length, 80, 5) != HAL_OK;
+    decompress_failed |= LCD_decompress_image(wide_compressed, wide_length, 0, 2) != HAL_OK;
+    //truncated image keeps its decoded part in every bank
+    decompress_failed |= LCD_decompress_image(icon_compressed, icon_length - 9, 30, 0) != HAL_ERROR;
+}
+
+static void draw_pbm(LCD_HandleTypeDef *hlcd, uint8_t bank) {
+    count_bank(hlcd, bank);
+    LCD_draw_pixel(0, 0, LCD_DRAW_SET);
+    LCD_draw_pixel(83, 47, LCD_DRAW_SET);
+    LCD_draw_pixel(9, 8, LCD_DRAW_SET);
+}
+
+/**
+ * @brief updates with a callback and compares glass with a golden frame of test_golden
+ * @param draw draw callback
+ * @param name golden frame
+ */
+static void show(void (*draw)(LCD_HandleTypeDef *hlcd, uint8_t bank), const char *name) {
+    LCD_set_draw_callback(draw);
+    banks_drawn  = 0;
+    out_of_order = 0;
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_update();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    harness_report(TEST_NAME, name, traffic);
+    CHECK_EQUAL(banks_drawn, LCD_HEIGHT_IN_CHUNK);
+    CHECK(!out_of_order);
+    CHECK_EQUAL(traffic.bytes, PAGED_FRAME_BYTES);
+    CHECK(!chip->emulator.vertical);
+    CHECK(harness_golden(chip, name));
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    for (uint8_t i = 0; i < sizeof(icon); i++)
+        icon[i] = (uint8_t) (i % 16 < 4 || i % 16 > 11 ? 0 : 0x18 << (i / 16));
+    for (uint16_t i = 0; i < sizeof(wide); i++)
+        wide[i] = (uint8_t) (i % 7 ? 0xff : (i % 100) | 0x81);
+    icon_length = harness_encode(icon, 16, 2, 0, icon_compressed);
+    wide_length = harness_encode(wide, 100, 3, 1, wide_compressed);
+
+    show(draw_text, "text");
+    show(draw_gfx, "gfx");
+    show(draw_decompress, "decompress");
+    CHECK(!decompress_failed);
+    show(draw_pbm, "pbm");
+    //same callback again redraws the same screen
+    show(draw_pbm, "pbm");
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
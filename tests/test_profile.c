@@ -0,0 +1,155 @@
+/**
+ *  @file test_profile.c
+ *  @brief profiling counters - probes, per-update sizes and LCD_Stat, counted from a host cycle source
+ *
+ *  Built in the profile build only, where LCD_PROFILE_CYCLES() is host_cycles() of the host board. Each read of it
+ *  moves on by a fixed step, so a probe around code reading no cycles itself measures exactly one step, and an
+ *  update measures one step plus two per blocking transaction it sends.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_text.h"
+
+#define TEST_NAME                               "profile"
+
+//host cycles between two reads
+#define PROFILE_STEP                            7
+
+static HAL_StubChip *chip;
+
+/**
+ * @brief checks a stat holding values all equal to one value
+ * @param stat stat
+ * @param count values added
+ * @param value each value
+ */
+static void check_stat(const LCD_Stat *stat, uint32_t count, uint32_t value) {
+    CHECK_EQUAL(stat->count, count);
+    CHECK_EQUAL(stat->min, count ? value : 0);
+    CHECK_EQUAL(stat->max, count ? value : 0);
+    CHECK_EQUAL(stat->total, (uint64_t) count * value);
+}
+
+static void scenario_stat(void) {
+    LCD_Stat stat = {0};
+    CHECK_EQUAL(LCD_stat_average(&stat), 0);
+    LCD_stat_add(&stat, 9);
+    LCD_stat_add(&stat, 3);
+    LCD_stat_add(&stat, 7);
+    CHECK_EQUAL(stat.count, 3);
+    CHECK_EQUAL(stat.min, 3);
+    CHECK_EQUAL(stat.max, 9);
+    CHECK_EQUAL(stat.total, 19);
+    CHECK_EQUAL(LCD_stat_average(&stat), 6);
+    //a first value of 0 is a minimum too
+    LCD_Stat zero = {0};
+    LCD_stat_add(&zero, 0);
+    LCD_stat_add(&zero, 5);
+    CHECK_EQUAL(zero.min, 0);
+}
+
+static void scenario_probes(void) {
+    LCD_Profile profile;
+    LCD_reset_profile();
+    hal_stub.host_cycles_per_read = PROFILE_STEP;
+
+    //each glyph function is one probe
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_char_8x6('A');
+    LCD_draw_char(10, 12, 'B', LCD_DRAW_SET);
+    LCD_draw_string(30, 20, "cd", LCD_DRAW_XOR);
+    LCD_get_profile(&profile);
+    check_stat(&profile.cycles[LCD_PROBE_GLYPH], 4, PROFILE_STEP);
+    check_stat(&profile.cycles[LCD_PROBE_UPDATE], 0, 0);
+
+    uint16_t dirty = 0;
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        if (hlcd1.dirty_low[bank] < hlcd1.dirty_high[bank])
+            dirty += hlcd1.dirty_high[bank] - hlcd1.dirty_low[bank];
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_update();
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+
+    //update holds its blocking sends, each a probe of its own
+    LCD_get_profile(&profile);
+    check_stat(&profile.cycles[LCD_PROBE_SPI_SEND], traffic.transactions, PROFILE_STEP);
+    check_stat(&profile.cycles[LCD_PROBE_UPDATE], 1, PROFILE_STEP * (1 + 2 * traffic.transactions));
+    check_stat(&profile.update_bytes, 1, traffic.bytes);
+    check_stat(&profile.update_transactions, 1, traffic.transactions);
+    check_stat(&profile.dirty_bytes, 1, dirty);
+    CHECK_EQUAL(profile.bytes, traffic.bytes);
+    CHECK_EQUAL(profile.transactions, traffic.transactions);
+#ifdef LCD_USE_BUS_STATS
+    LCD_BusStats stats;
+    LCD_get_bus_stats(&stats);
+    CHECK_EQUAL(stats.last_frame_bytes, traffic.bytes);
+    CHECK_EQUAL(stats.last_frame_transactions, traffic.transactions);
+#endif
+
+    //an update with nothing to send is measured but adds no sizes
+    LCD_update();
+    LCD_get_profile(&profile);
+    CHECK_EQUAL(profile.cycles[LCD_PROBE_UPDATE].count, 2);
+    CHECK_EQUAL(profile.cycles[LCD_PROBE_UPDATE].min, PROFILE_STEP);
+    CHECK_EQUAL(profile.update_bytes.count, 1);
+    CHECK_EQUAL(profile.dirty_bytes.count, 1);
+}
+
+static void scenario_images(void) {
+    static const uint8_t image[3 * 2] = {0x18, 0x3c, 0x18, 0x81, 0x00, 0x81};
+    uint8_t              compressed[32];
+    uint32_t             length = harness_encode(image, 3, 2, 0, compressed);
+    LCD_Profile          profile;
+    LCD_reset_profile();
+
+    CHECK_EQUAL(LCD_decompress_image(compressed, length, 40, 2), HAL_OK);
+    decompress_into_buffer(compressed, LCD_get_frame(), 50, 3);
+    LCD_get_profile(&profile);
+    check_stat(&profile.cycles[LCD_PROBE_DECOMPRESS], 2, PROFILE_STEP);
+    //a malformed image is measured as well
+    CHECK_EQUAL(LCD_decompress_image(compressed, 2, 40, 2), HAL_ERROR);
+    LCD_get_profile(&profile);
+    CHECK_EQUAL(profile.cycles[LCD_PROBE_DECOMPRESS].count, 3);
+
+    //a streamed image is no update and no decompression, only its sends are counted
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    CHECK_EQUAL(LCD_stream_compressed_image(compressed, length, 10, 0), HAL_OK);
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    LCD_get_profile(&profile);
+    CHECK_EQUAL(profile.cycles[LCD_PROBE_UPDATE].count, 0);
+    CHECK_EQUAL(profile.cycles[LCD_PROBE_DECOMPRESS].count, 3);
+    check_stat(&profile.cycles[LCD_PROBE_SPI_SEND], traffic.transactions, PROFILE_STEP);
+    CHECK_EQUAL(profile.update_bytes.count, 0);
+    CHECK_EQUAL(profile.bytes, traffic.bytes);
+}
+
+static void scenario_reset(void) {
+    LCD_Profile profile;
+    LCD_Profile zero;
+    LCD_reset_profile();
+    LCD_get_profile(&profile);
+    memset(&zero, 0, sizeof(zero));
+    CHECK(memcmp(&profile, &zero, sizeof(zero)) == 0);
+
+    //a frozen cycle source measures nothing but still counts calls
+    hal_stub.host_cycles_per_read = 0;
+    LCD_write_char_8x6('z');
+    LCD_get_profile(&profile);
+    check_stat(&profile.cycles[LCD_PROBE_GLYPH], 1, 0);
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    CHECK(hal_stub.host_cycles_reads > 0);
+
+    scenario_stat();
+    scenario_probes();
+    scenario_images();
+    scenario_reset();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,180 @@
+/**
+ *  @file test_queue_stress.c
+ *  @brief draw queue under real concurrency - producer threads against one render owner
+ *
+ *  Built in the queue build only, where LCD_QUEUE_CLAIM and LCD_QUEUE_BARRIER are the GCC __sync builtins as
+ *  userconf.h suggests for hosts without LDREX/STREX. Every producer thread owns one text row and writes a counter
+ *  into it over and over, retrying while the queue is full. The main thread is the render owner: after each drain
+ *  it reads the rows back and checks that each shows its producer's tag with a counter that never goes back - a
+ *  torn, lost or reordered slot shows up as a wrong glyph or a counter going backwards.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_queue.h"
+
+#define TEST_NAME                               "queue_stress"
+
+//counters written by each producer
+#define STRESS_ROUNDS                           20000
+
+//characters of a row, "A:00042"
+#define STRESS_ROW_CHARS                        7
+
+//empty drains in a row after which the queue is taken as stuck - producers give up instead of hanging the test
+#define STRESS_STALL_DRAINS                     1000000
+
+typedef struct {
+    uint8_t  producer;
+    uint32_t busy;//HAL_BUSY answers, each a dropped command
+} StressProducer;
+
+static LCD_DrawQueue     queue;
+static HAL_StubChip      *chip;
+static StressProducer    producers[LCD_QUEUE_MAX_PRODUCERS];
+static volatile uint32_t running;
+static volatile uint8_t  stalled;
+static uint8_t           glyphs['~' - ' ' + 1][6];
+
+/**
+ * @brief queues a command until it fits, as a task which must not lose it would - or until render owner finds the
+ *        queue stuck
+ */
+#define STRESS_RETRY(state, call)               do { \
+                                                    while ((call) == HAL_BUSY && !stalled) { \
+                                                        (state)->busy++; \
+                                                        sched_yield(); \
+                                                    } \
+                                                } while (0)
+
+static void *produce(void *argument) {
+    StressProducer *state = argument;
+    char           row[STRESS_ROW_CHARS + 1];
+    for (uint32_t n = 0; n < STRESS_ROUNDS; n++) {
+        snprintf(row, sizeof(row), "%c:%05lu", 'A' + state->producer, (unsigned long) n);
+        STRESS_RETRY(state, LCD_queue_goto(&queue, state->producer, 0, state->producer));
+        STRESS_RETRY(state, LCD_queue_string(&queue, state->producer, row));
+    }
+    __sync_fetch_and_sub(&running, 1);
+    return 0;
+}
+
+/**
+ * @brief reads a glyph back from the frame
+ * @param cell 6 bytes of a char cell
+ * @return char, 0 if cell holds no glyph of the font
+ */
+static char read_glyph(const uint8_t *cell) {
+    for (uint8_t i = 0; i <= '~' - ' '; i++)
+        if (memcmp(glyphs[i], cell, 6) == 0)
+            return (char) (' ' + i);
+    return 0;
+}
+
+/**
+ * @brief checks row of a producer
+ * @param producer producer
+ * @param last counter last seen in row, updated
+ * @return 1 if row is still blank or shows producer's tag and a counter not below last
+ */
+static int check_row(uint8_t producer, long *last) {
+    const uint8_t *row = LCD_get_frame() + producer * LCD_WIDTH_IN_CHUNK;
+    char          text[STRESS_ROW_CHARS + 1];
+    uint8_t       blank = 1;
+    for (uint8_t i = 0; i < STRESS_ROW_CHARS * 6; i++)
+        blank &= row[i] == 0;
+    if (blank)
+        return *last < 0;
+
+    for (uint8_t i = 0; i < STRESS_ROW_CHARS; i++)
+        text[i] = read_glyph(row + i * 6);
+    text[STRESS_ROW_CHARS] = 0;
+    long counter = -1;
+    char tag     = 0;
+    if (sscanf(text, "%c:%5ld", &tag, &counter) != 2 || tag != 'A' + producer) {
+        printf("row %u: \"%s\"\n", producer, text);
+        return 0;
+    }
+    if (counter < *last || counter >= STRESS_ROUNDS) {
+        printf("row %u: counter %ld after %ld\n", producer, counter, *last);
+        return 0;
+    }
+    *last = counter;
+    return 1;
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    //font as the driver draws it, to read rows back
+    for (uint8_t i = 0; i <= '~' - ' '; i++) {
+        LCD_goto_x_y_char_8x6(0, 0);
+        LCD_write_char_8x6((uint8_t) (' ' + i));
+        memcpy(glyphs[i], LCD_get_frame(), 6);
+    }
+    LCD_clear();
+    LCD_update();
+    LCD_queue_init(&queue);
+
+    pthread_t threads[LCD_QUEUE_MAX_PRODUCERS];
+    running = LCD_QUEUE_MAX_PRODUCERS;
+    for (uint8_t p = 0; p < LCD_QUEUE_MAX_PRODUCERS; p++) {
+        producers[p].producer = p;
+        CHECK_EQUAL(pthread_create(&threads[p], 0, produce, &producers[p]), 0);
+    }
+
+    long     last[LCD_QUEUE_MAX_PRODUCERS];
+    uint32_t drawn  = 0;
+    uint32_t drains = 0;
+    uint32_t idle   = 0;
+    uint8_t  failed = 0;
+    for (uint8_t p = 0; p < LCD_QUEUE_MAX_PRODUCERS; p++)
+        last[p] = -1;
+    for (;;) {
+        uint32_t left = running;
+        //every few drains also an update, as a render task would
+        uint16_t count = ++drains % 16 ? LCD_queue_drain(&queue) : LCD_queue_render(&queue);
+        drawn += count;
+        for (uint8_t p = 0; p < LCD_QUEUE_MAX_PRODUCERS && count && !failed; p++)
+            failed = !check_row(p, &last[p]);
+        //a drain after all producers ended sees everything they queued
+        if (left == 0 || failed)
+            break;
+        idle = count ? 0 : idle + 1;
+        if (idle == STRESS_STALL_DRAINS) {
+            failed = 1;
+            printf("queue stuck at position %lu\n", (unsigned long) queue.dequeue_position);
+        }
+        if (!count)
+            sched_yield();
+    }
+    //producers still retrying give up
+    stalled = 1;
+    CHECK(!failed);
+    for (uint8_t p = 0; p < LCD_QUEUE_MAX_PRODUCERS; p++)
+        pthread_join(threads[p], 0);
+
+    uint32_t enqueued = 0;
+    uint32_t dropped  = 0;
+    for (uint8_t p = 0; p < LCD_QUEUE_MAX_PRODUCERS; p++) {
+        LCD_QueueStats stats;
+        LCD_queue_get_stats(&queue, p, &stats);
+        CHECK_EQUAL(stats.enqueued, 2 * STRESS_ROUNDS);
+        CHECK_EQUAL(stats.dropped, producers[p].busy);
+        CHECK_EQUAL(last[p], STRESS_ROUNDS - 1);
+        enqueued += stats.enqueued;
+        dropped += stats.dropped;
+    }
+    CHECK_EQUAL(drawn, enqueued);
+    CHECK(queue.high_water <= LCD_QUEUE_LENGTH);
+    LCD_update();
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    printf("stress %s: %lu commands of %u producers in %lu drains, %lu dropped on a full queue, high water %u\n",
+           TEST_NAME, (unsigned long) enqueued, LCD_QUEUE_MAX_PRODUCERS, (unsigned long) drains,
+           (unsigned long) dropped, queue.high_water);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,114 @@
+/**
+ *  @file test_sched.c
+ *  @brief timer scheduler - frames of settled drawing, and draws and requests made while a frame goes out
+ *
+ *  The transmit hook of the host board stands for an interrupt above the timer priority: it draws into the frame
+ *  and asks for a frame while the tick is sending. Neither may be lost.
+ */
+
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+#include "lcd_5110_sched.h"
+
+#define TEST_NAME                               "sched"
+
+static HAL_StubChip  *chip;
+static LCD_Scheduler scheduler;
+static uint8_t       interrupt_armed;
+static uint8_t       masked_while_sending;
+
+/**
+ * @brief runs timer ticks of 1 ms
+ * @param count ticks
+ * @return frames sent during them
+ */
+static uint32_t ticks(uint16_t count) {
+    uint32_t frames = scheduler.frames;
+    while (count--) {
+        hal_stub.tick++;
+        LCD_TIM_PeriodElapsedCallback(&htim2);
+    }
+    return scheduler.frames - frames;
+}
+
+/**
+ * @brief higher priority interrupt, once on first data sent after being armed
+ */
+static void on_transmit(SPI_HandleTypeDef *hspi, uint8_t is_data, const uint8_t *data, uint16_t length) {
+    if (hal_stub_primask)
+        masked_while_sending = 1;
+    if (!interrupt_armed || !is_data)
+        return;
+    interrupt_armed = 0;
+    //a pixel inside the run just sent, and one far from it
+    LCD_draw_pixel(2, 3, LCD_DRAW_XOR);
+    LCD_draw_pixel(80, 44, LCD_DRAW_SET);
+    LCD_scheduler_request(&scheduler);
+}
+
+static void scenario_settle(void) {
+    CHECK_EQUAL(LCD_scheduler_start(&scheduler, &htim2, 1000, 50, 100), HAL_OK);
+    CHECK(htim2.running);
+    ticks(30);
+
+    //a burst of draws goes out as one frame once it settled
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_string("tick");
+    CHECK_EQUAL(ticks(1), 0);
+    LCD_write_string("ed");
+    CHECK_EQUAL(ticks(5), 1);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    CHECK_EQUAL(ticks(50), 0);
+
+    //locked buffer is held back until max latency
+    LCD_scheduler_lock(&scheduler);
+    LCD_write_string("!");
+    CHECK_EQUAL(ticks(50), 0);
+    LCD_scheduler_unlock(&scheduler);
+    CHECK_EQUAL(ticks(5), 1);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+static void scenario_preempted(void) {
+    LCD_goto_x_y_char_8x6(0, 0);
+    LCD_write_string("race");
+    interrupt_armed = 1;
+    CHECK_EQUAL(ticks(25), 1);
+    CHECK(!interrupt_armed);
+
+    //both draws and the request wait for next frame
+    CHECK(scheduler.requested);
+    CHECK(hlcd1.flag.area_changed);
+    CHECK(!harness_ram_is(chip, LCD_get_frame()));
+    CHECK_EQUAL(hal_stub_primask, 0);
+
+    CHECK_EQUAL(ticks(25), 1);
+    CHECK(!scheduler.requested);
+    CHECK(!hlcd1.flag.area_changed);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+    CHECK(LCD_emu_pixel(&chip->emulator, 80, 44));
+    CHECK_EQUAL(ticks(50), 0);
+}
+
+static void scenario_request(void) {
+    //a request alone sends one frame, even with nothing dirty
+    LCD_scheduler_request(&scheduler);
+    CHECK_EQUAL(ticks(25), 1);
+    CHECK(!scheduler.requested);
+    CHECK_EQUAL(ticks(50), 0);
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    hal_stub.on_transmit = on_transmit;
+
+    scenario_settle();
+    scenario_preempted();
+    scenario_request();
+    LCD_scheduler_stop(&scheduler);
+    CHECK(!htim2.running);
+    CHECK(!masked_while_sending);
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
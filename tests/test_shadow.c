@@ -0,0 +1,126 @@
+/**
+ *  @file test_shadow.c
+ *  @brief shadow buffer - bytes saved on recorded sequences of an application redrawing whole screens every tick
+ *
+ *  Built in LCD_USE_SHADOW_BUFFER builds only. Each sequence clears and redraws the whole screen per frame, like
+ *  the applications the option is meant for, and is played twice: once as usual, and once with shadow_valid
+ *  cleared before every update, which sends each frame whole as a driver without the shadow buffer does. Both must
+ *  show the same on glass; the report gives the bytes of each run and what the shadow buffer saved.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+
+#define TEST_NAME                               "shadow"
+
+typedef struct {
+    const char *name;
+    uint16_t   frames;
+    void       (*frame)(uint16_t n);//redraws whole screen for frame n
+    uint8_t    min_saved_percent;
+} ShadowSequence;
+
+static HAL_StubChip *chip;
+
+static void show(void) {
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+static void clock_frame(uint16_t n) {
+    //a clock ticking once a second, date and alarm lines staying
+    char     line[16];
+    uint32_t seconds = 12 * 3600 + 34 * 60 + 50 + n;
+    LCD_clear();
+    snprintf(line, sizeof(line), "%02lu:%02lu:%02lu", (unsigned long) (seconds / 3600 % 24),
+             (unsigned long) (seconds / 60 % 60), (unsigned long) (seconds % 60));
+    LCD_draw_string(18, 12, line, LCD_DRAW_SET);
+    LCD_draw_string(12, 28, "Sat 17 Oct", LCD_DRAW_SET);
+    LCD_draw_string(0, 40, "alarm 07:00", LCD_DRAW_SET);
+    LCD_draw_hline(0, 24, 84, LCD_DRAW_SET);
+}
+
+static void log_frame(uint16_t n) {
+    //last lines of a log, a new line every other tick scrolls all of them
+    char line[16];
+    LCD_clear();
+    for (uint8_t row = 0; row < LCD_HEIGHT_IN_CHUNK; row++) {
+        int32_t entry = (int32_t) (n / 2) + row - LCD_HEIGHT_IN_CHUNK + 1;
+        if (entry < 0)
+            continue;
+        snprintf(line, sizeof(line), "%03ld %s", (long) entry, entry % 3 ? "ok" : "retry");
+        LCD_draw_string(0, (int16_t) (row * 8), line, LCD_DRAW_SET);
+    }
+}
+
+static void progress_frame(uint16_t n) {
+    //a firmware update, bar and percentage move, title and frame stay
+    char    line[8];
+    uint8_t percent = (uint8_t) (n * 100 / 79);
+    LCD_clear();
+    LCD_draw_string(0, 0, "updating", LCD_DRAW_SET);
+    LCD_draw_rect(2, 20, 80, 10, LCD_DRAW_SET);
+    LCD_fill_rect(4, 22, (int16_t) (percent * 76 / 100), 6, LCD_DRAW_SET);
+    snprintf(line, sizeof(line), "%u%%", percent);
+    LCD_draw_string(30, 36, line, LCD_DRAW_SET);
+}
+
+static const ShadowSequence sequences[] = {
+        {"clock",    60, clock_frame,    90},
+        {"log",      60, log_frame,      75},
+        {"progress", 80, progress_frame, 90},
+};
+
+/**
+ * @brief plays a sequence on a fresh panel
+ * @param sequence sequence
+ * @param whole 1 to send every frame whole
+ * @return traffic of all frames
+ */
+static HarnessTraffic play(const ShadowSequence *sequence, uint8_t whole) {
+    chip = harness_start(&hlcd1);
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    for (uint16_t n = 0; n < sequence->frames; n++) {
+        sequence->frame(n);
+        if (whole)
+            hlcd1.shadow_valid = 0;
+        show();
+    }
+    return harness_traffic_since(chip, mark);
+}
+
+static void scenario_sequence(const ShadowSequence *sequence) {
+    char           name[32];
+    HarnessTraffic whole  = play(sequence, 1);
+    static uint8_t last[LCD_BUFFER_SIZE];
+    memcpy(last, LCD_get_frame(), LCD_BUFFER_SIZE);
+    HarnessTraffic diffed = play(sequence, 0);
+    CHECK(harness_ram_is(chip, last));
+
+    snprintf(name, sizeof(name), "%s_whole", sequence->name);
+    harness_report(TEST_NAME, name, whole);
+    snprintf(name, sizeof(name), "%s_shadow", sequence->name);
+    harness_report(TEST_NAME, name, diffed);
+    printf("saved %s/%s: %lu of %lu bytes, %lu per frame\n", TEST_NAME, sequence->name,
+           (unsigned long) (whole.bytes - diffed.bytes), (unsigned long) whole.bytes,
+           (unsigned long) ((whole.bytes - diffed.bytes) / sequence->frames));
+
+    CHECK(diffed.bytes <= whole.bytes);
+    CHECK((whole.bytes - diffed.bytes) * 100 >= (uint32_t) sequence->min_saved_percent * whole.bytes);
+}
+
+int main(void) {
+    for (uint8_t i = 0; i < sizeof(sequences) / sizeof(sequences[0]); i++)
+        scenario_sequence(&sequences[i]);
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,120 @@
+/**
+ *  @file test_shared_bus.c
+ *  @brief two panels on one SPI - a panel waits for a chain of the other, busy and failed transfers
+ *
+ *  DMA transfers end only after a few polls of HAL_SPI_GetState here, so a chain of one panel is still running
+ *  when the other one updates. The host board counts transactions seen by two selected chips as CE conflicts.
+ */
+
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+
+#define TEST_NAME                               "shared_bus"
+
+static LCD_HandleTypeDef hlcd_a = LCD_HANDLE_INIT(&hspi1, LCD_DC_GPIO_Port, LCD_DC_Pin, LCD_RESET_GPIO_Port,
+                                                  LCD_RESET_Pin, LCD_CE_GPIO_Port, LCD_CE_Pin);
+static LCD_HandleTypeDef hlcd_b = LCD_HANDLE_INIT(&hspi1, LCD2_DC_GPIO_Port, LCD2_DC_Pin, LCD2_RESET_GPIO_Port,
+                                                  LCD2_RESET_Pin, LCD2_CE_GPIO_Port, LCD2_CE_Pin);
+static HAL_StubChip      *chip_a;
+static HAL_StubChip      *chip_b;
+static uint8_t           fail_next_data;
+
+/**
+ * @brief lets the command transaction of an update through and fails the data after it
+ */
+static void on_transmit(SPI_HandleTypeDef *hspi, uint8_t is_data, const uint8_t *data, uint16_t length) {
+    if (fail_next_data && !is_data) {
+        fail_next_data        = 0;
+        hal_stub.fail_count  = 1;
+        hal_stub.fail_status = HAL_ERROR;
+    }
+}
+
+static void scenario_interleaved(void) {
+    LCDx_draw_string(&hlcd_a, 0, 0, "panel A", LCD_DRAW_SET);
+    LCDx_draw_string(&hlcd_b, 0, 0, "panel B", LCD_DRAW_SET);
+#ifdef LCD_USE_DMA
+    hal_stub.dma_polls = 4;
+    CHECK_EQUAL(LCDx_update_async(&hlcd_a), HAL_OK);
+    CHECK(hal_stub_dma_pending(&hspi1));
+    //chain of A keeps its CE low - B may neither start a chain nor select itself until it ends
+    CHECK_EQUAL(LCDx_update_async(&hlcd_b), HAL_BUSY);
+    LCDx_update(&hlcd_b);
+    CHECK(!LCDx_is_busy(&hlcd_a));
+    CHECK(harness_ram_is(chip_a, hlcd_a.frame));
+    CHECK(harness_ram_is(chip_b, hlcd_b.frame));
+
+    //and the other way round, a chain of B delays a blocking update of A
+    LCDx_fill_rect(&hlcd_a, 40, 8, 30, 20, LCD_DRAW_XOR);
+    LCDx_fill_rect(&hlcd_b, 10, 20, 30, 20, LCD_DRAW_XOR);
+    CHECK_EQUAL(LCDx_update_async(&hlcd_b), HAL_OK);
+    LCDx_update(&hlcd_a);
+    CHECK_EQUAL(hal_stub_dma_finish(&hspi1), 0);
+    hal_stub.dma_polls = 0;
+#else
+    LCDx_update(&hlcd_a);
+    LCDx_update(&hlcd_b);
+#endif
+    CHECK(harness_ram_is(chip_a, hlcd_a.frame));
+    CHECK(harness_ram_is(chip_b, hlcd_b.frame));
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+}
+
+static void scenario_busy(void) {
+    //HAL_BUSY is not a lost frame, transfer is retried
+    LCDx_draw_line(&hlcd_a, 0, 47, 83, 10, LCD_DRAW_XOR);
+    hal_stub.fail_count  = 2;
+    hal_stub.fail_status = HAL_BUSY;
+    LCDx_update(&hlcd_a);
+    CHECK_EQUAL(hal_stub.fail_count, 0);
+    CHECK(!hlcd_a.bus_error);
+    CHECK(harness_ram_is(chip_a, hlcd_a.frame));
+}
+
+static void scenario_error(void) {
+    //a failed data transfer of a vertical update leaves panel in vertical mode and RAM stale
+    LCDx_invert(&hlcd_a, 1);
+    LCDx_update(&hlcd_a);
+    for (int16_t y = 0; y < 48; y += 8)
+        LCDx_fill_rect(&hlcd_a, 30, y, 2, 3, LCD_DRAW_XOR);
+    fail_next_data = 1;
+    LCDx_update(&hlcd_a);
+    CHECK(hlcd_a.bus_error);
+    CHECK(chip_a->emulator.vertical);
+    CHECK(!harness_ram_is(chip_a, hlcd_a.frame));
+
+    //next update puts panel back in horizontal mode and resends whole frame and display mode
+    HarnessTraffic mark = harness_traffic_mark(chip_a);
+    LCDx_update(&hlcd_a);
+    harness_report(TEST_NAME, "recovery", harness_traffic_since(chip_a, mark));
+    CHECK(!hlcd_a.bus_error);
+    CHECK(harness_ram_is(chip_a, hlcd_a.frame));
+    CHECK_EQUAL(chip_a->emulator.display, LCD_EMU_DISPLAY_INVERTED);
+    CHECK(!chip_a->emulator.power_down);
+
+    //and carries on with small updates in a known mode
+    uint8_t *frame = hlcd_a.frame;
+    frame[2 * LCD_WIDTH_IN_CHUNK + 70] ^= 0x3c;
+    LCDx_mark_dirty(&hlcd_a, 70, 2, 1, 1);
+    LCDx_update(&hlcd_a);
+    CHECK(harness_ram_is(chip_a, hlcd_a.frame));
+    CHECK(harness_ram_is(chip_b, hlcd_b.frame));
+}
+
+int main(void) {
+    hal_stub_reset();
+    chip_a = hal_stub_add_chip(&hlcd_a);
+    chip_b = hal_stub_add_chip(&hlcd_b);
+    hal_stub.on_transmit = on_transmit;
+    initializeDWTtimer();
+    LCDx_Init(&hlcd_a, 60);
+    LCDx_Init(&hlcd_b, 60);
+
+    scenario_interleaved();
+    scenario_busy();
+    scenario_error();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
@@ -0,0 +1,180 @@
+/**
+ *  @file test_stream.c
+ *  @brief streamed images - LCD RAM after LCD_stream_compressed_image is byte for byte what decompress_into_buffer
+ *         writes into a copy of the frame
+ *
+ *  Images of many sizes and densities, plain and inverted, are placed all over the panel, also partly outside it so
+ *  that placement and clipping are compared too. The panel holds a pattern before each image, so a byte written
+ *  where it should not be shows up.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+
+#define TEST_NAME                               "stream"
+
+static HAL_StubChip *chip;
+static uint8_t      pattern[LCD_BUFFER_SIZE];
+static uint8_t      fail_next_data;
+
+/**
+ * @brief lets the command transaction of an update through and fails the data after it
+ */
+static void on_transmit(SPI_HandleTypeDef *hspi, uint8_t is_data, const uint8_t *data, uint16_t length) {
+    if (fail_next_data && !is_data) {
+        fail_next_data       = 0;
+        hal_stub.fail_count  = 1;
+        hal_stub.fail_status = HAL_ERROR;
+    }
+}
+
+static void show(void) {
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+/**
+ * @brief streams an image onto the pattern and compares RAM with decompress_into_buffer on a copy of it
+ * @param image width * height chunks
+ * @param width width in chunks
+ * @param height height in banks
+ * @param inverted 1 if blank chunks are 0xff
+ * @param x x in chunks
+ * @param y y in banks
+ * @return 1 if they match
+ */
+static int compare(const uint8_t *image, uint16_t width, uint16_t height, uint8_t inverted, uint16_t x, uint16_t y) {
+    static uint8_t compressed[4 + 100 * 8 * 3 / 2];
+    static uint8_t expected[LCD_BUFFER_SIZE];
+    uint32_t       length = harness_encode(image, width, height, inverted, compressed);
+
+    memcpy(LCD_get_frame(), pattern, LCD_BUFFER_SIZE);
+    LCD_mark_dirty(0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    show();
+    memcpy(expected, pattern, LCD_BUFFER_SIZE);
+    decompress_into_buffer(compressed, expected, x, y);
+
+    CHECK_EQUAL(LCD_stream_compressed_image(compressed, length, x, y), HAL_OK);
+    //frame is left as it was
+    CHECK(memcmp(LCD_get_frame(), pattern, LCD_BUFFER_SIZE) == 0);
+    return CHECK(harness_ram_is(chip, expected));
+}
+
+static void scenario_random(void) {
+    static uint8_t image[100 * 8];
+    harness_seed(0x5eedu);
+    for (uint16_t n = 0; n < 200; n++) {
+        uint16_t width    = (uint16_t) (1 + harness_random() % 100);
+        uint16_t height   = (uint16_t) (1 + harness_random() % 8);
+        uint8_t  inverted = n % 4 == 3;
+        uint32_t density  = harness_random() % 9;
+        for (uint32_t i = 0; i < (uint32_t) width * height; i++)
+            image[i] = harness_random() % 8 < density ? (uint8_t) harness_random() : (inverted ? 0xff : 0);
+        if (!compare(image, width, height, inverted, (uint16_t) (harness_random() % 90),
+                     (uint16_t) (harness_random() % 8)))
+            return;
+    }
+}
+
+static void scenario_edges(void) {
+    //full screen, full-width rows sharing one address, a column and a byte at each corner
+    static uint8_t image[LCD_BUFFER_SIZE];
+    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+        image[i] = (uint8_t) (i * 13 + 1);
+    compare(image, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK, 0, 0, 0);
+    compare(image, LCD_WIDTH_IN_CHUNK, 3, 0, 0, 2);
+    compare(image, 1, LCD_HEIGHT_IN_CHUNK, 1, 83, 0);
+    compare(image, 1, 1, 0, 0, 0);
+    compare(image, 1, 1, 0, 83, 5);
+    compare(image, 2, 2, 0, 200, 200);
+}
+
+static void scenario_vertical(void) {
+    //a vertical update leaves panel in vertical mode, the stream must put it back
+    memcpy(LCD_get_frame(), pattern, LCD_BUFFER_SIZE);
+    LCD_mark_dirty(0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    show();
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        LCD_get_frame()[bank * LCD_WIDTH_IN_CHUNK + 9] ^= 0xff;
+    LCD_mark_dirty(9, 0, 1, LCD_HEIGHT_IN_CHUNK);
+    //blocking update also in DMA builds, chains are sent horizontally
+    LCD_update();
+    CHECK(chip->emulator.vertical);
+    memcpy(pattern, LCD_get_frame(), LCD_BUFFER_SIZE);
+
+    static const uint8_t image[3 * 2] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    compare(image, 3, 2, 0, 40, 1);
+    CHECK(!chip->emulator.vertical);
+}
+
+static void scenario_bus_error(void) {
+    //a failed vertical update leaves panel in vertical mode, RAM stale and the error to recover from
+    memcpy(LCD_get_frame(), pattern, LCD_BUFFER_SIZE);
+    LCD_mark_dirty(0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+    show();
+    for (uint8_t bank = 0; bank < LCD_HEIGHT_IN_CHUNK; bank++)
+        LCD_get_frame()[bank * LCD_WIDTH_IN_CHUNK + 20] ^= 0xff;
+    LCD_mark_dirty(20, 0, 1, LCD_HEIGHT_IN_CHUNK);
+    hal_stub.on_transmit = on_transmit;
+    fail_next_data       = 1;
+    LCD_update();
+    hal_stub.on_transmit = 0;
+    CHECK(hlcd1.bus_error);
+    CHECK(chip->emulator.vertical);
+
+    //stream recovers first, its bytes land in place and the next update resends the whole frame
+    static const uint8_t image[2 * 2] = {0x81, 0x42, 0x24, 0x18};
+    uint8_t              compressed[16];
+    uint32_t             length = harness_encode(image, 2, 2, 0, compressed);
+    CHECK_EQUAL(LCD_stream_compressed_image(compressed, length, 50, 3), HAL_OK);
+    CHECK(!hlcd1.bus_error);
+    CHECK(!chip->emulator.vertical);
+    CHECK_EQUAL(chip->emulator.ram[3][50], 0x81);
+    CHECK_EQUAL(chip->emulator.ram[4][51], 0x18);
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    LCD_update();
+    CHECK(harness_traffic_since(chip, mark).bytes >= LCD_BUFFER_SIZE);
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+}
+
+static void scenario_stats(void) {
+#ifdef LCD_USE_BUS_STATS
+    //a streamed image adds to the totals but is not a frame
+    static const uint8_t image[4 * 2] = {1, 2, 3, 4, 5, 6, 7, 8};
+    LCD_BusStats         before;
+    LCD_BusStats         after;
+    uint8_t              compressed[32];
+    uint32_t             length = harness_encode(image, 4, 2, 0, compressed);
+    LCD_get_bus_stats(&before);
+    HarnessTraffic mark = harness_traffic_mark(chip);
+    CHECK_EQUAL(LCD_stream_compressed_image(compressed, length, 10, 2), HAL_OK);
+    HarnessTraffic traffic = harness_traffic_since(chip, mark);
+    LCD_get_bus_stats(&after);
+    CHECK_EQUAL(after.frames, before.frames);
+    CHECK_EQUAL(after.last_frame_bytes, before.last_frame_bytes);
+    CHECK_EQUAL(after.bytes - before.bytes, traffic.bytes);
+    CHECK_EQUAL(after.transactions - before.transactions, traffic.transactions);
+#endif
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+        pattern[i] = (uint8_t) (0xa5 ^ (i * 29));
+
+    scenario_random();
+    scenario_edges();
+    scenario_vertical();
+    scenario_bus_error();
+    scenario_stats();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
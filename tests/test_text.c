@@ -0,0 +1,125 @@
+/**
+ *  @file test_text.c
+ *  @brief 8x6 text at any pixel position - LCD_draw_char and LCD_draw_string against a per-pixel model
+ *
+ *  The model draws each glyph pixel by pixel from the font as LCD_write_char_8x6 puts it into a bank, so it does not
+ *  share the shifted column path under test. Random strings in every mode, at any pixel Y and clipped at every edge,
+ *  must leave the frame equal to the model. The preshift build runs the same with LCD_USE_PRESHIFTED_FONT.
+ */
+
+#include <string.h>
+#include "harness.h"
+#include "lcd_5110_gfx.h"
+
+#define TEST_NAME                               "text"
+
+static HAL_StubChip *chip;
+static uint8_t      glyphs[256][6];
+static uint8_t      model[LCD_BUFFER_SIZE];
+
+static void show(void) {
+#ifdef LCD_USE_DMA
+    CHECK_EQUAL(LCD_update_async(), HAL_OK);
+    hal_stub_dma_finish(&hspi1);
+    CHECK(!LCD_is_busy());
+#else
+    LCD_update();
+#endif
+}
+
+/**
+ * @brief draws a character into the model, one pixel at a time
+ */
+static void model_char(int16_t x, int16_t y, uint8_t chr, LCD_DrawMode mode) {
+    for (int16_t column = 0; column < 6; column++)
+        for (int16_t row = 0; row < 8; row++) {
+            int16_t px = (int16_t) (x + column);
+            int16_t py = (int16_t) (y + row);
+            if (px < 0 || px >= LCD_WIDTH_IN_PIXEL || py < 0 || py >= LCD_HEIGHT_IN_PIXEL)
+                continue;
+            uint8_t *byte = &model[(py / 8) * LCD_WIDTH_IN_CHUNK + px];
+            uint8_t bit   = (uint8_t) (1 << (py % 8));
+            uint8_t on    = (glyphs[chr][column] >> row) & 1;
+            if (mode == LCD_DRAW_COPY)
+                *byte = (uint8_t) (on ? *byte | bit : *byte & ~bit);
+            else if (on && mode == LCD_DRAW_SET)
+                *byte |= bit;
+            else if (on && mode == LCD_DRAW_CLEAR)
+                *byte &= (uint8_t) ~bit;
+            else if (on)
+                *byte ^= bit;
+        }
+}
+
+static void scenario_random(void) {
+    harness_seed(0x7e47);
+    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+        model[i] = (uint8_t) harness_random();
+    memcpy(LCD_get_frame(), model, LCD_BUFFER_SIZE);
+    LCD_mark_dirty(0, 0, LCD_WIDTH_IN_CHUNK, LCD_HEIGHT_IN_CHUNK);
+
+    for (uint16_t n = 0; n < 3000; n++) {
+        char         str[8];
+        uint8_t      length = (uint8_t) (1 + harness_random() % 7);
+        int16_t      x      = (int16_t) (harness_random() % 130) - 40;
+        int16_t      y      = (int16_t) (harness_random() % 64) - 10;
+        LCD_DrawMode mode   = (LCD_DrawMode) (harness_random() % 4);
+        //also bytes outside the font, drawn as ' '
+        for (uint8_t i = 0; i < length; i++)
+            str[i] = (char) (0x10 + harness_random() % 0x80);
+        str[length] = 0;
+
+        int16_t end = x;
+        for (uint8_t i = 0; i < length && end < LCD_WIDTH_IN_PIXEL; i++, end = (int16_t) (end + 6))
+            model_char(end, y, (uint8_t) str[i], mode);
+        CHECK_EQUAL(LCD_draw_string(x, y, str, mode), end);
+        if (!CHECK(memcmp(LCD_get_frame(), model, LCD_BUFFER_SIZE) == 0))
+            return;
+        //marked area covers what was drawn
+        if (n % 16 == 0) {
+            show();
+            if (!CHECK(harness_ram_is(chip, model)))
+                return;
+        }
+    }
+}
+
+static void scenario_aligned(void) {
+    //a bank-aligned copy string is what LCD_write_string writes
+    static uint8_t written[LCD_BUFFER_SIZE];
+    LCD_clear();
+    LCD_goto_x_y_char_8x6(2, 3);
+    LCD_write_string("Hello, 5110!");
+    memcpy(written, LCD_get_frame(), LCD_BUFFER_SIZE);
+    memset(LCD_get_frame(), 0xff, LCD_BUFFER_SIZE);
+    LCD_draw_string(12, 24, "Hello, 5110!", LCD_DRAW_COPY);
+    for (uint16_t i = 0; i < LCD_BUFFER_SIZE; i++)
+        if (i / LCD_WIDTH_IN_CHUNK == 3 && i % LCD_WIDTH_IN_CHUNK >= 12)
+            CHECK_EQUAL(LCD_get_frame()[i], written[i]);
+    show();
+    CHECK(harness_ram_is(chip, LCD_get_frame()));
+
+    //a ticker scrolls in from the left one pixel at a time, whole characters left of LCD cost nothing
+    for (int16_t x = -30; x <= 0; x++) {
+        LCD_fill_rect(0, 40, 84, 8, LCD_DRAW_CLEAR);
+        CHECK_EQUAL(LCD_draw_string(x, 40, "ticker", LCD_DRAW_SET), x + 36);
+    }
+    CHECK(LCD_get_pixel(1, 42) == ((glyphs['t'][1] >> 2) & 1));
+}
+
+int main(void) {
+    chip = harness_start(&hlcd1);
+    //font as the core writes it into a bank
+    for (uint16_t chr = 0; chr < 256; chr++) {
+        LCD_goto_x_y_char_8x6(0, 0);
+        LCD_write_char_8x6((uint8_t) chr);
+        memcpy(glyphs[chr], LCD_get_frame(), 6);
+    }
+    LCD_clear();
+
+    scenario_random();
+    scenario_aligned();
+    CHECK_EQUAL(hal_stub.ce_conflicts, 0);
+    CHECK_EQUAL(hal_stub.pin_glitches, 0);
+    return harness_done(TEST_NAME);
+}
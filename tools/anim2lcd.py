@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Encode a sequence of 84x48 frames into a delta-frame animation for the LCD 5110 driver.
+
+Writes <name>.c and <name>.h. Each frame only holds the bytes that differ from the previous frame, XORed, as
+(bank, x, length, bytes) records; see lcd_5110_anim.h for the format. Frames are PBM images (P1 or P4) or
+504-byte raw dumps of the LCD buffer. Records in a bank closer than a record header are merged.
+
+usage: anim2lcd.py name frame0.pbm frame1.pbm ... [--delay 100] [--loop] [--out dir]
+"""
+
+import argparse
+import os
+import sys
+
+WIDTH, BANKS = 84, 6
+HEADER = 3  # bank, x, length
+END_OF_FRAME = 0xFF
+
+
+def read_pbm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, tokens, index = data[:2], [], 2
+    while len(tokens) < 2:
+        while data[index:index + 1].isspace():
+            index += 1
+        if data[index:index + 1] == b"#":
+            index = data.index(b"\n", index)
+            continue
+        start = index
+        while not data[index:index + 1].isspace():
+            index += 1
+        tokens.append(int(data[start:index]))
+    width, height = tokens
+    if (width, height) != (WIDTH, BANKS * 8):
+        sys.exit("%s: %dx%d, frames must be %dx%d" % (path, width, height, WIDTH, BANKS * 8))
+    if magic == b"P4":
+        row_bytes = (width + 7) // 8
+        bits = data[index + 1:]
+        pixel = lambda x, y: bits[y * row_bytes + x // 8] >> (7 - x % 8) & 1
+    elif magic == b"P1":
+        bits = [c for c in data[index:].decode() if c in "01"]
+        pixel = lambda x, y: int(bits[y * width + x])
+    else:
+        sys.exit("%s: not a PBM image" % path)
+    frame = bytearray(WIDTH * BANKS)
+    for y in range(height):
+        for x in range(width):
+            if pixel(x, y):
+                frame[y // 8 * WIDTH + x] |= 1 << (y % 8)
+    return frame
+
+
+def read_frame(path):
+    if path.lower().endswith(".pbm"):
+        return read_pbm(path)
+    with open(path, "rb") as f:
+        frame = bytearray(f.read())
+    if len(frame) != WIDTH * BANKS:
+        sys.exit("%s: raw frames are %d bytes" % (path, WIDTH * BANKS))
+    return frame
+
+
+def encode_delta(previous, frame, delay):
+    """returns frame bytes taking `previous` to `frame`"""
+    out = bytearray([delay])
+    for bank in range(BANKS):
+        delta = [previous[bank * WIDTH + x] ^ frame[bank * WIDTH + x] for x in range(WIDTH)]
+        runs = []
+        for x in range(WIDTH):
+            if not delta[x]:
+                continue
+            # a gap no longer than a record header is cheaper sent than split
+            if runs and x - runs[-1][1] <= HEADER:
+                runs[-1][1] = x + 1
+            else:
+                runs.append([x, x + 1])
+        for low, high in runs:
+            out += bytes([bank, low, high - low]) + bytes(delta[low:high])
+    out.append(END_OF_FRAME)
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("name", help="C name of animation array")
+    parser.add_argument("frames", nargs="+")
+    parser.add_argument("--delay", type=int, default=100, help="ms each frame stays, in 10 ms steps (default 100)")
+    parser.add_argument("--loop", action="store_true", help="go on with first frame after last one")
+    parser.add_argument("--out", default=".", help="output directory")
+    args = parser.parse_args()
+
+    delay = args.delay // 10
+    if not 0 <= delay <= 255:
+        sys.exit("delay must be 0 to 2550 ms")
+    frames = [read_frame(path) for path in args.frames]
+    if len(frames) > 0xffff:
+        sys.exit("too many frames")
+
+    data = bytearray([1 if args.loop else 0, len(frames) & 0xff, len(frames) >> 8])
+    previous = bytearray(WIDTH * BANKS)
+    for frame in frames:
+        data += encode_delta(previous, frame, delay)
+        previous = frame
+    if args.loop and len(frames) > 1:
+        data += encode_delta(previous, frames[0], delay)
+
+    name = args.name
+    header = os.path.join(args.out, name + ".h")
+    source = os.path.join(args.out, name + ".c")
+    guard = name.upper() + "_H"
+    with open(header, "w") as f:
+        f.write("/**\n *  @file %s.h\n *  @brief %s, generated by tools/anim2lcd.py\n */\n\n" % (name, name))
+        f.write("#ifndef %s\n#define %s\n\n#include <stdint.h>\n\n" % (guard, guard))
+        f.write("//!%d frames, play with LCD_animation_open(&animation, %s, sizeof(%s))\n" % (len(frames), name, name))
+        f.write("extern const uint8_t %s[%d];\n\n#endif\n" % (name, len(data)))
+    with open(source, "w") as f:
+        f.write("/**\n *  @file %s.c\n *  @brief %s, generated by tools/anim2lcd.py - do not edit\n */\n\n"
+                % (name, name))
+        f.write("#include \"%s.h\"\n\n" % name)
+        f.write("const uint8_t %s[%d] = {\n" % (name, len(data)))
+        for i in range(0, len(data), 12):
+            f.write("        " + ", ".join("0x%02x" % b for b in data[i:i + 12]) + ",\n")
+        f.write("};\n")
+    print("%s: %d frames in %d bytes, %d bytes as full frames" % (name, len(frames), len(data), len(frames) * WIDTH * BANKS))
+
+
+if __name__ == "__main__":
+    main()
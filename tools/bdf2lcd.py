@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""Convert a BDF bitmap font into an LCD_Font for the LCD 5110 driver.
+
+Writes <name>.c and <name>.h. Glyphs are stored like the LCD buffer: (height + 7) / 8 bands of
+8-pixel-tall column bytes, LSB on top. Code points are grouped into runs of consecutive code points,
+which the driver searches by bisection.
+
+usage: bdf2lcd.py font.bdf name [--range 0x20-0x7e] [--range 0x600-0x6ff] [--fallback 0x3f] [--out dir]
+"""
+
+import argparse
+import os
+import sys
+
+
+def parse_bdf(path):
+    ascent = descent = None
+    box = None
+    glyphs = {}
+    with open(path, encoding="latin-1") as f:
+        lines = iter(f.read().splitlines())
+    for line in lines:
+        words = line.split()
+        if not words:
+            continue
+        if words[0] == "FONTBOUNDINGBOX":
+            box = [int(v) for v in words[1:5]]
+        elif words[0] == "FONT_ASCENT":
+            ascent = int(words[1])
+        elif words[0] == "FONT_DESCENT":
+            descent = int(words[1])
+        elif words[0] == "STARTCHAR":
+            encoding, advance, bbx, rows = -1, None, None, []
+            for line in lines:
+                words = line.split()
+                if not words:
+                    continue
+                if words[0] == "ENCODING":
+                    encoding = int(words[1])
+                elif words[0] == "DWIDTH":
+                    advance = int(words[1])
+                elif words[0] == "BBX":
+                    bbx = [int(v) for v in words[1:5]]
+                elif words[0] == "BITMAP":
+                    for line in lines:
+                        if line.strip() == "ENDCHAR":
+                            break
+                        rows.append(int(line.strip(), 16) if line.strip() else 0)
+                    break
+            if encoding >= 0 and bbx is not None:
+                if advance is None:
+                    advance = bbx[0] + bbx[2]
+                glyphs[encoding] = (advance, bbx, rows)
+    if box is None:
+        sys.exit("%s: no FONTBOUNDINGBOX" % path)
+    if ascent is None or descent is None:
+        ascent, descent = box[1] + box[3], -box[3]
+    return ascent, descent, glyphs
+
+
+def render(glyph, ascent, height):
+    """returns (columns, advance) - columns is a list of `height`-bit integers, bit 0 on top"""
+    advance, (w, h, x_offset, y_offset), rows = glyph
+    row_bits = ((w + 7) // 8) * 8
+    width = max(0, x_offset + w)
+    columns = [0] * width
+    top = ascent - (y_offset + h)
+    for r, bits in enumerate(rows[:h]):
+        y = top + r
+        if not 0 <= y < height:
+            continue
+        for c in range(w):
+            x = x_offset + c
+            if x >= 0 and bits >> (row_bits - 1 - c) & 1:
+                columns[x] |= 1 << y
+    return columns, advance
+
+
+def parse_ranges(texts):
+    ranges = []
+    for text in texts:
+        low, _, high = text.partition("-")
+        ranges.append((int(low, 0), int(high or low, 0)))
+    return ranges
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("bdf")
+    parser.add_argument("name", help="C name of LCD_Font")
+    parser.add_argument("--range", action="append", default=[], help="code points to keep, e.g. 0x20-0x7e")
+    parser.add_argument("--fallback", type=lambda v: int(v, 0), default=ord("?"),
+                        help="code point drawn for missing ones (default '?')")
+    parser.add_argument("--out", default=".", help="output directory")
+    args = parser.parse_args()
+
+    ascent, descent, glyphs = parse_bdf(args.bdf)
+    height = ascent + descent
+    if not 0 < height <= 48:
+        sys.exit("font height %d does not fit LCD" % height)
+    keep = parse_ranges(args.range)
+    code_points = sorted(cp for cp in glyphs if not keep or any(low <= cp <= high for low, high in keep))
+    if not code_points:
+        sys.exit("no glyphs selected")
+
+    bands = (height + 7) // 8
+    bitmaps, table, runs = [], [], []
+    for index, cp in enumerate(code_points):
+        columns, advance = render(glyphs[cp], ascent, height)
+        if len(columns) > 255 or not 0 <= advance <= 255:
+            sys.exit("glyph U+%04X is too wide" % cp)
+        table.append((len(bitmaps), len(columns), advance, cp))
+        for band in range(bands):
+            bitmaps.extend((column >> (8 * band)) & 0xff for column in columns)
+        if runs and runs[-1][0] + runs[-1][1] == cp:
+            runs[-1][1] += 1
+        else:
+            runs.append([cp, 1, index])
+    if len(bitmaps) > 0xffff:
+        sys.exit("font needs %d bytes, LCD_Glyph offsets are 16-bit" % len(bitmaps))
+    fallback = code_points.index(args.fallback) if args.fallback in code_points else 0
+
+    name = args.name
+    header = os.path.join(args.out, name + ".h")
+    source = os.path.join(args.out, name + ".c")
+    guard = name.upper() + "_H"
+    with open(header, "w") as f:
+        f.write("/**\n *  @file %s.h\n *  @brief %s, generated by tools/bdf2lcd.py from %s\n */\n\n"
+                % (name, name, os.path.basename(args.bdf)))
+        f.write("#ifndef %s\n#define %s\n\n#include \"lcd_5110_text.h\"\n\n" % (guard, guard))
+        f.write("//!%d glyphs, %d pixels tall\nextern const LCD_Font %s;\n\n#endif\n" % (len(table), height, name))
+    with open(source, "w") as f:
+        f.write("/**\n *  @file %s.c\n *  @brief %s, generated by tools/bdf2lcd.py from %s - do not edit\n */\n\n"
+                % (name, name, os.path.basename(args.bdf)))
+        f.write("#include \"%s.h\"\n\n" % name)
+        f.write("const uint8_t %s_bitmaps[%d] = {\n" % (name, len(bitmaps)))
+        for i in range(0, len(bitmaps), 12):
+            f.write("        " + ", ".join("0x%02x" % b for b in bitmaps[i:i + 12]) + ",\n")
+        f.write("};\n\nconst LCD_Glyph %s_glyphs[%d] = {\n" % (name, len(table)))
+        for offset, width, advance, cp in table:
+            f.write("        {%d, %d, %d},//U+%04X\n" % (offset, width, advance, cp))
+        f.write("};\n\nconst LCD_FontRange %s_ranges[%d] = {\n" % (name, len(runs)))
+        for first, count, glyph in runs:
+            f.write("        {0x%04X, %d, %d},\n" % (first, count, glyph))
+        f.write("};\n\nconst LCD_Font %s = {\n" % name)
+        f.write("        .bitmaps     = %s_bitmaps,\n" % name)
+        f.write("        .glyphs      = %s_glyphs,\n" % name)
+        f.write("        .ranges      = %s_ranges,\n" % name)
+        f.write("        .range_count = %d,\n" % len(runs))
+        f.write("        .fallback    = %d,\n" % fallback)
+        f.write("        .height      = %d,\n" % height)
+        f.write("};\n")
+    print("%s: %d glyphs in %d runs, %d pixels tall, %d bytes of bitmaps"
+          % (name, len(table), len(runs), height, len(bitmaps)))
+
+
+if __name__ == "__main__":
+    main()
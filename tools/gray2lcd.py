@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Convert an 84x48 grayscale image into bit-planes for temporal dithering on the LCD 5110 driver.
+
+Writes <name>.c and <name>.h. The image is dithered to planes + 1 darkness levels, by a 4x4 Bayer matrix or by
+Floyd-Steinberg error diffusion, and a pixel of level l is dark in l of the planes. Which planes those are turns
+with x + y, so a flat gray area never switches on or off as a whole. Planes are 504-byte frames in LCD buffer
+layout; cycle them with LCD_gray_start and LCD_gray_next. The image is a PGM (P2 or P5, 0 is black) or a
+4032-byte raw dump of 8-bit pixels, row by row.
+
+usage: gray2lcd.py name image.pgm [--planes 3] [--dither diffusion|ordered] [--out dir]
+"""
+
+import argparse
+import os
+import sys
+
+WIDTH, BANKS = 84, 6
+HEIGHT = BANKS * 8
+BAYER = [[0, 8, 2, 10], [12, 4, 14, 6], [3, 11, 1, 9], [15, 7, 13, 5]]
+
+
+def read_pgm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, tokens, index = data[:2], [], 2
+    while len(tokens) < 3:
+        while data[index:index + 1].isspace():
+            index += 1
+        if data[index:index + 1] == b"#":
+            index = data.index(b"\n", index)
+            continue
+        start = index
+        while not data[index:index + 1].isspace():
+            index += 1
+        tokens.append(int(data[start:index]))
+    width, height, maxval = tokens
+    if (width, height) != (WIDTH, HEIGHT):
+        sys.exit("%s: %dx%d, images must be %dx%d" % (path, width, height, WIDTH, HEIGHT))
+    if not 0 < maxval < 256:
+        sys.exit("%s: only 8-bit PGM images are supported" % path)
+    if magic == b"P5":
+        values = data[index + 1:index + 1 + width * height]
+    elif magic == b"P2":
+        values = [int(token) for token in data[index:].split()[:width * height]]
+    else:
+        sys.exit("%s: not a PGM image" % path)
+    if len(values) != width * height:
+        sys.exit("%s: image is truncated" % path)
+    return [value * 255 // maxval for value in values]
+
+
+def read_image(path):
+    if path.lower().endswith(".pgm"):
+        return read_pgm(path)
+    with open(path, "rb") as f:
+        values = f.read()
+    if len(values) != WIDTH * HEIGHT:
+        sys.exit("%s: raw images are %d bytes" % (path, WIDTH * HEIGHT))
+    return list(values)
+
+
+def dither(image, levels, method):
+    """returns darkness level 0..levels of each pixel"""
+    darkness = [(255 - value) * levels / 255.0 for value in image]
+    out = [0] * (WIDTH * HEIGHT)
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            i = y * WIDTH + x
+            if method == "ordered":
+                level = int(darkness[i] + (BAYER[y % 4][x % 4] + 0.5) / 16)
+            else:
+                level = int(darkness[i] + 0.5)
+            level = max(0, min(levels, level))
+            out[i] = level
+            if method == "ordered":
+                continue
+            error = darkness[i] - level
+            for dx, dy, weight in ((1, 0, 7), (-1, 1, 3), (0, 1, 5), (1, 1, 1)):
+                if 0 <= x + dx < WIDTH and y + dy < HEIGHT:
+                    darkness[i + dy * WIDTH + dx] += error * weight / 16
+    return out
+
+
+def make_planes(levels, count):
+    planes = [bytearray(WIDTH * BANKS) for _ in range(count)]
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            level = levels[y * WIDTH + x]
+            for plane in range(count):
+                if (plane - x - y) % count < level:
+                    planes[plane][y // 8 * WIDTH + x] |= 1 << (y % 8)
+    return planes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("name", help="C name of plane array")
+    parser.add_argument("image")
+    parser.add_argument("--planes", type=int, default=3, help="bit-planes, gives planes + 1 gray levels (default 3)")
+    parser.add_argument("--dither", choices=("diffusion", "ordered"), default="diffusion",
+                        help="Floyd-Steinberg error diffusion or 4x4 Bayer matrix (default diffusion)")
+    parser.add_argument("--out", default=".", help="output directory")
+    args = parser.parse_args()
+
+    if not 1 <= args.planes <= 8:
+        sys.exit("planes must be 1 to 8")
+    planes = make_planes(dither(read_image(args.image), args.planes, args.dither), args.planes)
+    data = b"".join(planes)
+    # bytes a plane change puts on the bus, wrapping from last plane to first
+    changed = sum(sum(1 for a, b in zip(planes[i - 1], planes[i]) if a != b) for i in range(args.planes))
+
+    name = args.name
+    header = os.path.join(args.out, name + ".h")
+    source = os.path.join(args.out, name + ".c")
+    guard = name.upper() + "_H"
+    with open(header, "w") as f:
+        f.write("/**\n *  @file %s.h\n *  @brief %s, generated by tools/gray2lcd.py\n */\n\n" % (name, name))
+        f.write("#ifndef %s\n#define %s\n\n#include <stdint.h>\n\n" % (guard, guard))
+        f.write("//!%d planes, show with LCD_gray_start(&gray, %s, %d)\n" % (args.planes, name, args.planes))
+        f.write("extern const uint8_t %s[%d];\n\n#endif\n" % (name, len(data)))
+    with open(source, "w") as f:
+        f.write("/**\n *  @file %s.c\n *  @brief %s, generated by tools/gray2lcd.py - do not edit\n */\n\n"
+                % (name, name))
+        f.write("#include \"%s.h\"\n\n" % name)
+        f.write("const uint8_t %s[%d] = {\n" % (name, len(data)))
+        for i in range(0, len(data), 12):
+            f.write("        " + ", ".join("0x%02x" % b for b in data[i:i + 12]) + ",\n")
+        f.write("};\n")
+    print("%s: %d planes, %d gray levels, %d of %d bytes change per plane on average"
+          % (name, args.planes, args.planes + 1, changed // args.planes, WIDTH * BANKS))
+
+
+if __name__ == "__main__":
+    main()